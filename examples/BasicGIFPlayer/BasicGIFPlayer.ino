@@ -93,7 +93,8 @@ void setup() {
     // Set pixel callback for direct drawing
     gif.setPixelCallback(pixelCallback, &tft);
     
-    // Load example GIF from memory
+    // Load example GIF from memory; a header written by tools/embed/gifembed
+    // plays in place instead, e.g. gif.loadBundle(exampleBundle)
     GIFError error = gif.loadFromMemory(exampleGIF, sizeof(exampleGIF));
     if (error != GIFError::SUCCESS) {
         Serial.print("Failed to load GIF: ");
@@ -0,0 +1,107 @@
+/**
+ * @file DeviceBenchmark.ino
+ * @brief On-device timing dump for the host regression reporter
+ * @author Deepseek
+ *
+ * Times nextFrame() over an embedded animation for several pixel formats
+ * and output paths and prints one GIFBENCH line per timed run, in the
+ * format gifbench imports. Capture the serial output to a file and compare
+ * device runs on the host:
+ *
+ *   gifbench --import serial.log --json device_baseline.json
+ *   gifbench --import serial.log --baseline device_baseline.json
+ */
+
+#include <ESP32_AnimatedGIF.h>
+
+#define REPEAT  9       // Timed runs per case
+#define PASSES  50      // Animation passes per timed run (one pass is too short for micros())
+
+// GIF decoder
+ESP32_AnimatedGIF gif;
+
+// Example GIF data (16x16, checkerboard keyframe plus a transparent 8x8 delta frame)
+const uint8_t exampleGIF[] PROGMEM = {
+    0x47, 0x49, 0x46, 0x38, 0x39, 0x61, 0x10, 0x00, 0x10, 0x00, 0x81, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00,
+    0xFF, 0x21, 0xFF, 0x0B, 0x4E, 0x45, 0x54, 0x53, 0x43, 0x41, 0x50, 0x45,
+    0x32, 0x2E, 0x30, 0x03, 0x01, 0x00, 0x00, 0x00, 0x21, 0xF9, 0x04, 0x04,
+    0x0A, 0x00, 0x00, 0x00, 0x2C, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x10,
+    0x00, 0x00, 0x02, 0x26, 0x84, 0x11, 0x19, 0x87, 0xCA, 0xBA, 0x0E, 0x7C,
+    0x4E, 0x56, 0x33, 0x2D, 0x4C, 0x94, 0xEB, 0x88, 0x5D, 0x8D, 0x17, 0x92,
+    0x23, 0x78, 0x32, 0x1D, 0x9A, 0x95, 0xAC, 0xD8, 0xA6, 0xDF, 0x1A, 0xD7,
+    0xF0, 0x6D, 0xDA, 0xB9, 0x58, 0x00, 0x00, 0x21, 0xF9, 0x04, 0x05, 0x0A,
+    0x00, 0x00, 0x00, 0x2C, 0x04, 0x00, 0x04, 0x00, 0x08, 0x00, 0x08, 0x00,
+    0x00, 0x02, 0x0D, 0x84, 0x8F, 0x79, 0xC2, 0xBC, 0x2D, 0x5E, 0x93, 0xCE,
+    0xC0, 0xA8, 0x4C, 0x01, 0x00, 0x3B
+};
+
+// Keeps the frame callback work from being optimized away
+volatile uint32_t sinkChecksum = 0;
+
+/**
+ * @brief Frame callback standing in for a display driver
+ */
+void frameSink(void* userData, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* pixels) {
+    sinkChecksum += x + y + width + height + pixels[0];
+}
+
+/**
+ * @brief Time one case and print a GIFBENCH line per timed run
+ */
+void runCase(PixelFormat format, const char* formatName, bool frameOutput) {
+    // Case names follow the host benchmark: file/stage/format/output
+    const char* stage = frameOutput ? "output" : (format == PixelFormat::INDEXED8 ? "compose" : "convert");
+
+    for (int r = 0; r < REPEAT; r++) {
+        gif.begin(format, true);
+        gif.setLoop(false);
+        gif.setFrameCallback(frameOutput ? frameSink : nullptr);
+        if (gif.loadFromMemory(exampleGIF, sizeof(exampleGIF)) != GIFError::SUCCESS) {
+            Serial.printf("%s: load failed\n", formatName);
+            return;
+        }
+
+        uint32_t frames = 0;
+        uint32_t pixels = 0;
+        uint32_t elapsed = 0;
+        for (int pass = 0; pass < PASSES; pass++) {
+            gif.reset();
+            while (true) {
+                uint32_t start = micros();
+                GIFError error = gif.nextFrame(false);
+                elapsed += micros() - start;
+                if (error != GIFError::SUCCESS) break;
+
+                FrameInfo info;
+                gif.getFrameInfo(info);
+                frames++;
+                pixels += info.width * info.height;
+            }
+        }
+
+        Serial.printf("GIFBENCH example/%s/%s/%s %u %u %u\n", stage, formatName,
+                      frameOutput ? "frame" : "none", frames, pixels, elapsed);
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.printf("GIFBENCH-INFO library=%s compiler=GCC %s, %u MHz\n",
+                  ESP32_ANIMATEDGIF_VERSION, __VERSION__, getCpuFrequencyMhz());
+
+    runCase(PixelFormat::RGB565_LE, "RGB565_LE", false);
+    runCase(PixelFormat::RGB565_LE, "RGB565_LE", true);
+    runCase(PixelFormat::RGB888, "RGB888", false);
+    runCase(PixelFormat::INDEXED8, "INDEXED8", false);
+    runCase(PixelFormat::GRAY4, "GRAY4", false);
+    runCase(PixelFormat::MONOCHROME_1BIT, "MONOCHROME_1BIT", true);
+
+    Serial.println("GIFBENCH done");
+}
+
+void loop() {
+    delay(1000);
+}
@@ -6,12 +6,14 @@
  */
 
 #include <ESP32_AnimatedGIF.h>
+#include <ESP32_GIF_IOProfiler.h>
 #include <TFT_eSPI.h>
 #include <SD.h>
 #include <SPI.h>
 
 TFT_eSPI tft;
 ESP32_AnimatedGIF gif;
+ESP32_GIF_IOProfiler ioProfiler;    // Measures SD reads between decoder and sdCardReader
 
 // Pin definitions for SD card
 #define SD_CS_PIN     5
@@ -161,7 +163,8 @@ void setup() {
     gif.setPixelCallback(drawPixelScaled, &tft);
     
     // Load GIF
-    GIFError error = gif.load(sdCardReader, &gifFile);
+    ioProfiler.begin(sdCardReader, &gifFile);
+    GIFError error = gif.load(ESP32_GIF_IOProfiler::read, &ioProfiler);
     if (error != ESP32_AnimatedGIF::GIFError::SUCCESS) {
         Serial.printf("Failed to load GIF: %s\n", 
                      ESP32_AnimatedGIF::getErrorMessage(error));
@@ -185,6 +188,12 @@ void setup() {
         tft.printf("Duration: %ds", info.totalDuration / 1000);
     }
     
+    IOStats io;
+    ioProfiler.endFrame();
+    ioProfiler.getFrameStats(io);
+    Serial.printf("  Load: %u reads, %u seeks, %u us in SD reads\n",
+                  io.calls, io.seeks, (unsigned)io.stallMicros);
+    
     Serial.println("Ready to play GIF from SD card...");
     delay(3000); // Show info for 3 seconds
     tft.fillScreen(TFT_BLACK);
@@ -199,6 +208,7 @@ void loop() {
     
     // Play next frame
     GIFError error = gif.nextFrame(true);
+    ioProfiler.endFrame();
     
     if (error == ESP32_AnimatedGIF::GIFError::SUCCESS) {
         framesPlayed++;
@@ -208,6 +218,12 @@ void loop() {
             uint32_t elapsed = millis() - startTime;
             float fps = framesPlayed * 1000.0 / elapsed;
             
+            // Time blocked on the SD card in the last frame
+            IOStats io;
+            ioProfiler.getFrameStats(io);
+            Serial.printf("%.1f FPS, last frame: %u reads, %u seeks, %u us in SD reads\n",
+                          fps, io.calls, io.seeks, (unsigned)io.stallMicros);
+            
             // Display FPS in corner
             tft.setTextColor(TFT_WHITE, TFT_BLACK);
             tft.setCursor(SCREEN_WIDTH - 60, 10);
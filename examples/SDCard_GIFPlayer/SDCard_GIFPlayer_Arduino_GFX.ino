@@ -67,9 +67,7 @@ bool sdCardReader(void* userData, uint8_t* buffer, uint32_t length, uint32_t pos
 void drawPixelCallback(void* userData, uint16_t x, uint16_t y, uint16_t color) {
     Arduino_GC9A01* display = (Arduino_GC9A01*)userData;
     
-    // Apply gamma correction if needed
-    // color = gammaCorrect(color);
-    
+    // Colors arrive gamma corrected, see setColorCorrection() in setup()
     display->drawPixel(x, y, color);
 }
 
@@ -81,28 +79,6 @@ void frameCallback(void* userData, uint16_t x, uint16_t y, uint16_t width, uint1
     // Currently using pixel-by-pixel for simplicity
 }
 
-/**
- * @brief Apply gamma correction to RGB565 color
- */
-uint16_t gammaCorrect(uint16_t color) {
-    // Simple gamma correction for better color display
-    uint8_t r = (color >> 11) & 0x1F;
-    uint8_t g = (color >> 5) & 0x3F;
-    uint8_t b = color & 0x1F;
-    
-    // Gamma correction table (approximate)
-    static const uint8_t gammaTable[32] = {
-        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
-        16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31
-    };
-    
-    r = gammaTable[r];
-    g = gammaTable[g >> 1] << 1; // Adjust for 6-bit green
-    b = gammaTable[b];
-    
-    return (r << 11) | (g << 5) | b;
-}
-
 /**
  * @brief Setup function
  */
@@ -187,6 +163,12 @@ void setup() {
     // Set display size
     gif.setDisplaySize(SCREEN_WIDTH, SCREEN_HEIGHT);
     
+    // Gamma correction is baked into the palette LUT (no per-pixel cost)
+    ColorCorrection correction;
+    ESP32_GIF_Utils::initColorCorrection(correction);
+    correction.gamma = 2.2f;
+    gif.setColorCorrection(&correction);
+    
     // Set pixel callback for Arduino_GFX
     gif.setPixelCallback(drawPixelCallback, tft);
     
@@ -0,0 +1,148 @@
+/**
+ * @file StreamLoopback.ino
+ * @brief Compressed span stream loopback test over an in-memory pipe
+ * @author Deepseek
+ *
+ * The decoder encodes every frame into the span stream format and writes it
+ * into a ring buffer standing in for a UART / RS-485 link. The receiver side
+ * (ESP32_GIF_StreamDecoder) drains the pipe in small chunks and renders into
+ * a "remote" canvas, which is compared against the pixels the decoder drew
+ * locally. Bytes per frame are reported against raw RGB565.
+ */
+
+#include <ESP32_AnimatedGIF.h>
+
+#define CANVAS_WIDTH  16
+#define CANVAS_HEIGHT 16
+#define PIPE_SIZE     256
+#define UART_CHUNK    16
+
+// GIF decoder (sending side) and stream receiver (remote side)
+ESP32_AnimatedGIF gif;
+ESP32_GIF_StreamDecoder receiver;
+
+// Canvases for the loopback comparison
+uint16_t localCanvas[CANVAS_WIDTH * CANVAS_HEIGHT];
+uint16_t remoteCanvas[CANVAS_WIDTH * CANVAS_HEIGHT];
+
+// In-memory pipe (ring buffer)
+uint8_t pipeBuffer[PIPE_SIZE];
+uint16_t pipeHead = 0;
+uint16_t pipeTail = 0;
+
+// Example GIF data (16x16, checkerboard keyframe plus a transparent 8x8 delta frame)
+const uint8_t exampleGIF[] PROGMEM = {
+    0x47, 0x49, 0x46, 0x38, 0x39, 0x61, 0x10, 0x00, 0x10, 0x00, 0x81, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00,
+    0xFF, 0x21, 0xFF, 0x0B, 0x4E, 0x45, 0x54, 0x53, 0x43, 0x41, 0x50, 0x45,
+    0x32, 0x2E, 0x30, 0x03, 0x01, 0x00, 0x00, 0x00, 0x21, 0xF9, 0x04, 0x04,
+    0x0A, 0x00, 0x00, 0x00, 0x2C, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x10,
+    0x00, 0x00, 0x02, 0x26, 0x84, 0x11, 0x19, 0x87, 0xCA, 0xBA, 0x0E, 0x7C,
+    0x4E, 0x56, 0x33, 0x2D, 0x4C, 0x94, 0xEB, 0x88, 0x5D, 0x8D, 0x17, 0x92,
+    0x23, 0x78, 0x32, 0x1D, 0x9A, 0x95, 0xAC, 0xD8, 0xA6, 0xDF, 0x1A, 0xD7,
+    0xF0, 0x6D, 0xDA, 0xB9, 0x58, 0x00, 0x00, 0x21, 0xF9, 0x04, 0x05, 0x0A,
+    0x00, 0x00, 0x00, 0x2C, 0x04, 0x00, 0x04, 0x00, 0x08, 0x00, 0x08, 0x00,
+    0x00, 0x02, 0x0D, 0x84, 0x8F, 0x79, 0xC2, 0xBC, 0x2D, 0x5E, 0x93, 0xCE,
+    0xC0, 0xA8, 0x4C, 0x01, 0x00, 0x3B
+};
+
+/**
+ * @brief Move pending pipe bytes to the receiver in UART-sized chunks
+ */
+void drainPipe() {
+    uint8_t chunk[UART_CHUNK];
+    while (pipeTail != pipeHead) {
+        uint16_t length = 0;
+        while (pipeTail != pipeHead && length < UART_CHUNK) {
+            chunk[length++] = pipeBuffer[pipeTail];
+            pipeTail = (pipeTail + 1) % PIPE_SIZE;
+        }
+        receiver.feed(chunk, length);
+    }
+}
+
+/**
+ * @brief Stream writer: push encoded bytes into the pipe
+ */
+void pipeWriter(void* userData, const uint8_t* data, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        uint16_t next = (pipeHead + 1) % PIPE_SIZE;
+        if (next == pipeTail) {
+            drainPipe(); // Pipe full, let the receiver catch up
+        }
+        pipeBuffer[pipeHead] = data[i];
+        pipeHead = next;
+    }
+}
+
+/**
+ * @brief Local pixel callback (what a directly attached display would get)
+ */
+void localPixel(void* userData, uint16_t x, uint16_t y, uint16_t color) {
+    localCanvas[y * CANVAS_WIDTH + x] = color;
+}
+
+/**
+ * @brief Remote pixel callback (literal spans)
+ */
+void remotePixel(void* userData, uint16_t x, uint16_t y, uint16_t color) {
+    remoteCanvas[y * CANVAS_WIDTH + x] = color;
+}
+
+/**
+ * @brief Remote run callback (repeated spans)
+ */
+void remoteRun(void* userData, uint16_t x, uint16_t y, uint16_t length, uint16_t color) {
+    for (uint16_t i = 0; i < length; i++) {
+        remoteCanvas[y * CANVAS_WIDTH + x + i] = color;
+    }
+}
+
+/**
+ * @brief Setup function
+ */
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    Serial.println("ESP32_AnimatedGIF Stream Loopback");
+    Serial.println("=================================");
+
+    receiver.setPixelCallback(remotePixel);
+    receiver.setRunCallback(remoteRun);
+
+    gif.begin(PixelFormat::RGB565_LE, true);
+    gif.setPixelCallback(localPixel);
+    gif.setStreamWriter(pipeWriter, nullptr, StreamEncoding::RLE_INDEXED);
+
+    GIFError error = gif.loadFromMemory(exampleGIF, sizeof(exampleGIF));
+    if (error != GIFError::SUCCESS) {
+        Serial.print("Failed to load GIF: ");
+        Serial.println(ESP32_AnimatedGIF::getErrorMessage(error));
+        while (1);
+    }
+}
+
+/**
+ * @brief Main loop
+ */
+void loop() {
+    GIFError error = gif.nextFrame(false);
+    if (error != GIFError::SUCCESS) {
+        gif.reset();
+        return;
+    }
+
+    drainPipe();
+
+    StreamStats stats;
+    gif.getStreamStats(stats);
+
+    bool match = memcmp(localCanvas, remoteCanvas, sizeof(localCanvas)) == 0;
+    Serial.printf("Frame %u: %u bytes (raw RGB565 %u, %.1f%%) %s\n",
+                  receiver.getCurrentFrame(), stats.frameBytes, stats.frameRawBytes,
+                  stats.frameRawBytes ? stats.frameBytes * 100.0f / stats.frameRawBytes : 0.0f,
+                  match ? "OK" : "MISMATCH");
+
+    delay(500);
+}
@@ -9,23 +9,51 @@
  */
 
 #include "ESP32_AnimatedGIF.h"
+#include "ESP32_GIF_LZW.h"
+#include "ESP32_GIF_Prerendered.h"
 #include <algorithm>
+#include <math.h>
+#include <stdlib.h>
 
-// ESP32 specific includes
-#ifdef ESP32_ANIMATEDGIF_ESP_PLATFORM
-  #include <FS.h>
-  #include <SPIFFS.h>
-  #include <SD.h>
-  #ifdef ESP32_ANIMATEDGIF_PSRAM_SUPPORT
-    #include <esp32-hal-psram.h>
-  #endif
+// Decoder statistics, compiled out unless ESP32_ANIMATEDGIF_STATS is defined
+#ifdef ESP32_ANIMATEDGIF_STATS
+  #define GIF_STATS(...) __VA_ARGS__
+#else
+  #define GIF_STATS(...)
 #endif
 
+// Device palette remapping state, allocated only when a device palette is set
+struct DevicePaletteRemap {
+    uint8_t palette[256 * 3];       // Device colors (packed RGB triplets)
+    uint16_t count;                 // Number of device colors (max 255)
+    uint32_t lut[256];              // Device index -> canvas value
+    uint16_t pixelLUT[256];         // Device index -> pixel callback color
+    uint16_t stream565[256];        // Device index -> RGB565
+    
+    // GIF palette -> device index maps, cached for palettes shared by frames
+    uint8_t cacheTable[2][256 * 3]; // Color table each map was built from
+    uint16_t cacheSize[2];
+    bool cacheValid[2];
+    uint8_t cacheNext;
+    uint8_t cacheMap[2][256];
+};
+
+// Color correction state, allocated only when a correction is set
+struct ColorCorrectionState {
+    int16_t matrix[9];              // 3x3 RGB matrix, 256 = 1.0
+    bool identityMatrix;
+    uint8_t brightness;
+    uint8_t gammaCurve[256];        // Gamma curve alone
+    uint8_t curve[256];             // Gamma curve scaled by brightness
+    uint8_t table[256 * 3];         // Corrected copy of the active GIF palette
+};
+
 // Private implementation class
 class ESP32_AnimatedGIF::Impl {
 public:
     Impl() 
         : _data(nullptr)
+        , _ownsData(false)
         , _dataLength(0)
         , _dataPosition(0)
         , _reader(nullptr)
@@ -33,6 +61,20 @@ public:
         , _frameCallback(nullptr)
         , _pixelCallback(nullptr)
         , _callbackData(nullptr)
+        , _frameCallbackData(nullptr)
+        , _paletteCallback(nullptr)
+        , _paletteCallbackData(nullptr)
+        , _paletteFormat(PixelFormat::RGB565_LE)
+        , _paletteEvent(nullptr)
+        , _background(nullptr)
+        , _backgroundCallback(nullptr)
+        , _backgroundData(nullptr)
+        , _maskCallback(nullptr)
+        , _maskCallbackData(nullptr)
+        , _maskEnabled(false)
+        , _pacingCallback(nullptr)
+        , _pacingCallbackData(nullptr)
+        , _pacingTolerance(10000)
         , _currentFrame(0)
         , _totalFrames(0)
         , _loopCount(0)
@@ -42,16 +84,39 @@ public:
         , _displayHeight(0)
         , _pixelFormat(PixelFormat::RGB565_LE)
         , _usePSRAM(true)
+        , _ditherMode(DitherMode::NONE)
+        , _device(nullptr)
+        , _correction(nullptr)
+        , _deviceCube(nullptr)
+        , _diffusionErrors(nullptr)
+        , _remapBuffer(nullptr)
+        , _diffusing(false)
+        , _paletteEventPending(true)
         , _lastError(GIFError::SUCCESS)
         , _decoding(false) {
         resetState();
+        resetStats();
     }
     
     ~Impl() {
         cleanup();
+        
+        if (_paletteEvent) {
+            ESP32_GIF_Utils::freeMemory(_paletteEvent);
+        }
+        
+        freeDevicePalette();
+        
+        if (_correction) {
+            ESP32_GIF_Utils::freeMemory(_correction);
+        }
     }
     
     bool begin(PixelFormat pixelFormat, bool usePSRAM) {
+        if (ESP32_GIF_Utils::bitsPerPixel(pixelFormat) == 0) {
+            _lastError = GIFError::INVALID_PARAMETER;
+            return false;
+        }
         _pixelFormat = pixelFormat;
         _usePSRAM = usePSRAM;
         resetState();
@@ -67,13 +132,15 @@ public:
             return _lastError;
         }
         
-        _data = (uint8_t*)ESP32_GIF_Utils::allocateMemory(length, _usePSRAM);
-        if (!_data) {
+        uint8_t* copy = (uint8_t*)ESP32_GIF_Utils::allocateMemory(length, _usePSRAM);
+        if (!copy) {
             _lastError = GIFError::OUT_OF_MEMORY;
             return _lastError;
         }
         
-        memcpy(_data, data, length);
+        memcpy(copy, data, length);
+        _data = copy;
+        _ownsData = true;
         _dataLength = length;
         _dataPosition = 0;
         
@@ -91,45 +158,270 @@ public:
         _reader = reader;
         _readerData = userData;
         
-        // Read header first
-        uint8_t header[13];
-        if (!readData(header, 13, 0)) {
-            _lastError = GIFError::FILE_NOT_FOUND;
+        return parseHeader();
+    }
+    
+    GIFError loadBundle(const GIFBundle& bundle) {
+        cleanup();
+        
+        if (!bundle.data || bundle.length == 0 || !bundle.frames || bundle.frameCount == 0) {
+            _lastError = GIFError::INVALID_PARAMETER;
             return _lastError;
         }
         
-        // Validate GIF header
-        if (memcmp(header, "GIF89a", 6) != 0 && memcmp(header, "GIF87a", 6) != 0) {
-            _lastError = GIFError::BAD_FILE_FORMAT;
+        // Played in place, the index replaces the frame count scan
+        _data = bundle.data;
+        _ownsData = false;
+        _dataLength = bundle.length;
+        _dataPosition = 0;
+        _bundle = &bundle;
+        
+        return parseHeader();
+    }
+    
+    GIFError loadPrerenderedFromMemory(const uint8_t* data, uint32_t length) {
+        cleanup();
+        
+        if (!data || length == 0) {
+            _lastError = GIFError::INVALID_PARAMETER;
             return _lastError;
         }
         
-        // Parse basic info
-        _canvasWidth = header[6] | (header[7] << 8);
-        _canvasHeight = header[8] | (header[9] << 8);
+        uint8_t* copy = (uint8_t*)ESP32_GIF_Utils::allocateMemory(length, _usePSRAM);
+        if (!copy) {
+            _lastError = GIFError::OUT_OF_MEMORY;
+            return _lastError;
+        }
         
-        if (_canvasWidth > ESP32_ANIMATEDGIF_MAX_WIDTH || _canvasHeight > ESP32_ANIMATEDGIF_MAX_HEIGHT) {
-            _lastError = GIFError::FILE_TOO_WIDE;
+        memcpy(copy, data, length);
+        _data = copy;
+        _ownsData = true;
+        _dataLength = length;
+        _dataPosition = 0;
+        
+        return parsePrerenderedHeader();
+    }
+    
+    GIFError loadPrerendered(DataReader reader, void* userData) {
+        cleanup();
+        
+        if (!reader) {
+            _lastError = GIFError::INVALID_PARAMETER;
             return _lastError;
         }
         
-        uint8_t flags = header[10];
-        _backgroundColor = header[11];
+        _reader = reader;
+        _readerData = userData;
         
-        // Check for global color table
-        if (flags & 0x80) {
-            uint8_t colorTableBits = (flags & 0x07) + 1;
-            _globalColorTableSize = 1 << colorTableBits;
-            _globalColorTable = (uint32_t*)ESP32_GIF_Utils::allocateMemory(
-                _globalColorTableSize * 3, _usePSRAM);
-            
-            if (_globalColorTable) {
-                readData((uint8_t*)_globalColorTable, _globalColorTableSize * 3, 13);
+        return parsePrerenderedHeader();
+    }
+    
+    struct MemorySource {
+        const uint8_t* data;
+        uint32_t length;
+    };
+    
+    static bool readMemory(void* source, uint8_t* buffer, uint32_t length, uint32_t position) {
+        const MemorySource* memory = static_cast<const MemorySource*>(source);
+        if (position > memory->length || length > memory->length - position) return false;
+        memcpy(buffer, memory->data + position, length);
+        return true;
+    }
+    
+    GIFError estimateFromMemory(const uint8_t* data, uint32_t length, GIFEstimate& estimate,
+                                const GIFCalibration* calibration) {
+        if (!data || length == 0) {
+            return GIFError::INVALID_PARAMETER;
+        }
+        MemorySource source = { data, length };
+        GIFError error = estimateLayout(readMemory, &source, estimate, calibration);
+        if (error == GIFError::SUCCESS) {
+            estimate.memoryFromMemory = estimate.memoryFromReader + length;
+        }
+        return error;
+    }
+    
+    GIFError estimateLayout(DataReader reader, void* userData, GIFEstimate& estimate,
+                            const GIFCalibration* calibration) {
+        // Walks the block structure like countFrames() on a private reader,
+        // so the loaded GIF keeps its position and buffers
+        memset(&estimate, 0, sizeof(estimate));
+        if (!reader) {
+            return GIFError::INVALID_PARAMETER;
+        }
+        
+        uint8_t block[16];
+        if (!reader(userData, block, 13, 0)) {
+            return GIFError::FILE_NOT_FOUND;
+        }
+        if (memcmp(block, "GIF89a", 6) != 0 && memcmp(block, "GIF87a", 6) != 0) {
+            return GIFError::BAD_FILE_FORMAT;
+        }
+        
+        uint16_t width = block[6] | (block[7] << 8);
+        uint16_t height = block[8] | (block[9] << 8);
+        if (width > ESP32_ANIMATEDGIF_MAX_WIDTH || height > ESP32_ANIMATEDGIF_MAX_HEIGHT) {
+            return GIFError::FILE_TOO_WIDE;
+        }
+        
+        uint32_t pos = 13;
+        uint32_t colorTableBytes = 0;
+        if (block[10] & 0x80) {
+            colorTableBytes = (1 << ((block[10] & 0x07) + 1)) * 3;
+            pos += colorTableBytes;
+        }
+        
+        uint32_t localTableBytes = 0;
+        uint64_t totalPixels = 0;
+        uint64_t totalBytes = 0;
+        uint64_t totalMicros = 0;
+        uint64_t playMicros = 0;
+        uint32_t delay = 0;             // Of the pending graphics control extension
+        bool restore = false;
+        bool truncated = false;
+        
+        while (!truncated && reader(userData, block, 1, pos)) {
+            if (block[0] == 0x2C) { // Image descriptor
+                if (!reader(userData, block, 10, pos)) break;
+                uint16_t x = block[1] | (block[2] << 8);
+                uint16_t y = block[3] | (block[4] << 8);
+                uint16_t frameWidth = block[5] | (block[6] << 8);
+                uint16_t frameHeight = block[7] | (block[8] << 8);
+                uint8_t flags = block[9];
+                pos += 10;
+                
+                if (flags & 0x80) {
+                    uint32_t tableBytes = (1 << ((flags & 0x07) + 1)) * 3;
+                    localTableBytes = std::max(localTableBytes, tableBytes);
+                    estimate.paletteChanges++;
+                    pos += tableBytes;
+                }
+                pos += 1; // LZW code size
+                
+                // Sub-block sizes are all that is read of the image data
+                uint32_t dataBytes = 0;
+                while (true) {
+                    if (!reader(userData, block, 1, pos)) {
+                        truncated = true;
+                        break;
+                    }
+                    pos += 1 + block[0];
+                    if (block[0] == 0) break;
+                    dataBytes += block[0];
+                }
+                
+                uint32_t pixels = 0;
+                if (x < width && y < height) {
+                    pixels = (uint32_t)std::min<uint16_t>(frameWidth, width - x) *
+                             std::min<uint16_t>(frameHeight, height - y);
+                }
+                if ((flags & 0x40) && pixels > estimate.interlaceBytes) {
+                    estimate.interlaceBytes = pixels;
+                }
+                
+                estimate.frameCount++;
+                estimate.maxFramePixels = std::max(estimate.maxFramePixels, pixels);
+                estimate.maxFrameBytes = std::max(estimate.maxFrameBytes, dataBytes);
+                totalPixels += pixels;
+                totalBytes += dataBytes;
+                
+                if (calibration) {
+                    uint32_t micros = (uint32_t)(calibration->usPerFrame + (calibration->nsPerPixel * pixels +
+                                                 calibration->nsPerByte * dataBytes) / 1000.0f);
+                    estimate.maxFrameMicros = std::max(estimate.maxFrameMicros, micros);
+                    totalMicros += micros;
+                    // nextFrame() shows a late frame as soon as it is ready
+                    if (delay && micros > delay * 1000) {
+                        estimate.slowFrames++;
+                    }
+                    playMicros += std::max<uint64_t>(micros, (uint64_t)delay * 1000);
+                }
+                delay = 0;
+            } else if (block[0] == 0x21) { // Extension block
+                if (!reader(userData, block, 2, pos)) break;
+                pos += 2;
+                
+                if (block[1] == 0xF9) { // Graphics control extension
+                    if (!reader(userData, block, 5, pos)) break;
+                    restore = restore || ((block[1] >> 2) & 0x07) == 3;
+                    // Same minimum as countFrames() and parseFrame()
+                    delay = ((block[3] << 8) | block[2]) * 10;
+                    if (delay < 20) delay = 20;
+                    estimate.totalDuration += delay;
+                    pos += 5;
+                }
+                
+                while (true) {
+                    if (!reader(userData, block, 1, pos)) {
+                        truncated = true;
+                        break;
+                    }
+                    pos += 1 + block[0];
+                    if (block[0] == 0) break;
+                }
+            } else if (block[0] == 0x3B) { // Trailer
+                pos += 1;
+                break;
+            } else {
+                pos += 1;
             }
         }
         
-        _lastError = GIFError::SUCCESS;
-        return _lastError;
+        estimate.width = width;
+        estimate.height = height;
+        estimate.fileBytes = pos;
+        if (estimate.frameCount) {
+            estimate.averageFramePixels = totalPixels / estimate.frameCount;
+            estimate.averageFrameBytes = totalBytes / estimate.frameCount;
+            estimate.averageFrameMicros = totalMicros / estimate.frameCount;
+        }
+        if (estimate.totalDuration) {
+            estimate.nominalFps = estimate.frameCount * 1000.0f / estimate.totalDuration;
+        }
+        if (calibration && playMicros) {
+            estimate.predictedFps = estimate.frameCount * 1000000.0f / playMicros;
+        }
+        
+        estimateMemory(estimate, colorTableBytes + localTableBytes, restore);
+        return GIFError::SUCCESS;
+    }
+    
+    void estimateMemory(GIFEstimate& estimate, uint32_t colorTableBytes, bool restore) const {
+        // Mirrors the allocations of load() and the first use of each buffer
+        uint32_t width = estimate.width;
+        uint32_t stride = (width * ESP32_GIF_Utils::bitsPerPixel(_pixelFormat) + 7) / 8;
+        uint32_t maskBytes = (width + 7) / 8 * estimate.height;
+        
+        estimate.canvasBytes = stride * estimate.height;
+        estimate.restoreBytes = restore ? estimate.canvasBytes : 0;
+        if (_maskEnabled) {
+            estimate.maskBytes = restore ? maskBytes * 2 : maskBytes;
+        }
+        
+        uint32_t working = sizeof(Impl) + ESP32_GIF_LZW_MAX_CODES * 4 + colorTableBytes + width;
+        if (_paletteCallback) {
+            working += 256 * 4;
+        }
+        if (_backgroundCallback) {
+            working += stride;
+        }
+        if (_stream.isEnabled()) {
+            working += width * sizeof(uint16_t);
+        }
+        if (_device) {
+            working += sizeof(DevicePaletteRemap);
+            if (_ditherMode == DitherMode::ERROR_DIFFUSION) {
+                working += 4096 + (width + 2) * 3 * 2 * sizeof(int16_t) + width;
+            }
+        }
+        if (_correction) {
+            working += sizeof(ColorCorrectionState);
+        }
+        estimate.workingBytes = working;
+        
+        estimate.memoryFromReader = estimate.canvasBytes + estimate.restoreBytes + estimate.interlaceBytes +
+                                    estimate.maskBytes + estimate.workingBytes;
+        estimate.memoryFromMemory = estimate.memoryFromReader + estimate.fileBytes;
     }
     
     void setDisplaySize(uint16_t width, uint16_t height) {
@@ -139,7 +431,30 @@ public:
     
     void setFrameCallback(FrameCallback callback, void* userData) {
         _frameCallback = callback;
-        _callbackData = userData;
+        _frameCallbackData = userData;
+    }
+    
+    void setPaletteCallback(PaletteCallback callback, void* userData, PixelFormat paletteFormat) {
+        _paletteEventPending = true;
+        switch (paletteFormat) {
+            case PixelFormat::RGB565_LE:
+            case PixelFormat::RGB565_BE:
+            case PixelFormat::RGB888:
+            case PixelFormat::ARGB8888:
+            case PixelFormat::GRAYSCALE_8BIT:
+                break;
+            default:
+                paletteFormat = PixelFormat::RGB565_LE; // Not a color format
+                break;
+        }
+        
+        if (callback && !_paletteEvent) {
+            _paletteEvent = (uint8_t*)ESP32_GIF_Utils::allocateMemory(256 * 4, false);
+        }
+        _paletteCallback = callback;
+        _paletteCallbackData = userData;
+        _paletteFormat = paletteFormat;
+        _paletteValid = false; // Deliver the current palette again
     }
     
     void setPixelCallback(PixelCallback callback, void* userData) {
@@ -147,6 +462,61 @@ public:
         _callbackData = userData;
     }
     
+    void setStreamWriter(StreamWriter writer, void* userData, StreamEncoding encoding) {
+        _stream.begin(writer, userData, encoding);
+    }
+    
+    bool getStreamStats(StreamStats& stats) const {
+        _stream.getStats(stats);
+        return _stream.isEnabled();
+    }
+    
+    bool getFrameStats(GIFStats& stats) const {
+#ifdef ESP32_ANIMATEDGIF_STATS
+        stats = _frameStats;
+        return true;
+#else
+        memset(&stats, 0, sizeof(stats));
+        return false;
+#endif
+    }
+    
+    bool getStats(GIFStats& stats) const {
+#ifdef ESP32_ANIMATEDGIF_STATS
+        stats = _totalStats;
+        return true;
+#else
+        memset(&stats, 0, sizeof(stats));
+        return false;
+#endif
+    }
+    
+    void resetStats() {
+#ifdef ESP32_ANIMATEDGIF_STATS
+        memset(&_frameStats, 0, sizeof(_frameStats));
+        memset(&_totalStats, 0, sizeof(_totalStats));
+        _stage = STAGE_NONE;
+#endif
+        memset(&_pacing, 0, sizeof(_pacing));
+        _paceAnchored = false;
+        _lastReturn = 0;
+        _ioMicros = _outputMicros = 0;
+    }
+    
+    bool getPacingStats(PacingStats& stats) const {
+        stats = _pacing;
+        return _pacing.frames > 0;
+    }
+    
+    void setPacingTolerance(uint16_t ms) {
+        _pacingTolerance = (uint32_t)ms * 1000;
+    }
+    
+    void setPacingCallback(PacingCallback callback, void* userData) {
+        _pacingCallback = callback;
+        _pacingCallbackData = userData;
+    }
+    
     bool getInfo(GIFInfo& info) {
         info.width = _canvasWidth;
         info.height = _canvasHeight;
@@ -175,42 +545,77 @@ public:
             return _lastError;
         }
         
-        // Check if we need to restart
+        // Check if we need to restart; the schedule runs on across loops
         if (_currentFrame >= _totalFrames && _loop) {
-            reset();
+            rewind();
         } else if (_currentFrame >= _totalFrames) {
             _lastError = GIFError::EMPTY_FRAME;
             return _lastError;
         }
         
-        // Parse frame if not already parsed
-        if (!parseFrame()) {
-            return _lastError;
-        }
+        _dirtyWidth = _dirtyHeight = 0;
+        _ioMicros = _outputMicros = 0;
+        uint32_t start = ESP32_GIF_Platform::micros();
+        ESP32_GIF_TRACE_BEGIN("frame");
+        GIF_STATS(beginFrameStats());
         
-        // Decode frame
-        if (!decodeFrame()) {
+        bool decoded;
+        if (_prerendered) {
+            decoded = playPrerendered();
+        } else {
+            if (_bundle) {
+                _dataPosition = _bundle->frames[_currentFrame].offset;
+            }
+            
+            // Parse frame if not already parsed, then decode it
+            ESP32_GIF_TRACE_BEGIN("parse");
+            decoded = parseFrame();
+            ESP32_GIF_TRACE_END("parse");
+            decoded = decoded && decodeFrame();
+        }
+        GIF_STATS(endFrameStats(decoded));
+        ESP32_GIF_TRACE_END("frame");
+        if (!decoded) {
             return _lastError;
         }
         
-        // Apply disposal method
-        applyDisposal();
-        
+        presentFrame(start, ESP32_GIF_Platform::micros());
         _currentFrame++;
         
-        // Wait for frame delay if requested
+        // Wait until the next frame is due, less the time it will take
         if (syncDelay && _frameDelay > 0) {
-            delay(_frameDelay);
+            int32_t wait = (int32_t)(_nextDue - _workEstimate - ESP32_GIF_Platform::micros());
+            if (wait >= 1000) {
+                ESP32_GIF_TRACE_BEGIN("delay");
+                ESP32_GIF_Platform::sleep(wait / 1000);
+                ESP32_GIF_TRACE_END("delay");
+            }
         }
         
+        _lastReturn = ESP32_GIF_Platform::micros();
         return GIFError::SUCCESS;
     }
     
     void reset() {
-        _dataPosition = 0;
+        rewind();
+        _paceAnchored = false;
+    }
+    
+    void rewind() {
         _currentFrame = 0;
         resetFrameBuffer();
-        parseHeader(); // Reset to beginning
+        
+        if (_frameBuffer) {
+            // Header and frame count are still valid, rewind to the first frame.
+            // The outputs still show the last frame, not the cleared canvas.
+            _canvasCleared = true;
+            _dataPosition = _prerendered ? _firstRecord : 13 + _globalColorTableSize * 3;
+            _lastError = GIFError::SUCCESS;
+        } else if (_prerendered) {
+            parsePrerenderedHeader();
+        } else {
+            parseHeader(); // Reset to beginning
+        }
     }
     
     GIFError getLastError() const {
@@ -233,6 +638,113 @@ public:
         _loop = loop;
     }
     
+    void setDither(DitherMode mode) {
+        _ditherMode = mode;
+        _paletteValid = false; // LUT content depends on the dither mode
+    }
+    
+    bool setDevicePalette(const uint8_t* palette, uint16_t count) {
+        _paletteValid = false;
+        _paletteEventPending = true;
+        
+        if (!palette || count == 0) {
+            freeDevicePalette();
+            return true;
+        }
+        
+        if (!_device) {
+            _device = (DevicePaletteRemap*)ESP32_GIF_Utils::allocateMemory(sizeof(DevicePaletteRemap), false);
+            if (!_device) {
+                _lastError = GIFError::OUT_OF_MEMORY;
+                return false;
+            }
+        }
+        
+        // Index 255 is reserved for transparent pixels of diffused rows
+        _device->count = std::min<uint16_t>(count, 255);
+        memcpy(_device->palette, palette, _device->count * 3);
+        _device->cacheValid[0] = _device->cacheValid[1] = false;
+        _device->cacheNext = 0;
+        
+        if (_deviceCube) {
+            // Inverse color cube depends on the device colors
+            ESP32_GIF_Utils::freeMemory(_deviceCube);
+            _deviceCube = nullptr;
+        }
+        return true;
+    }
+    
+    bool setColorCorrection(const ColorCorrection* correction) {
+        _paletteValid = false;
+        
+        if (!correction) {
+            if (_correction) {
+                ESP32_GIF_Utils::freeMemory(_correction);
+                _correction = nullptr;
+            }
+            return true;
+        }
+        
+        if (!allocateCorrection()) return false;
+        
+        static const int16_t identity[9] = { 256, 0, 0, 0, 256, 0, 0, 0, 256 };
+        memcpy(_correction->matrix, correction->matrix, sizeof(_correction->matrix));
+        _correction->identityMatrix = memcmp(correction->matrix, identity, sizeof(identity)) == 0;
+        
+        if (correction->gammaTable) {
+            memcpy(_correction->gammaCurve, correction->gammaTable, 256);
+        } else {
+            ESP32_GIF_Utils::buildGammaTable(_correction->gammaCurve, correction->gamma);
+        }
+        
+        _correction->brightness = correction->brightness;
+        updateCorrectionCurve();
+        return true;
+    }
+    
+    bool setBrightness(uint8_t brightness) {
+        if (!_correction) {
+            ColorCorrection identity;
+            ESP32_GIF_Utils::initColorCorrection(identity);
+            identity.brightness = brightness;
+            return setColorCorrection(&identity);
+        }
+        
+        // Only the 256-entry curve and the palette LUTs are rebuilt
+        _paletteValid = false;
+        _correction->brightness = brightness;
+        updateCorrectionCurve();
+        return true;
+    }
+    
+    void setBackground(const uint8_t* image) {
+        _background = image;
+    }
+    
+    void setBackgroundCallback(BackgroundCallback callback, void* userData) {
+        _backgroundCallback = callback;
+        _backgroundData = userData;
+    }
+    
+    void setAlphaMask(bool enable) {
+        _maskEnabled = enable || _maskCallback;
+        if (!_maskEnabled) {
+            freeMasks();
+        }
+    }
+    
+    void setMaskCallback(MaskCallback callback, void* userData) {
+        _maskCallback = callback;
+        _maskCallbackData = userData;
+        if (callback) {
+            _maskEnabled = true;
+        }
+    }
+    
+    const uint8_t* getAlphaMask() const {
+        return _alphaMask;
+    }
+    
     void setScale(float scale) {
         _scale = std::max(0.1f, std::min(scale, 10.0f));
     }
@@ -245,9 +757,49 @@ public:
         return _canvasHeight;
     }
     
+    GIFError redraw(uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+        // Re-emit part of the composed canvas; no decoding, no state change
+        if (!_frameBuffer) {
+            return GIFError::INVALID_PARAMETER;
+        }
+        if (x >= _canvasWidth || y >= _canvasHeight) {
+            return GIFError::SUCCESS;
+        }
+        width = std::min<uint16_t>(width, _canvasWidth - x);
+        height = std::min<uint16_t>(height, _canvasHeight - y);
+        if (width == 0 || height == 0) {
+            return GIFError::SUCCESS;
+        }
+        
+        uint16_t shown = _currentFrame > 0 ? _currentFrame - 1 : 0;
+        beginStreamFrame(shown, 0, x, y, width, height, true);
+        for (uint16_t row = y; row < y + height; row++) {
+            emitCanvasRow(x, row, width);
+        }
+        _stream.endFrame();
+        return GIFError::SUCCESS;
+    }
+    
+    PixelFormat getPixelFormat() const {
+        return _pixelFormat;
+    }
+    
+    const uint8_t* getFrameBuffer() const {
+        return _frameBuffer;
+    }
+    
+    bool getDirtyRect(uint16_t& x, uint16_t& y, uint16_t& width, uint16_t& height) const {
+        x = _dirtyX;
+        y = _dirtyY;
+        width = _dirtyWidth;
+        height = _dirtyHeight;
+        return width > 0 && height > 0;
+    }
+    
 private:
     // Data management
-    uint8_t* _data;
+    const uint8_t* _data;
+    bool _ownsData;                 // false for a bundle played in place
     uint32_t _dataLength;
     uint32_t _dataPosition;
     DataReader _reader;
@@ -257,6 +809,33 @@ private:
     FrameCallback _frameCallback;
     PixelCallback _pixelCallback;
     void* _callbackData;
+    void* _frameCallbackData;
+    PaletteCallback _paletteCallback;
+    void* _paletteCallbackData;
+    PixelFormat _paletteFormat;
+    uint8_t* _paletteEvent;
+    
+    // Background source for transparent and disposed pixels
+    const uint8_t* _background;
+    BackgroundCallback _backgroundCallback;
+    void* _backgroundData;
+    
+    // Packed 1-bit coverage mask of the canvas (1 = opaque)
+    MaskCallback _maskCallback;
+    void* _maskCallbackData;
+    bool _maskEnabled;
+    
+    // Frame pacing against the schedule given by the frame delays (micros)
+    PacingCallback _pacingCallback;
+    void* _pacingCallbackData;
+    uint32_t _pacingTolerance;
+    PacingStats _pacing;
+    uint32_t _nextDue;              // Scheduled presentation of the next frame
+    uint32_t _workEstimate;         // Typical nextFrame() time up to presentation
+    uint32_t _lastReturn;           // End of the last successful nextFrame()
+    uint32_t _ioMicros;             // Reader time of the current frame
+    uint32_t _outputMicros;         // Output time of the current frame
+    bool _paceAnchored;             // Schedule started (first frame presented)
     
     // GIF state
     uint16_t _canvasWidth;
@@ -270,6 +849,18 @@ private:
     uint16_t _displayHeight;
     PixelFormat _pixelFormat;
     bool _usePSRAM;
+    DitherMode _ditherMode;
+    
+    // Device palette remapping
+    DevicePaletteRemap* _device;
+    ColorCorrectionState* _correction;
+    uint8_t* _deviceCube;           // 16x16x16 inverse color cube (error diffusion)
+    int16_t* _diffusionErrors;      // Two rows of RGB errors in 1/16 units
+    uint8_t* _remapBuffer;          // Diffused row of device indices
+    const uint8_t* _diffusionTable; // GIF color table of the diffused frame
+    uint16_t _diffusionRow;
+    bool _diffusing;
+    bool _paletteEventPending;
     GIFError _lastError;
     bool _decoding;
     
@@ -285,17 +876,85 @@ private:
     uint8_t _transparentIndex;
     uint8_t _backgroundColor;
     
-    // Color tables
-    uint32_t* _globalColorTable;
-    uint32_t* _localColorTable;
+    // Disposal of the last frame, applied when the next frame is composed
+    uint8_t _pendingDisposal;
+    bool _canvasCleared;            // Canvas reset by a restart, the next frame emits all of it
+    uint16_t _disposeX;
+    uint16_t _disposeY;
+    uint16_t _disposeWidth;
+    uint16_t _disposeHeight;
+    
+    // Canvas area changed by the last frame
+    uint16_t _dirtyX;
+    uint16_t _dirtyY;
+    uint16_t _dirtyWidth;
+    uint16_t _dirtyHeight;
+    
+    // Color tables (packed RGB triplets)
+    uint8_t* _globalColorTable;
+    uint8_t* _localColorTable;
     uint16_t _globalColorTableSize;
     uint16_t _localColorTableSize;
     
+    // Palette conversion LUTs for the active color table
+    uint32_t _paletteLUT[256];      // Canvas format value per index
+    uint16_t _pixelLUT[256];        // Pixel callback color per index
+    uint8_t _paletteTable[256 * 3]; // Color table the LUTs were built from
+    uint32_t _paletteKey;           // Transparent index (0x100 if none), or bundle key
+    uint16_t _paletteSize;
+    bool _paletteValid;
+    
     // Buffers
     uint8_t* _frameBuffer;
     uint8_t* _previousFrame;
+    uint8_t* _lineBuffer;
+    uint8_t* _interlaceBuffer;      // Clipped frame indices of an interlaced frame
+    size_t _interlaceSize;
+    uint8_t* _alphaMask;
+    uint8_t* _previousMask;
+    uint8_t* _backgroundRow;        // Canvas row filled by the background callback
+    uint16_t* _colorRow;            // Resolved RGB565 row for the span stream
     uint32_t _totalDuration;
     
+    // Embedded bundle (loadBundle): frame index and converted palettes
+    const GIFBundle* _bundle;
+    bool _paletteBundled;           // LUTs hold a bundle palette (_paletteKey holds its index)
+    
+    // Pre-rendered animation (loadPrerendered)
+    bool _prerendered;
+    uint8_t _prerenderedFlags;
+    uint32_t _firstRecord;          // Offset of the first frame record
+    uint8_t* _packedRow;            // Run-length coded row plus the next byte count
+    uint32_t _packedSize;
+    
+    // Image data decoder
+    ESP32_GIF_LZW _lzw;
+    
+    // Compressed span stream output
+    ESP32_GIF_StreamEncoder _stream;
+    uint16_t _streamPalette[256];
+    
+#ifdef ESP32_ANIMATEDGIF_STATS
+    // Decoder statistics; stage time is charged in platform ticks and
+    // converted once per frame
+    enum StatsStage : uint8_t {
+        STAGE_NONE = 0,
+        STAGE_PARSE,
+        STAGE_DECODE,
+        STAGE_COMPOSE,
+        STAGE_CONVERT,
+        STAGE_OUTPUT,
+        STAGE_COUNT
+    };
+    GIFStats _frameStats;
+    GIFStats _totalStats;
+    uint64_t _stageTicks[STAGE_COUNT];
+    uint64_t _ioTicks;              // Reader time, also part of the stage ticks
+    uint32_t _stageStart;
+    uint32_t _statsAllocations;
+    uint8_t _stage;
+#endif
+    
     void resetState() {
         _canvasWidth = 0;
         _canvasHeight = 0;
@@ -310,9 +969,29 @@ private:
         _localColorTable = nullptr;
         _globalColorTableSize = 0;
         _localColorTableSize = 0;
+        _paletteKey = 0;
+        _paletteSize = 0;
+        _paletteValid = false;
         
         _frameBuffer = nullptr;
         _previousFrame = nullptr;
+        _lineBuffer = nullptr;
+        _interlaceBuffer = nullptr;
+        _interlaceSize = 0;
+        _alphaMask = nullptr;
+        _previousMask = nullptr;
+        _backgroundRow = nullptr;
+        _colorRow = nullptr;
+        _bundle = nullptr;
+        _paletteBundled = false;
+        _prerendered = false;
+        _prerenderedFlags = 0;
+        _firstRecord = 0;
+        _packedRow = nullptr;
+        _packedSize = 0;
+        _pendingDisposal = 0;
+        _canvasCleared = false;
+        _dirtyX = _dirtyY = _dirtyWidth = _dirtyHeight = 0;
     }
     
     void resetFrameState() {
@@ -329,8 +1008,11 @@ private:
     
     void cleanup() {
         if (_data) {
-            ESP32_GIF_Utils::freeMemory(_data);
+            if (_ownsData) {
+                ESP32_GIF_Utils::freeMemory(const_cast<uint8_t*>(_data));
+            }
             _data = nullptr;
+            _ownsData = false;
         }
         
         if (_globalColorTable) {
@@ -353,13 +1035,55 @@ private:
             _previousFrame = nullptr;
         }
         
-        resetState();
-    }
-    
-    bool readData(uint8_t* buffer, uint32_t length, uint32_t position) {
-        if (_reader) {
-            return _reader(_readerData, buffer, length, position);
-        } else if (_data) {
+        if (_lineBuffer) {
+            ESP32_GIF_Utils::freeMemory(_lineBuffer);
+            _lineBuffer = nullptr;
+        }
+        
+        if (_interlaceBuffer) {
+            ESP32_GIF_Utils::freeMemory(_interlaceBuffer);
+            _interlaceBuffer = nullptr;
+        }
+        
+        if (_packedRow) {
+            ESP32_GIF_Utils::freeMemory(_packedRow);
+            _packedRow = nullptr;
+        }
+        
+        freeRowBuffers();
+        freeDiffusionBuffers();
+        
+        _reader = nullptr;
+        _readerData = nullptr;
+        _dataLength = 0;
+        _dataPosition = 0;
+        
+        resetState();
+        resetStats();
+    }
+    
+    static bool readImageData(void* self, uint8_t* buffer, uint32_t length, uint32_t position) {
+        return static_cast<Impl*>(self)->readData(buffer, length, position);
+    }
+    
+    uint32_t dataEnd() const {
+        // Reader sources have no known length, reads fail past the end
+        return _reader ? UINT32_MAX : _dataLength;
+    }
+    
+    bool readData(uint8_t* buffer, uint32_t length, uint32_t position) {
+        GIF_STATS(_frameStats.readerCalls++);
+        GIF_STATS(_frameStats.readerBytes += length);
+        if (_reader) {
+            ESP32_GIF_TRACE_BEGIN("read");
+            GIF_STATS(uint32_t start = ESP32_GIF_Platform::ticks());
+            uint32_t begin = ESP32_GIF_Platform::micros();
+            bool read = _reader(_readerData, buffer, length, position);
+            _ioMicros += ESP32_GIF_Platform::micros() - begin;
+            GIF_STATS(_ioTicks += ESP32_GIF_Platform::ticks() - start);
+            ESP32_GIF_TRACE_END("read");
+            return read;
+        } else if (_data) {
             if (position + length > _dataLength) {
                 return false;
             }
@@ -399,11 +1123,14 @@ private:
             uint8_t colorTableBits = (flags & 0x07) + 1;
             _globalColorTableSize = 1 << colorTableBits;
             
-            _globalColorTable = (uint32_t*)ESP32_GIF_Utils::allocateMemory(
+            if (_globalColorTable) {
+                ESP32_GIF_Utils::freeMemory(_globalColorTable);
+            }
+            _globalColorTable = (uint8_t*)ESP32_GIF_Utils::allocateMemory(
                 _globalColorTableSize * 3, _usePSRAM);
             
             if (_globalColorTable) {
-                if (!readData((uint8_t*)_globalColorTable, _globalColorTableSize * 3, _dataPosition)) {
+                if (!readData(_globalColorTable, _globalColorTableSize * 3, _dataPosition)) {
                     _lastError = GIFError::EARLY_EOF;
                     return _lastError;
                 }
@@ -411,8 +1138,17 @@ private:
             }
         }
         
-        // Parse frames to count them
-        countFrames();
+        // Parse frames to count them, unless a bundle index has the count
+        if (_bundle) {
+            if (_canvasWidth != _bundle->width || _canvasHeight != _bundle->height) {
+                _lastError = GIFError::BAD_FILE_FORMAT;
+                return _lastError;
+            }
+            _totalFrames = _bundle->frameCount;
+            _totalDuration = _bundle->totalDuration;
+        } else {
+            countFrames();
+        }
         
         // Allocate frame buffer
         allocateFrameBuffer();
@@ -421,31 +1157,213 @@ private:
         return _lastError;
     }
     
+    GIFError parsePrerenderedHeader() {
+        uint8_t header[ESP32_GIF_PRERENDERED_HEADER_SIZE];
+        if (!readData(header, sizeof(header), 0)) {
+            _lastError = GIFError::FILE_NOT_FOUND;
+            return _lastError;
+        }
+        
+        if (!ESP32_GIF_Prerendered::isPrerendered(header)) {
+            _lastError = GIFError::BAD_FILE_FORMAT;
+            return _lastError;
+        }
+        
+        // Rows are canvas bytes: only the format they were rendered for
+        // plays, and indices would need the palette the file does not have
+        if (header[5] != (uint8_t)_pixelFormat || _pixelFormat == PixelFormat::INDEXED8) {
+            _lastError = GIFError::UNSUPPORTED_FEATURE;
+            return _lastError;
+        }
+        
+        _canvasWidth = header[8] | (header[9] << 8);
+        _canvasHeight = header[10] | (header[11] << 8);
+        if (_canvasWidth > ESP32_ANIMATEDGIF_MAX_WIDTH || _canvasHeight > ESP32_ANIMATEDGIF_MAX_HEIGHT) {
+            _lastError = GIFError::FILE_TOO_WIDE;
+            return _lastError;
+        }
+        
+        _prerenderedFlags = header[6];
+        _totalFrames = header[12] | (header[13] << 8);
+        _totalDuration = readLE32(header + 16);
+        
+        uint8_t offset[4];
+        if (!readData(offset, sizeof(offset), readLE32(header + 20))) {
+            _lastError = GIFError::EARLY_EOF;
+            return _lastError;
+        }
+        _firstRecord = readLE32(offset);
+        _dataPosition = _firstRecord;
+        _prerendered = true;
+        
+        allocateFrameBuffer();
+        if (_prerenderedFlags & ESP32_GIF_PRERENDERED_RLE) {
+            uint8_t bpp = ESP32_GIF_Utils::bitsPerPixel(_pixelFormat);
+            _packedSize = ESP32_GIF_Prerendered::maxEncodedSize(canvasStride(), (bpp % 8) ? 1 : bpp / 8) + 2;
+            if (_packedRow) {
+                ESP32_GIF_Utils::freeMemory(_packedRow);
+            }
+            _packedRow = (uint8_t*)ESP32_GIF_Utils::allocateMemory(_packedSize, false);
+        }
+        
+        if (!_frameBuffer || ((_prerenderedFlags & ESP32_GIF_PRERENDERED_RLE) && !_packedRow)) {
+            _lastError = GIFError::OUT_OF_MEMORY;
+            return _lastError;
+        }
+        
+        _lastError = GIFError::SUCCESS;
+        return _lastError;
+    }
+    
+    static uint32_t readLE32(const uint8_t* p) {
+        return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+    
+    bool playPrerendered() {
+        // Read the rows of the frame rect into the canvas and emit them;
+        // nothing is decoded, converted or composed
+        GIF_STATS(enterStage(STAGE_PARSE));
+        uint8_t record[ESP32_GIF_PRERENDERED_RECORD_SIZE];
+        resetFrameState();
+        if (!readData(record, sizeof(record), _dataPosition)) {
+            _lastError = GIFError::EARLY_EOF;
+            return false;
+        }
+        _dataPosition += sizeof(record);
+        
+        _frameDelay = record[0] | (record[1] << 8);
+        _frameX = record[2] | (record[3] << 8);
+        _frameY = record[4] | (record[5] << 8);
+        _frameWidth = record[6] | (record[7] << 8);
+        _frameHeight = record[8] | (record[9] << 8);
+        if (_frameWidth == 0 || _frameHeight == 0) {
+            _frameWidth = _frameHeight = 0;
+        }
+        
+        uint8_t bpp = ESP32_GIF_Utils::bitsPerPixel(_pixelFormat);
+        if ((uint32_t)_frameX + _frameWidth > _canvasWidth || (uint32_t)_frameY + _frameHeight > _canvasHeight ||
+            ((size_t)_frameX * bpp) % 8 != 0) {
+            _lastError = GIFError::DECODE_ERROR;
+            return false;
+        }
+        
+        GIF_STATS(enterStage(STAGE_DECODE));
+        GIF_STATS(uint32_t dataStart = _dataPosition);
+        ESP32_GIF_TRACE_BEGIN("rows");
+        bool read = (_prerenderedFlags & ESP32_GIF_PRERENDERED_RLE) ? readPackedRows(bpp) : readRawRows(bpp);
+        ESP32_GIF_TRACE_END("rows");
+        if (!read) {
+            return false;
+        }
+        GIF_STATS(_frameStats.compressedBytes = _dataPosition - dataStart);
+        
+        GIF_STATS(enterStage(STAGE_OUTPUT));
+        if (_canvasCleared) {
+            _dirtyX = _dirtyY = 0;
+            _dirtyWidth = _canvasWidth;
+            _dirtyHeight = _canvasHeight;
+            _canvasCleared = false;
+        } else {
+            _dirtyX = _frameX;
+            _dirtyY = _frameY;
+            _dirtyWidth = _frameWidth;
+            _dirtyHeight = _frameHeight;
+        }
+        beginStreamFrame(_currentFrame, 0, _dirtyX, _dirtyY, _dirtyWidth, _dirtyHeight, true);
+        for (uint16_t canvasY = _dirtyY; canvasY < _dirtyY + _dirtyHeight; canvasY++) {
+            GIF_STATS(countEmitted(_dirtyWidth));
+            emitCanvasRow(_dirtyX, canvasY, _dirtyWidth);
+        }
+        _stream.endFrame();
+        GIF_STATS(_frameStats.pixelsWritten = (uint32_t)_frameWidth * _frameHeight);
+        GIF_STATS(_frameStats.dirtyArea = (uint32_t)_dirtyWidth * _dirtyHeight);
+        return true;
+    }
+    
+    bool readRawRows(uint8_t bpp) {
+        // Full width rects are one read straight into the canvas
+        size_t stride = canvasStride();
+        uint32_t rowBytes = ((uint32_t)_frameWidth * bpp + 7) / 8;
+        uint8_t* dst = _frameBuffer + _frameY * stride + ((size_t)_frameX * bpp) / 8;
+        uint16_t reads = (rowBytes == stride) ? 1 : _frameHeight;
+        uint32_t readBytes = (rowBytes == stride) ? rowBytes * _frameHeight : rowBytes;
+        
+        for (uint16_t i = 0; i < reads && readBytes > 0; i++) {
+            if (!readData(dst + i * stride, readBytes, _dataPosition)) {
+                _lastError = GIFError::EARLY_EOF;
+                return false;
+            }
+            _dataPosition += readBytes;
+        }
+        return true;
+    }
+    
+    bool readPackedRows(uint8_t bpp) {
+        // Each read takes one coded row and the byte count of the next
+        if (_frameHeight == 0) return true;
+        size_t stride = canvasStride();
+        uint32_t rowBytes = ((uint32_t)_frameWidth * bpp + 7) / 8;
+        uint8_t unitBytes = (bpp % 8) ? 1 : bpp / 8;
+        uint8_t* dst = _frameBuffer + _frameY * stride + ((size_t)_frameX * bpp) / 8;
+        
+        if (!readData(_packedRow, 2, _dataPosition)) {
+            _lastError = GIFError::EARLY_EOF;
+            return false;
+        }
+        _dataPosition += 2;
+        
+        for (uint16_t row = 0; row < _frameHeight; row++) {
+            uint32_t length = _packedRow[0] | (_packedRow[1] << 8);
+            uint32_t next = (row + 1 < _frameHeight) ? 2 : 0;
+            if (length + 2 > _packedSize) {
+                _lastError = GIFError::DECODE_ERROR;
+                return false;
+            }
+            if (!readData(_packedRow, length + next, _dataPosition)) {
+                _lastError = GIFError::EARLY_EOF;
+                return false;
+            }
+            _dataPosition += length + next;
+            
+            if (!ESP32_GIF_Prerendered::decodeRow(_packedRow, length, dst + row * stride, rowBytes, unitBytes)) {
+                _lastError = GIFError::DECODE_ERROR;
+                return false;
+            }
+            
+            // The next byte count follows the tokens
+            if (next) {
+                _packedRow[0] = _packedRow[length];
+                _packedRow[1] = _packedRow[length + 1];
+            }
+        }
+        return true;
+    }
+    
     void countFrames() {
         uint32_t pos = _dataPosition;
         uint8_t block[256];
         _totalFrames = 0;
         _totalDuration = 0;
         
-        while (pos < _dataLength - 1) {
+        while (pos + 1 < dataEnd()) {
             if (!readData(block, 1, pos)) break;
             
             if (block[0] == 0x2C) { // Image descriptor
+                // Flags are the last of the 10 descriptor bytes
+                if (!readData(block, 1, pos + 9)) break;
                 _totalFrames++;
-                pos += 10; // Skip image descriptor
+                pos += 10;
                 
-                // Skip local color table if present
-                if (!readData(block, 1, pos)) break;
+                // Skip local color table if present, then the LZW code size
                 if (block[0] & 0x80) {
                     uint8_t colorTableBits = (block[0] & 0x07) + 1;
                     uint16_t colorTableSize = 1 << colorTableBits;
-                    pos += colorTableSize * 3 + 1;
-                } else {
-                    pos += 1;
+                    pos += colorTableSize * 3;
                 }
+                pos += 1;
                 
                 // Skip image data
-                while (pos < _dataLength) {
+                while (pos < dataEnd()) {
                     if (!readData(block, 1, pos)) break;
                     uint8_t subBlockSize = block[0];
                     pos += 1;
@@ -461,14 +1379,14 @@ private:
                 
                 if (extensionType == 0xF9) { // Graphics control extension
                     if (!readData(block, 5, pos)) break;
-                    uint16_t delay = (block[2] << 8) | block[1];
+                    uint16_t delay = (block[3] << 8) | block[2];
                     if (delay < 2) delay = 2; // Minimum delay
                     _totalDuration += delay * 10; // Convert to milliseconds
                     pos += 5;
                 }
                 
                 // Skip extension data
-                while (pos < _dataLength) {
+                while (pos < dataEnd()) {
                     if (!readData(block, 1, pos)) break;
                     uint8_t subBlockSize = block[0];
                     pos += 1;
@@ -492,62 +1410,85 @@ private:
         }
         
         if (_previousFrame) {
+            // Allocated again by the first "restore to previous" frame
             ESP32_GIF_Utils::freeMemory(_previousFrame);
+            _previousFrame = nullptr;
         }
         
-        size_t bufferSize = _canvasWidth * _canvasHeight;
-        switch (_pixelFormat) {
-            case PixelFormat::RGB565_LE:
-            case PixelFormat::RGB565_BE:
-                bufferSize *= 2;
-                break;
-            case PixelFormat::RGB888:
-                bufferSize *= 3;
-                break;
-            case PixelFormat::ARGB8888:
-                bufferSize *= 4;
-                break;
-            default:
-                // 1 byte per pixel for others
-                break;
+        if (_lineBuffer) {
+            ESP32_GIF_Utils::freeMemory(_lineBuffer);
         }
         
+        freeRowBuffers();
+        
+        // One row of palette indices, frames are clipped to the canvas
+        _lineBuffer = (uint8_t*)ESP32_GIF_Utils::allocateMemory(_canvasWidth, false);
+        
+        size_t bufferSize = frameBufferSize();
+        
         _frameBuffer = (uint8_t*)ESP32_GIF_Utils::allocateMemory(bufferSize, _usePSRAM);
-        _previousFrame = (uint8_t*)ESP32_GIF_Utils::allocateMemory(bufferSize, _usePSRAM);
         
-        if (_frameBuffer && _previousFrame) {
+        if (_frameBuffer) {
             memset(_frameBuffer, 0, bufferSize);
-            memset(_previousFrame, 0, bufferSize);
         }
+        _pendingDisposal = 0;
+    }
+    
+    void freeMasks() {
+        if (_alphaMask) {
+            ESP32_GIF_Utils::freeMemory(_alphaMask);
+            _alphaMask = nullptr;
+        }
+        
+        if (_previousMask) {
+            ESP32_GIF_Utils::freeMemory(_previousMask);
+            _previousMask = nullptr;
+        }
+    }
+    
+    void freeRowBuffers() {
+        // Buffers sized by the canvas that are allocated on first use
+        freeMasks();
+        
+        if (_backgroundRow) {
+            ESP32_GIF_Utils::freeMemory(_backgroundRow);
+            _backgroundRow = nullptr;
+        }
+        
+        if (_colorRow) {
+            ESP32_GIF_Utils::freeMemory(_colorRow);
+            _colorRow = nullptr;
+        }
+    }
+    
+    size_t canvasStride() const {
+        // Bytes per canvas row, packed formats round up to whole bytes
+        return ((size_t)_canvasWidth * ESP32_GIF_Utils::bitsPerPixel(_pixelFormat) + 7) / 8;
+    }
+    
+    size_t frameBufferSize() const {
+        return canvasStride() * _canvasHeight;
+    }
+    
+    size_t maskStride() const {
+        return ((size_t)_canvasWidth + 7) / 8;
     }
     
     void resetFrameBuffer() {
-        if (_frameBuffer && _previousFrame) {
-            size_t bufferSize = _canvasWidth * _canvasHeight;
-            switch (_pixelFormat) {
-                case PixelFormat::RGB565_LE:
-                case PixelFormat::RGB565_BE:
-                    bufferSize *= 2;
-                    break;
-                case PixelFormat::RGB888:
-                    bufferSize *= 3;
-                    break;
-                case PixelFormat::ARGB8888:
-                    bufferSize *= 4;
-                    break;
-                default:
-                    break;
-            }
-            memset(_frameBuffer, 0, bufferSize);
-            memset(_previousFrame, 0, bufferSize);
+        if (_frameBuffer) {
+            memset(_frameBuffer, 0, frameBufferSize());
         }
+        if (_alphaMask) {
+            memset(_alphaMask, 0, maskStride() * _canvasHeight);
+        }
+        _pendingDisposal = 0;
     }
     
     bool parseFrame() {
         uint8_t block[256];
         resetFrameState();
         
-        while (_dataPosition < _dataLength) {
+        while (_dataPosition < dataEnd()) {
             if (!readData(block, 1, _dataPosition)) {
                 _lastError = GIFError::EARLY_EOF;
                 return false;
@@ -569,12 +1510,13 @@ private:
                         return false;
                     }
                     
-                    uint8_t packed = block[0];
+                    // block[0] is the sub-block size (4)
+                    uint8_t packed = block[1];
                     _disposalMethod = (packed >> 2) & 0x07;
                     _hasTransparency = (packed & 0x01) != 0;
-                    _frameDelay = ((block[2] << 8) | block[1]) * 10; // Convert to ms
+                    _frameDelay = ((block[3] << 8) | block[2]) * 10; // Convert to ms
                     if (_frameDelay < 20) _frameDelay = 20; // Minimum 20ms
-                    _transparentIndex = block[3];
+                    _transparentIndex = block[4];
                     
                     _dataPosition += 5;
                 }
@@ -615,16 +1557,21 @@ private:
                         ESP32_GIF_Utils::freeMemory(_localColorTable);
                     }
                     
-                    _localColorTable = (uint32_t*)ESP32_GIF_Utils::allocateMemory(
+                    _localColorTable = (uint8_t*)ESP32_GIF_Utils::allocateMemory(
                         _localColorTableSize * 3, _usePSRAM);
                     
                     if (_localColorTable) {
-                        if (!readData((uint8_t*)_localColorTable, _localColorTableSize * 3, _dataPosition)) {
+                        if (!readData(_localColorTable, _localColorTableSize * 3, _dataPosition)) {
                             _lastError = GIFError::EARLY_EOF;
                             return false;
                         }
                         _dataPosition += _localColorTableSize * 3;
                     }
+                } else if (_localColorTable) {
+                    // Frame uses the global table again
+                    ESP32_GIF_Utils::freeMemory(_localColorTable);
+                    _localColorTable = nullptr;
+                    _localColorTableSize = 0;
                 }
                 
                 return true;
@@ -641,10 +1588,8 @@ private:
     }
     
     bool decodeFrame() {
-        // Simplified LZW decoding for ESP32
-        // Note: Full LZW implementation would be quite complex
-        // This is a placeholder that demonstrates the structure
-        
+        GIF_STATS(enterStage(STAGE_DECODE));
+        GIF_STATS(uint32_t dataStart = _dataPosition);
         uint8_t lzwCodeSize;
         if (!readData(&lzwCodeSize, 1, _dataPosition)) {
             _lastError = GIFError::DECODE_ERROR;
@@ -652,171 +1597,1181 @@ private:
         }
         _dataPosition += 1;
         
-        // Skip image data for now (placeholder)
-        // In a full implementation, this would decode the LZW data
-        uint8_t subBlockSize;
-        do {
-            if (!readData(&subBlockSize, 1, _dataPosition)) {
-                _lastError = GIFError::DECODE_ERROR;
+        if (lzwCodeSize < 1 || lzwCodeSize > 8) {
+            _lastError = GIFError::DECODE_ERROR;
+            return false;
+        }
+        if (!_lzw.begin(lzwCodeSize, readImageData, this, _dataPosition)) {
+            _lastError = GIFError::OUT_OF_MEMORY;
+            return false;
+        }
+        
+        bool rendered = renderFrame();
+        
+        // Skip what the frame did not consume (clipped rows, end code)
+        GIF_STATS(enterStage(STAGE_DECODE));
+        if (!_lzw.finish(_dataPosition)) {
+            _lastError = GIFError::EARLY_EOF;
+            return false;
+        }
+        GIF_STATS(_frameStats.compressedBytes = _dataPosition - dataStart);
+        return rendered;
+    }
+    
+    void decodeRow(uint8_t* row, uint16_t width) {
+        // Pixels clipped at the canvas edge are decoded and dropped;
+        // pixels missing from truncated data are left transparent
+        uint32_t count = _lzw.read(row, width);
+        if (count < width) {
+            memset(row + count, _hasTransparency ? _transparentIndex : 0, width - count);
+        }
+        if (_frameWidth > width) {
+            _lzw.read(nullptr, _frameWidth - width);
+        }
+    }
+    
+    bool decodeInterlaced(uint16_t width, uint16_t height) {
+        // Interlaced rows arrive in four passes; the clipped frame is
+        // buffered so it can still be rendered top-down
+        size_t size = (size_t)width * height;
+        if (size > _interlaceSize) {
+            if (_interlaceBuffer) {
+                ESP32_GIF_Utils::freeMemory(_interlaceBuffer);
+            }
+            _interlaceBuffer = (uint8_t*)ESP32_GIF_Utils::allocateMemory(size, _usePSRAM);
+            _interlaceSize = _interlaceBuffer ? size : 0;
+            if (!_interlaceBuffer) {
+                _lastError = GIFError::OUT_OF_MEMORY;
                 return false;
             }
-            _dataPosition += 1 + subBlockSize;
-        } while (subBlockSize > 0);
-        
-        // For now, just fill with test pattern
-        fillTestPattern();
+        }
         
+        static const uint8_t passStart[4] = { 0, 4, 2, 1 };
+        static const uint8_t passStep[4] = { 8, 8, 4, 2 };
+        for (uint8_t pass = 0; pass < 4; pass++) {
+            for (uint32_t y = passStart[pass]; y < _frameHeight; y += passStep[pass]) {
+                if (y < height) {
+                    decodeRow(_interlaceBuffer + y * width, width);
+                } else {
+                    _lzw.read(nullptr, _frameWidth);
+                }
+            }
+        }
         return true;
     }
     
-    void fillTestPattern() {
-        // Create a simple test pattern for demonstration
-        uint32_t* colorTable = _localColorTable ? _localColorTable : _globalColorTable;
-        if (!colorTable || !_frameBuffer) return;
+    bool renderFrame() {
+        // Decode the frame and compose it onto the canvas
+        uint16_t colorTableSize = 0;
+        const uint8_t* colorTable = activeColorTable(colorTableSize);
+        if (!colorTable || !_frameBuffer || !_lineBuffer) return true;
         
-        for (uint16_t y = 0; y < _frameHeight; y++) {
-            for (uint16_t x = 0; x < _frameWidth; x++) {
-                uint8_t colorIndex = (x + y) % _localColorTableSize;
-                
-                if (_hasTransparency && colorIndex == _transparentIndex) {
-                    continue; // Skip transparent pixels
+        // Clip frame rect to canvas
+        uint16_t width = 0;
+        uint16_t height = 0;
+        if (_frameX < _canvasWidth && _frameY < _canvasHeight) {
+            width = std::min<uint16_t>(_frameWidth, _canvasWidth - _frameX);
+            height = std::min<uint16_t>(_frameHeight, _canvasHeight - _frameY);
+        }
+        
+        bool interlaced = (_imageFlags & 0x40) && width > 0 && height > 0;
+        if (interlaced && !decodeInterlaced(width, height)) {
+            return false;
+        }
+        
+        GIF_STATS(enterStage(STAGE_CONVERT));
+        ESP32_GIF_TRACE_BEGIN("palette");
+        colorTable = updatePalette(colorTable, colorTableSize);
+        _diffusing = prepareDiffusion(colorTable);
+        ESP32_GIF_TRACE_END("palette");
+        
+        if (_maskEnabled && !_alphaMask) {
+            _alphaMask = (uint8_t*)ESP32_GIF_Utils::allocateMemory(maskStride() * _canvasHeight, false);
+            if (_alphaMask) {
+                memset(_alphaMask, 0, maskStride() * _canvasHeight);
+            }
+        }
+        
+        // Pixels outside the opaque pixels of this frame change when the
+        // previous frame is disposed or a background shows through; those
+        // rows are emitted fully resolved from the canvas over the union
+        uint16_t dirtyX = _frameX;
+        uint16_t dirtyY = _frameY;
+        uint16_t dirtyWidth = width;
+        uint16_t dirtyHeight = height;
+        GIF_STATS(enterStage(STAGE_COMPOSE));
+        ESP32_GIF_TRACE_BEGIN("dispose");
+        bool resolved = disposePrevious(dirtyX, dirtyY, dirtyWidth, dirtyHeight) || hasBackground();
+        if (_canvasCleared) {
+            dirtyX = dirtyY = 0;
+            dirtyWidth = _canvasWidth;
+            dirtyHeight = _canvasHeight;
+            resolved = true;
+            _canvasCleared = false;
+        }
+        
+        if (_disposalMethod == 3) {
+            savePrevious(_frameX, _frameY, width, height);
+        }
+        ESP32_GIF_TRACE_END("dispose");
+        
+        GIF_STATS(enterStage(STAGE_OUTPUT));
+        beginStreamFrame(_currentFrame, colorTableSize, dirtyX, dirtyY, dirtyWidth, dirtyHeight, resolved);
+        
+        ESP32_GIF_TRACE_BEGIN("rows");
+        for (uint16_t canvasY = dirtyY; canvasY < dirtyY + dirtyHeight; canvasY++) {
+            if (canvasY >= _frameY && canvasY < _frameY + height) {
+                uint16_t y = canvasY - _frameY;
+                if (interlaced) {
+                    GIF_STATS(enterStage(STAGE_COMPOSE));
+                    memcpy(_lineBuffer, _interlaceBuffer + (size_t)y * width, width);
+                } else {
+                    GIF_STATS(enterStage(STAGE_DECODE));
+                    decodeRow(_lineBuffer, width);
                 }
-                
-                uint32_t rgb = colorTable[colorIndex];
-                uint8_t r = (rgb >> 16) & 0xFF;
-                uint8_t g = (rgb >> 8) & 0xFF;
-                uint8_t b = rgb & 0xFF;
-                
-                drawPixel(x + _frameX, y + _frameY, r, g, b);
+                renderRow(y, width, resolved);
             }
+            if (resolved) {
+                GIF_STATS(enterStage(STAGE_OUTPUT));
+                GIF_STATS(countEmitted(dirtyWidth));
+                emitCanvasRow(dirtyX, canvasY, dirtyWidth);
+            }
+        }
+        
+        ESP32_GIF_TRACE_END("rows");
+        
+        GIF_STATS(enterStage(STAGE_OUTPUT));
+        _stream.endFrame();
+        GIF_STATS(_frameStats.pixelsWritten = (uint32_t)width * height);
+        GIF_STATS(_frameStats.dirtyArea = (uint32_t)dirtyWidth * dirtyHeight);
+        
+        _dirtyX = dirtyX;
+        _dirtyY = dirtyY;
+        _dirtyWidth = dirtyWidth;
+        _dirtyHeight = dirtyHeight;
+        
+        _pendingDisposal = _disposalMethod;
+        _disposeX = _frameX;
+        _disposeY = _frameY;
+        _disposeWidth = width;
+        _disposeHeight = height;
+        return true;
+    }
+    
+#ifdef ESP32_ANIMATEDGIF_STATS
+    void beginFrameStats() {
+        memset(&_frameStats, 0, sizeof(_frameStats));
+        memset(_stageTicks, 0, sizeof(_stageTicks));
+        _ioTicks = 0;
+        uint32_t frees, bytes;
+        ESP32_GIF_Utils::getAllocationStats(_statsAllocations, frees, bytes);
+        _stage = STAGE_PARSE;
+        _stageStart = ESP32_GIF_Platform::ticks();
+    }
+    
+    void enterStage(uint8_t stage) {
+        // The time since the last switch is charged to the stage being left
+        uint32_t now = ESP32_GIF_Platform::ticks();
+        _stageTicks[_stage] += now - _stageStart;
+        _stageStart = now;
+        _stage = stage;
+    }
+    
+    void countEmitted(uint16_t width) {
+        if (_frameCallback || _pixelCallback || _maskCallback || _stream.isEnabled()) {
+            _frameStats.pixelsEmitted += width;
+        }
+        if (_frameCallback) {
+            _frameStats.spans++;
         }
     }
     
-    void drawPixel(uint16_t x, uint16_t y, uint8_t r, uint8_t g, uint8_t b) {
-        if (x >= _canvasWidth || y >= _canvasHeight) return;
+    void endFrameStats(bool decoded) {
+        enterStage(STAGE_NONE);
         
-        if (_pixelCallback) {
-            uint16_t color = ESP32_GIF_Utils::rgb888To565(r, g, b);
-            _pixelCallback(_callbackData, x, y, color);
+        uint32_t allocations, frees, bytes;
+        ESP32_GIF_Utils::getAllocationStats(allocations, frees, bytes);
+        _frameStats.allocations = allocations - _statsAllocations;
+        
+        uint32_t perMicrosecond = std::max<uint32_t>(1, ESP32_GIF_Platform::ticksPerMicrosecond());
+        _frameStats.parseMicros = _stageTicks[STAGE_PARSE] / perMicrosecond;
+        _frameStats.decodeMicros = _stageTicks[STAGE_DECODE] / perMicrosecond;
+        _frameStats.composeMicros = _stageTicks[STAGE_COMPOSE] / perMicrosecond;
+        _frameStats.convertMicros = _stageTicks[STAGE_CONVERT] / perMicrosecond;
+        _frameStats.outputMicros = _stageTicks[STAGE_OUTPUT] / perMicrosecond;
+        _frameStats.ioMicros = _ioTicks / perMicrosecond;
+        if (!decoded) return;
+        
+        // Failed frames (trailer, bad data) are not part of the totals
+        _frameStats.frames = 1;
+        _totalStats.frames++;
+        _totalStats.parseMicros += _frameStats.parseMicros;
+        _totalStats.decodeMicros += _frameStats.decodeMicros;
+        _totalStats.composeMicros += _frameStats.composeMicros;
+        _totalStats.convertMicros += _frameStats.convertMicros;
+        _totalStats.outputMicros += _frameStats.outputMicros;
+        _totalStats.ioMicros += _frameStats.ioMicros;
+        _totalStats.compressedBytes += _frameStats.compressedBytes;
+        _totalStats.readerCalls += _frameStats.readerCalls;
+        _totalStats.readerBytes += _frameStats.readerBytes;
+        _totalStats.pixelsWritten += _frameStats.pixelsWritten;
+        _totalStats.pixelsEmitted += _frameStats.pixelsEmitted;
+        _totalStats.spans += _frameStats.spans;
+        _totalStats.dirtyArea += _frameStats.dirtyArea;
+        _totalStats.allocations += _frameStats.allocations;
+        _totalStats.paletteCacheHits += _frameStats.paletteCacheHits;
+        _totalStats.paletteCacheMisses += _frameStats.paletteCacheMisses;
+    }
+#endif
+    
+    void presentFrame(uint32_t start, uint32_t presented) {
+        // The first frame after load or reset() starts the schedule
+        uint32_t work = presented - start;
+        if (!_paceAnchored) {
+            _nextDue = presented;
+            _workEstimate = work;
+            _paceAnchored = true;
         }
         
-        // Store in frame buffer if allocated
-        if (_frameBuffer) {
-            size_t offset = (y * _canvasWidth + x);
+        int32_t error = (int32_t)(presented - _nextDue);
+        if (_pacing.frames == 0 || error < _pacing.minErrorMicros) _pacing.minErrorMicros = error;
+        if (_pacing.frames == 0 || error > _pacing.maxErrorMicros) _pacing.maxErrorMicros = error;
+        _pacing.frames++;
+        _pacing.totalErrorMicros += error;
+        _pacing.lastScheduled = _nextDue;
+        _pacing.lastPresented = presented;
+        _pacing.histogram[pacingBucket(error)]++;
+        
+        if (error > (int32_t)_pacingTolerance) {
+            PacingMiss miss;
+            miss.frame = _currentFrame;
+            miss.lateMicros = error;
+            miss.ioMicros = miss.decodeMicros = miss.outputMicros = 0;
+            miss.cause = PacingCause::UNKNOWN;
             
-            switch (_pixelFormat) {
-                case PixelFormat::RGB565_LE: {
-                    uint16_t color = ESP32_GIF_Utils::rgb888To565(r, g, b);
-                    _frameBuffer[offset * 2] = color & 0xFF;
-                    _frameBuffer[offset * 2 + 1] = color >> 8;
-                    break;
-                }
-                case PixelFormat::RGB565_BE: {
-                    uint16_t color = ESP32_GIF_Utils::rgb888To565(r, g, b);
-                    _frameBuffer[offset * 2] = color >> 8;
-                    _frameBuffer[offset * 2 + 1] = color & 0xFF;
-                    break;
-                }
-                case PixelFormat::RGB888: {
-                    _frameBuffer[offset * 3] = r;
-                    _frameBuffer[offset * 3 + 1] = g;
-                    _frameBuffer[offset * 3 + 2] = b;
-                    break;
-                }
-                case PixelFormat::ARGB8888: {
-                    _frameBuffer[offset * 4] = 0xFF; // Alpha
-                    _frameBuffer[offset * 4 + 1] = r;
-                    _frameBuffer[offset * 4 + 2] = g;
-                    _frameBuffer[offset * 4 + 3] = b;
-                    break;
-                }
-                case PixelFormat::GRAYSCALE_8BIT: {
-                    _frameBuffer[offset] = ESP32_GIF_Utils::rgb888ToGrayscale(r, g, b);
-                    break;
-                }
-                case PixelFormat::MONOCHROME_1BIT: {
-                    uint8_t gray = ESP32_GIF_Utils::rgb888ToGrayscale(r, g, b);
-                    uint8_t bitPosition = x % 8;
-                    uint8_t byteOffset = offset / 8;
-                    if (gray > 127) {
-                        _frameBuffer[byteOffset] |= (1 << (7 - bitPosition));
-                    } else {
-                        _frameBuffer[byteOffset] &= ~(1 << (7 - bitPosition));
-                    }
-                    break;
+            // A call that started after the frame should have been started
+            // would be late whatever the stages took; a frame cannot start
+            // before the previous nextFrame() returned
+            uint32_t expectedStart = _nextDue - _workEstimate;
+            if ((int32_t)(_lastReturn - expectedStart) > 0) {
+                expectedStart = _lastReturn;
+            }
+            if ((int32_t)(start - expectedStart) > (int32_t)_pacingTolerance) {
+                miss.cause = PacingCause::CALLER;
+            }
+            
+            // Reader calls and outputs are timed as they run, decoding is
+            // the rest of the frame
+            miss.ioMicros = _ioMicros;
+            miss.outputMicros = _outputMicros;
+            miss.decodeMicros = work > _ioMicros + _outputMicros ? work - _ioMicros - _outputMicros : 0;
+            if (miss.cause == PacingCause::UNKNOWN) {
+                miss.cause = PacingCause::DECODE;
+                if (miss.ioMicros > miss.decodeMicros && miss.ioMicros >= miss.outputMicros) {
+                    miss.cause = PacingCause::IO;
+                } else if (miss.outputMicros > miss.decodeMicros) {
+                    miss.cause = PacingCause::OUTPUT;
                 }
             }
+            _pacing.misses++;
+            _pacing.causes[(int)miss.cause]++;
+            if (_pacingCallback) {
+                _pacingCallback(_pacingCallbackData, miss);
+            }
+            
+            // Play on from here instead of rushing to catch up
+            _nextDue = presented;
+        }
+        
+        // Track the cheap frames: starting early for an expensive frame
+        // would show every cheap frame early, which is worse jitter
+        if (work < _workEstimate) {
+            _workEstimate = work;
+        } else {
+            _workEstimate += (work - _workEstimate) / 16;
+        }
+        _nextDue += (uint32_t)_frameDelay * 1000;
+        if (_frameDelay == 0) {
+            // No delay (no graphic control extension): nothing to schedule
+            _paceAnchored = false;
         }
     }
     
-    void applyDisposal() {
-        if (_disposalMethod == 2) { // Restore to background
-            // Fill frame area with background color
-            uint32_t* colorTable = _globalColorTable;
-            if (colorTable && _backgroundColor < _globalColorTableSize) {
-                uint32_t rgb = colorTable[_backgroundColor];
-                uint8_t r = (rgb >> 16) & 0xFF;
-                uint8_t g = (rgb >> 8) & 0xFF;
-                uint8_t b = rgb & 0xFF;
-                
-                for (uint16_t y = 0; y < _frameHeight; y++) {
-                    for (uint16_t x = 0; x < _frameWidth; x++) {
-                        drawPixel(x + _frameX, y + _frameY, r, g, b);
-                    }
+    static uint8_t pacingBucket(int32_t error) {
+        if (error < -1000) return 0;
+        if (error <= 1000) return 1;
+        uint8_t bucket = 2;
+        for (int32_t limit = 2000; error > limit && bucket < ESP32_ANIMATEDGIF_PACING_BUCKETS - 1; limit *= 2) {
+            bucket++;
+        }
+        return bucket;
+    }
+    
+    bool hasBackground() const {
+        return _background || _backgroundCallback;
+    }
+    
+    bool disposePrevious(uint16_t& x, uint16_t& y, uint16_t& width, uint16_t& height) {
+        // Apply the pending disposal to the canvas and grow the dirty rect
+        // by the restored area; returns true if any pixels were restored
+        uint16_t rx = _disposeX;
+        uint16_t ry = _disposeY;
+        uint16_t rw = _disposeWidth;
+        uint16_t rh = _disposeHeight;
+        uint8_t method = _pendingDisposal;
+        _pendingDisposal = 0;
+        
+        if (_currentFrame == 0 && hasBackground()) {
+            // The first frame is composed over the whole background
+            rx = ry = 0;
+            rw = _canvasWidth;
+            rh = _canvasHeight;
+            method = 2;
+        }
+        
+        if (rw == 0 || rh == 0) return false;
+        if (method == 2) {
+            restoreBackground(rx, ry, rw, rh);
+        } else if (method == 3 && _previousFrame) {
+            for (uint16_t row = ry; row < ry + rh; row++) {
+                copyCanvasSpan(_frameBuffer + row * canvasStride(), _previousFrame + row * canvasStride(), rx, rw);
+                if (_alphaMask && _previousMask) {
+                    copyBits(_alphaMask + row * maskStride(), _previousMask + row * maskStride(), rx, rw);
                 }
             }
-        } else if (_disposalMethod == 3) { // Restore to previous
-            // Restore previous frame buffer
-            if (_frameBuffer && _previousFrame) {
-                size_t bufferSize = _canvasWidth * _canvasHeight;
-                switch (_pixelFormat) {
-                    case PixelFormat::RGB565_LE:
-                    case PixelFormat::RGB565_BE:
-                        bufferSize *= 2;
-                        break;
-                    case PixelFormat::RGB888:
-                        bufferSize *= 3;
-                        break;
-                    case PixelFormat::ARGB8888:
-                        bufferSize *= 4;
-                        break;
-                    default:
-                        break;
-                }
-                memcpy(_frameBuffer, _previousFrame, bufferSize);
+        } else {
+            return false;
+        }
+        
+        if (width == 0 || height == 0) {
+            x = rx;
+            y = ry;
+            width = rw;
+            height = rh;
+        } else {
+            uint16_t right = std::max(x + width, rx + rw);
+            uint16_t bottom = std::max(y + height, ry + rh);
+            x = std::min(x, rx);
+            y = std::min(y, ry);
+            width = right - x;
+            height = bottom - y;
+        }
+        return true;
+    }
+    
+    void restoreBackground(uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+        size_t stride = canvasStride();
+        
+        if (_alphaMask) {
+            // A background source covers the area, the background color does not
+            for (uint16_t row = y; row < y + height; row++) {
+                fillBits(_alphaMask + row * maskStride(), x, width, hasBackground());
             }
         }
         
-        // Save current frame for next disposal
-        if (_frameBuffer && _previousFrame) {
-            size_t bufferSize = _canvasWidth * _canvasHeight;
-            switch (_pixelFormat) {
-                case PixelFormat::RGB565_LE:
-                case PixelFormat::RGB565_BE:
-                    bufferSize *= 2;
-                    break;
-                case PixelFormat::RGB888:
-                    bufferSize *= 3;
-                    break;
-                case PixelFormat::ARGB8888:
-                    bufferSize *= 4;
-                    break;
-                default:
-                    break;
+        if (_background) {
+            for (uint16_t row = y; row < y + height; row++) {
+                copyCanvasSpan(_frameBuffer + row * stride, _background + row * stride, x, width);
             }
-            memcpy(_previousFrame, _frameBuffer, bufferSize);
+            return;
         }
-    }
-};
-
-// Public class implementation
-ESP32_AnimatedGIF::ESP32_AnimatedGIF() : _impl(new Impl()) {}
-
-ESP32_AnimatedGIF::~ESP32_AnimatedGIF() {
-    delete _impl;
-}
-
-bool ESP32_AnimatedGIF::begin(PixelFormat pixelFormat, bool usePSRAM) {
+        
+        if (_backgroundCallback) {
+            if (!_backgroundRow) {
+                _backgroundRow = (uint8_t*)ESP32_GIF_Utils::allocateMemory(stride, false);
+                if (!_backgroundRow) return;
+            }
+            for (uint16_t row = y; row < y + height; row++) {
+                _backgroundCallback(_backgroundData, x, row, width, _backgroundRow);
+                copyCanvasSpan(_frameBuffer + row * stride, _backgroundRow, x, width);
+            }
+            return;
+        }
+        
+        // No background source, fill with the GIF background color
+        uint32_t value = 0;
+        const uint8_t* colorTable = _globalColorTable;
+        if (colorTable && _backgroundColor < _globalColorTableSize) {
+            const uint8_t* rgb = colorTable + _backgroundColor * 3;
+            uint8_t corrected[3];
+            if (_correction) {
+                correctColor(rgb, corrected);
+                rgb = corrected;
+            }
+            value = convertColor(rgb[0], rgb[1], rgb[2]);
+            if (_device) {
+                value = _device->lut[nearestDeviceColor(rgb[0], rgb[1], rgb[2])];
+            } else if (_pixelFormat == PixelFormat::INDEXED8) {
+                value = _backgroundColor;
+            }
+        }
+        if (_pixelFormat == PixelFormat::ARGB8888) {
+            value &= 0x00FFFFFF; // Disposed area is transparent
+        }
+        
+        for (uint16_t row = y; row < y + height; row++) {
+            for (uint16_t col = x; col < x + width; col++) {
+                storePixel(col, row, value);
+            }
+        }
+    }
+    
+    void savePrevious(uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+        // Keep the area covered by a "restore to previous" frame
+        if (!_previousFrame) {
+            _previousFrame = (uint8_t*)ESP32_GIF_Utils::allocateMemory(frameBufferSize(), _usePSRAM);
+            if (!_previousFrame) return;
+        }
+        if (_alphaMask && !_previousMask) {
+            _previousMask = (uint8_t*)ESP32_GIF_Utils::allocateMemory(maskStride() * _canvasHeight, false);
+        }
+        for (uint16_t row = y; row < y + height; row++) {
+            copyCanvasSpan(_previousFrame + row * canvasStride(), _frameBuffer + row * canvasStride(), x, width);
+            if (_alphaMask && _previousMask) {
+                copyBits(_previousMask + row * maskStride(), _alphaMask + row * maskStride(), x, width);
+            }
+        }
+    }
+    
+    void copyCanvasSpan(uint8_t* dstRow, const uint8_t* srcRow, uint16_t x, uint16_t width) {
+        // Copy pixels x..x+width-1 between rows of the canvas layout; pixels
+        // are addressed as MSB-first bit ranges, which covers every format
+        uint8_t bpp = ESP32_GIF_Utils::bitsPerPixel(_pixelFormat);
+        copyBits(dstRow, srcRow, (size_t)x * bpp, (size_t)width * bpp);
+    }
+    
+    static void fillBits(uint8_t* dstRow, size_t firstBit, size_t bitCount, bool set) {
+        if (bitCount == 0) return;
+        size_t lastBit = firstBit + bitCount - 1;
+        size_t first = firstBit >> 3;
+        size_t last = lastBit >> 3;
+        uint8_t headMask = 0xFF >> (firstBit & 7);
+        uint8_t tailMask = 0xFF << (7 - (lastBit & 7));
+        uint8_t fill = set ? 0xFF : 0x00;
+        
+        if (first == last) {
+            uint8_t mask = headMask & tailMask;
+            dstRow[first] = (dstRow[first] & ~mask) | (fill & mask);
+            return;
+        }
+        dstRow[first] = (dstRow[first] & ~headMask) | (fill & headMask);
+        memset(dstRow + first + 1, fill, last - first - 1);
+        dstRow[last] = (dstRow[last] & ~tailMask) | (fill & tailMask);
+    }
+    
+    static void copyBits(uint8_t* dstRow, const uint8_t* srcRow, size_t firstBit, size_t bitCount) {
+        if (bitCount == 0) return;
+        size_t lastBit = firstBit + bitCount - 1;
+        size_t first = firstBit >> 3;
+        size_t last = lastBit >> 3;
+        uint8_t headMask = 0xFF >> (firstBit & 7);
+        uint8_t tailMask = 0xFF << (7 - (lastBit & 7));
+        
+        if (first == last) {
+            uint8_t mask = headMask & tailMask;
+            dstRow[first] = (dstRow[first] & ~mask) | (srcRow[first] & mask);
+            return;
+        }
+        dstRow[first] = (dstRow[first] & ~headMask) | (srcRow[first] & headMask);
+        memcpy(dstRow + first + 1, srcRow + first + 1, last - first - 1);
+        dstRow[last] = (dstRow[last] & ~tailMask) | (srcRow[last] & tailMask);
+    }
+    
+    const uint8_t* activeColorTable(uint16_t& size) const {
+        if (_localColorTable) {
+            size = _localColorTableSize;
+            return _localColorTable;
+        }
+        size = _globalColorTableSize;
+        return _globalColorTable;
+    }
+    
+    const uint8_t* updatePalette(const uint8_t* colorTable, uint16_t colorTableSize) {
+        // Rebuild the conversion LUTs only when the active palette changes,
+        // so pixels are converted with a single table lookup. Returns the
+        // color table the frame is rendered with (color corrected if set).
+        const GIFBundlePalette* bundled = bundlePalette(colorTableSize);
+        if (bundled) {
+            return useBundlePalette(bundled, colorTable, colorTableSize);
+        }
+        
+        // The cache key is the whole table, not a hash of it: a collision
+        // would render a frame with the previous palette
+        uint32_t key = _hasTransparency ? _transparentIndex : 0x100;
+        size_t tableBytes = (size_t)colorTableSize * 3;
+        
+        if (_paletteValid && !_paletteBundled && key == _paletteKey && colorTableSize == _paletteSize &&
+            memcmp(colorTable, _paletteTable, tableBytes) == 0) {
+            GIF_STATS(_frameStats.paletteCacheHits++);
+            return _correction ? _correction->table : colorTable;
+        }
+        GIF_STATS(_frameStats.paletteCacheMisses++);
+        _paletteValid = true;
+        _paletteBundled = false;
+        _paletteKey = key;
+        _paletteSize = colorTableSize;
+        memcpy(_paletteTable, colorTable, tableBytes);
+        
+        if (_correction) {
+            // Correction costs at most 256 entries per palette change, never per pixel
+            for (uint16_t i = 0; i < colorTableSize * 3; i += 3) {
+                correctColor(colorTable + i, _correction->table + i);
+            }
+            colorTable = _correction->table;
+        }
+        
+        if (_device) {
+            updateDevicePalette(colorTable, colorTableSize);
+            return colorTable;
+        }
+        
+        for (uint16_t i = 0; i < colorTableSize; i++) {
+            const uint8_t* rgb = colorTable + i * 3;
+            uint16_t rgb565 = ESP32_GIF_Utils::rgb888To565(rgb[0], rgb[1], rgb[2]);
+            
+            if (_pixelFormat == PixelFormat::INDEXED8) {
+                _paletteLUT[i] = i;
+                _pixelLUT[i] = i;
+            } else {
+                _paletteLUT[i] = convertColor(rgb[0], rgb[1], rgb[2]);
+                _pixelLUT[i] = rgb565;
+            }
+            _streamPalette[i] = rgb565;
+        }
+        for (uint16_t i = colorTableSize; i < 256; i++) {
+            // Indices past the end of the table are black, not left over
+            // from the previous palette
+            _paletteLUT[i] = (_pixelFormat == PixelFormat::INDEXED8) ? i : convertColor(0, 0, 0);
+            _pixelLUT[i] = (_pixelFormat == PixelFormat::INDEXED8) ? i : 0;
+            _streamPalette[i] = 0;
+        }
+        
+        deliverPalette(colorTable, colorTableSize);
+        return colorTable;
+    }
+    
+    const GIFBundlePalette* bundlePalette(uint16_t colorTableSize) const {
+        // The bundle LUTs are only valid for the settings they were converted with
+        if (!_bundle || !_bundle->palettes || _correction || _device ||
+            _bundle->format != _pixelFormat || _bundle->dither != _ditherMode) {
+            return nullptr;
+        }
+        uint16_t index = _bundle->frames[_currentFrame].palette;
+        if (index >= _bundle->paletteCount || _bundle->palettes[index].size != colorTableSize) {
+            return nullptr;
+        }
+        return &_bundle->palettes[index];
+    }
+    
+    const uint8_t* useBundlePalette(const GIFBundlePalette* palette, const uint8_t* colorTable,
+                                    uint16_t colorTableSize) {
+        // Copy the converted LUTs; the palette event still depends on the
+        // transparent index, so it is part of the cache key
+        uint32_t key = (uint32_t)(palette - _bundle->palettes) << 9 | (_hasTransparency ? _transparentIndex : 0x100);
+        if (_paletteValid && _paletteBundled && key == _paletteKey) {
+            GIF_STATS(_frameStats.paletteCacheHits++);
+            return colorTable;
+        }
+        GIF_STATS(_frameStats.paletteCacheMisses++);
+        _paletteValid = true;
+        _paletteBundled = true;
+        _paletteKey = key;
+        _paletteSize = colorTableSize;
+        
+        const bool indexed = _pixelFormat == PixelFormat::INDEXED8;
+        for (uint16_t i = 0; i < 256; i++) {
+            bool inTable = i < colorTableSize;
+            _paletteLUT[i] = indexed ? i : inTable ? palette->canvas[i] : _bundle->black;
+            _streamPalette[i] = inTable ? palette->rgb565[i] : 0;
+            _pixelLUT[i] = indexed ? i : _streamPalette[i];
+        }
+        
+        deliverPalette(colorTable, colorTableSize);
+        return colorTable;
+    }
+    
+    void deliverPalette(const uint8_t* colorTable, uint16_t colorTableSize) {
+        if (_paletteCallback && _paletteEvent) {
+            uint8_t bytes = ESP32_GIF_Utils::bitsPerPixel(_paletteFormat) / 8;
+            for (uint16_t i = 0; i < colorTableSize; i++) {
+                const uint8_t* rgb = colorTable + i * 3;
+                bool transparent = _hasTransparency && i == _transparentIndex;
+                ESP32_GIF_Utils::packColor(_paletteEvent + i * bytes, _paletteFormat,
+                                           rgb[0], rgb[1], rgb[2], transparent ? 0x00 : 0xFF);
+            }
+            _paletteCallback(_paletteCallbackData, _paletteEvent, colorTableSize, _paletteFormat);
+        }
+    }
+    
+    bool allocateCorrection() {
+        if (!_correction) {
+            _correction = (ColorCorrectionState*)ESP32_GIF_Utils::allocateMemory(sizeof(ColorCorrectionState), false);
+            if (!_correction) {
+                _lastError = GIFError::OUT_OF_MEMORY;
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    void updateCorrectionCurve() {
+        for (uint16_t i = 0; i < 256; i++) {
+            _correction->curve[i] = (_correction->gammaCurve[i] * _correction->brightness + 127) / 255;
+        }
+    }
+    
+    void correctColor(const uint8_t* rgb, uint8_t* out) const {
+        // Matrix (white balance, channel mixing), then gamma and brightness curve
+        if (_correction->identityMatrix) {
+            out[0] = _correction->curve[rgb[0]];
+            out[1] = _correction->curve[rgb[1]];
+            out[2] = _correction->curve[rgb[2]];
+            return;
+        }
+        
+        const int16_t* m = _correction->matrix;
+        uint8_t r = rgb[0], g = rgb[1], b = rgb[2];
+        for (uint8_t c = 0; c < 3; c++) {
+            int32_t value = (m[c * 3] * r + m[c * 3 + 1] * g + m[c * 3 + 2] * b + 128) >> 8;
+            out[c] = _correction->curve[std::max<int32_t>(0, std::min<int32_t>(value, 255))];
+        }
+    }
+    
+    void updateDevicePalette(const uint8_t* colorTable, uint16_t colorTableSize) {
+        // Device colors in the canvas format; the GIF palette LUTs then point
+        // straight at the nearest device color of every GIF index
+        for (uint16_t d = 0; d < _device->count; d++) {
+            const uint8_t* rgb = _device->palette + d * 3;
+            _device->stream565[d] = ESP32_GIF_Utils::rgb888To565(rgb[0], rgb[1], rgb[2]);
+            if (_pixelFormat == PixelFormat::INDEXED8) {
+                _device->lut[d] = d;
+                _device->pixelLUT[d] = d;
+            } else {
+                _device->lut[d] = convertColor(rgb[0], rgb[1], rgb[2]);
+                _device->pixelLUT[d] = _device->stream565[d];
+            }
+        }
+        
+        const uint8_t* map = deviceRemap(colorTable, colorTableSize);
+        for (uint16_t i = 0; i < colorTableSize; i++) {
+            uint8_t d = map[i];
+            _paletteLUT[i] = _device->lut[d];
+            _pixelLUT[i] = _device->pixelLUT[d];
+            _streamPalette[i] = _device->stream565[d];
+        }
+        
+        if (_paletteCallback && _paletteEvent && _paletteEventPending) {
+            // Indices refer to the device palette, deliver it once
+            uint8_t bytes = ESP32_GIF_Utils::bitsPerPixel(_paletteFormat) / 8;
+            for (uint16_t d = 0; d < _device->count; d++) {
+                const uint8_t* rgb = _device->palette + d * 3;
+                ESP32_GIF_Utils::packColor(_paletteEvent + d * bytes, _paletteFormat, rgb[0], rgb[1], rgb[2]);
+            }
+            _paletteCallback(_paletteCallbackData, _paletteEvent, _device->count, _paletteFormat);
+        }
+        _paletteEventPending = false;
+    }
+    
+    const uint8_t* deviceRemap(const uint8_t* colorTable, uint16_t colorTableSize) {
+        // GIF index -> nearest device index, at most 256 searches per palette.
+        // Two maps are cached so global and local palettes can alternate.
+        size_t tableBytes = (size_t)colorTableSize * 3;
+        for (uint8_t slot = 0; slot < 2; slot++) {
+            if (_device->cacheValid[slot] && _device->cacheSize[slot] == colorTableSize &&
+                memcmp(_device->cacheTable[slot], colorTable, tableBytes) == 0) {
+                return _device->cacheMap[slot];
+            }
+        }
+        
+        uint8_t slot = _device->cacheNext;
+        _device->cacheNext ^= 1;
+        _device->cacheValid[slot] = true;
+        _device->cacheSize[slot] = colorTableSize;
+        memcpy(_device->cacheTable[slot], colorTable, tableBytes);
+        
+        uint8_t* map = _device->cacheMap[slot];
+        for (uint16_t i = 0; i < colorTableSize; i++) {
+            const uint8_t* rgb = colorTable + i * 3;
+            map[i] = nearestDeviceColor(rgb[0], rgb[1], rgb[2]);
+        }
+        return map;
+    }
+    
+    uint8_t nearestDeviceColor(int16_t r, int16_t g, int16_t b) const {
+        // Weighted RGB distance (2:4:3), close to perceptual for small palettes
+        uint32_t bestDistance = 0xFFFFFFFF;
+        uint8_t best = 0;
+        for (uint16_t d = 0; d < _device->count; d++) {
+            const uint8_t* rgb = _device->palette + d * 3;
+            int32_t dr = r - rgb[0];
+            int32_t dg = g - rgb[1];
+            int32_t db = b - rgb[2];
+            uint32_t distance = 2 * dr * dr + 4 * dg * dg + 3 * db * db;
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = d;
+            }
+        }
+        return best;
+    }
+    
+    bool prepareDiffusion(const uint8_t* colorTable) {
+        // Error diffusion needs the nearest device color of arbitrary RGB
+        // values; a 16x16x16 inverse cube keeps that to a lookup
+        if (!_device || _ditherMode != DitherMode::ERROR_DIFFUSION) return false;
+        
+        if (!_deviceCube) {
+            _deviceCube = (uint8_t*)ESP32_GIF_Utils::allocateMemory(4096, _usePSRAM);
+            if (!_deviceCube) return false;
+            for (uint16_t i = 0; i < 4096; i++) {
+                _deviceCube[i] = nearestDeviceColor(((i >> 8) << 4) | 8, (((i >> 4) & 0x0F) << 4) | 8,
+                                                    ((i & 0x0F) << 4) | 8);
+            }
+        }
+        
+        size_t errorRow = ((size_t)_canvasWidth + 2) * 3;
+        if (!_diffusionErrors) {
+            _diffusionErrors = (int16_t*)ESP32_GIF_Utils::allocateMemory(errorRow * 2 * sizeof(int16_t), false);
+        }
+        if (!_remapBuffer) {
+            _remapBuffer = (uint8_t*)ESP32_GIF_Utils::allocateMemory(_canvasWidth, false);
+        }
+        if (!_diffusionErrors || !_remapBuffer) return false;
+        
+        memset(_diffusionErrors, 0, errorRow * 2 * sizeof(int16_t));
+        _diffusionTable = colorTable;
+        _diffusionRow = 0;
+        return true;
+    }
+    
+    void diffuseRow(uint16_t width) {
+        // Floyd-Steinberg, streamed one row at a time into _remapBuffer
+        size_t errorRow = ((size_t)_canvasWidth + 2) * 3;
+        int16_t* current = _diffusionErrors + (_diffusionRow & 1) * errorRow;
+        int16_t* next = _diffusionErrors + ((_diffusionRow + 1) & 1) * errorRow;
+        memset(next, 0, errorRow * sizeof(int16_t));
+        _diffusionRow++;
+        
+        for (uint16_t x = 0; x < width; x++) {
+            uint8_t colorIndex = _lineBuffer[x];
+            if (_hasTransparency && colorIndex == _transparentIndex) {
+                _remapBuffer[x] = 255;
+                continue;
+            }
+            
+            const uint8_t* rgb = _diffusionTable + colorIndex * 3;
+            int16_t* e = current + (x + 1) * 3;
+            int16_t r = std::max(0, std::min(255, rgb[0] + e[0] / 16));
+            int16_t g = std::max(0, std::min(255, rgb[1] + e[1] / 16));
+            int16_t b = std::max(0, std::min(255, rgb[2] + e[2] / 16));
+            
+            uint8_t d = _deviceCube[((r >> 4) << 8) | ((g >> 4) << 4) | (b >> 4)];
+            _remapBuffer[x] = d;
+            
+            const uint8_t* device = _device->palette + d * 3;
+            int16_t error[3] = { (int16_t)(r - device[0]), (int16_t)(g - device[1]), (int16_t)(b - device[2]) };
+            int16_t* below = next + x * 3;
+            for (uint8_t c = 0; c < 3; c++) {
+                e[3 + c] += error[c] * 7;
+                below[c] += error[c] * 3;
+                below[3 + c] += error[c] * 5;
+                below[6 + c] += error[c];
+            }
+        }
+    }
+    
+    void freeDiffusionBuffers() {
+        if (_diffusionErrors) {
+            ESP32_GIF_Utils::freeMemory(_diffusionErrors);
+            _diffusionErrors = nullptr;
+        }
+        
+        if (_remapBuffer) {
+            ESP32_GIF_Utils::freeMemory(_remapBuffer);
+            _remapBuffer = nullptr;
+        }
+        _diffusing = false;
+    }
+    
+    void freeDevicePalette() {
+        freeDiffusionBuffers();
+        
+        if (_deviceCube) {
+            ESP32_GIF_Utils::freeMemory(_deviceCube);
+            _deviceCube = nullptr;
+        }
+        
+        if (_device) {
+            ESP32_GIF_Utils::freeMemory(_device);
+            _device = nullptr;
+        }
+    }
+    
+    uint32_t convertColor(uint8_t r, uint8_t g, uint8_t b) const {
+        // Color value in the canvas format
+        return ESP32_GIF_Utils::convertColor(_pixelFormat, _ditherMode, r, g, b);
+    }
+    
+    void renderRow(uint16_t y, uint16_t width, bool resolved) {
+        // Render one clipped row of palette indices from the line buffer;
+        // resolved rows are emitted later from the canvas instead
+        uint16_t canvasY = y + _frameY;
+        const uint8_t* indices = _lineBuffer;
+        const uint32_t* lut = _paletteLUT;
+        const uint16_t* pixelLUT = _pixelLUT;
+        const uint16_t* streamPalette = _streamPalette;
+        int16_t transparentIndex = _hasTransparency ? _transparentIndex : -1;
+        
+        if (_diffusing) {
+            // Row of device indices, 255 marks transparent pixels
+            GIF_STATS(enterStage(STAGE_CONVERT));
+            diffuseRow(width);
+            indices = _remapBuffer;
+            lut = _device->lut;
+            pixelLUT = _device->pixelLUT;
+            streamPalette = _device->stream565;
+            transparentIndex = _hasTransparency ? 255 : -1;
+        }
+        
+        if (_pixelCallback && !resolved) {
+            GIF_STATS(enterStage(STAGE_OUTPUT));
+            uint32_t begin = ESP32_GIF_Platform::micros();
+            for (uint16_t x = 0; x < width; x++) {
+                uint8_t colorIndex = indices[x];
+                if (colorIndex == transparentIndex) continue;
+                _pixelCallback(_callbackData, x + _frameX, canvasY, pixelLUT[colorIndex]);
+            }
+            _outputMicros += ESP32_GIF_Platform::micros() - begin;
+        }
+        
+        GIF_STATS(enterStage(STAGE_COMPOSE));
+        uint8_t bpp = ESP32_GIF_Utils::bitsPerPixel(_pixelFormat);
+        if (bpp < 8) {
+            writeRowPacked(canvasY, width, bpp, indices, lut, transparentIndex);
+        } else if (_pixelFormat == PixelFormat::RGB444) {
+            writeRowRGB444(canvasY, width, indices, lut, transparentIndex);
+        } else {
+            for (uint16_t x = 0; x < width; x++) {
+                uint8_t colorIndex = indices[x];
+                if (colorIndex == transparentIndex) continue;
+                storePixel(x + _frameX, canvasY, lut[colorIndex]);
+            }
+        }
+        
+        if (_alphaMask) {
+            markOpaque(canvasY, width, indices, transparentIndex);
+        }
+        
+        if (resolved || !hasSpanOutput()) return;
+        
+        GIF_STATS(enterStage(STAGE_OUTPUT));
+        GIF_STATS(countEmitted(width));
+        uint32_t begin = ESP32_GIF_Platform::micros();
+        if (_frameCallback) {
+            emitSpan(_frameX, canvasY, width);
+        }
+        
+        if (_maskCallback && _alphaMask) {
+            emitMaskSpan(_frameX, canvasY, width);
+        }
+        
+        if (_stream.isEnabled()) {
+            _stream.writeRow(indices, width, streamPalette, transparentIndex);
+        }
+        _outputMicros += ESP32_GIF_Platform::micros() - begin;
+    }
+    
+    bool hasSpanOutput() const {
+        return _frameCallback || _maskCallback || _stream.isEnabled();
+    }
+    
+    void emitCanvasRow(uint16_t x, uint16_t y, uint16_t width) {
+        // One fully resolved span from the composed canvas to every output
+        if (!_pixelCallback && !hasSpanOutput()) return;
+        
+        uint32_t begin = ESP32_GIF_Platform::micros();
+        if (_pixelCallback) {
+            for (uint16_t i = 0; i < width; i++) {
+                uint32_t value = readPixel(x + i, y);
+                uint16_t color = (_pixelFormat == PixelFormat::INDEXED8) ? value : canvasToRGB565(value);
+                _pixelCallback(_callbackData, x + i, y, color);
+            }
+        }
+        
+        if (_frameCallback) {
+            emitSpan(x, y, width);
+        }
+        
+        if (_maskCallback && _alphaMask) {
+            emitMaskSpan(x, y, width);
+        }
+        
+        if (_stream.isEnabled() && _colorRow) {
+            for (uint16_t i = 0; i < width; i++) {
+                _colorRow[i] = canvasToRGB565(readPixel(x + i, y));
+            }
+            _stream.writeColors(_colorRow, width);
+        }
+        _outputMicros += ESP32_GIF_Platform::micros() - begin;
+    }
+    
+    void writeRowPacked(uint16_t canvasY, uint16_t width, uint8_t bpp,
+                        const uint8_t* indices, const uint32_t* lut, int16_t transparentIndex) {
+        // Assemble 8 / bpp pixels per byte (MSB first) and store each byte
+        // once; transparent pixels are kept through the write mask
+        const bool dither = (_ditherMode == DitherMode::ORDERED);
+        const uint8_t* threshold = ESP32_GIF_Utils::bayerRow(canvasY);
+        const uint8_t maxLevel = (1 << bpp) - 1;
+        
+        uint16_t canvasX = _frameX;
+        uint8_t* dst = _frameBuffer + canvasY * canvasStride() + (((size_t)canvasX * bpp) >> 3);
+        uint8_t shift = 8 - bpp - ((canvasX * bpp) & 7);
+        uint8_t bits = 0;
+        uint8_t mask = 0;
+        
+        for (uint16_t x = 0; x < width; x++, canvasX++) {
+            uint8_t colorIndex = indices[x];
+            if (colorIndex != transparentIndex) {
+                uint8_t level = lut[colorIndex];
+                if (dither) {
+                    level = (level * maxLevel + threshold[canvasX & 7]) / 255;
+                }
+                mask |= maxLevel << shift;
+                bits |= level << shift;
+            }
+            
+            if (shift == 0) {
+                *dst = (mask == 0xFF) ? bits : ((*dst & ~mask) | (bits & mask));
+                dst++;
+                shift = 8 - bpp;
+                bits = 0;
+                mask = 0;
+            } else {
+                shift -= bpp;
+            }
+        }
+        
+        if (mask) {
+            *dst = (*dst & ~mask) | (bits & mask);
+        }
+    }
+    
+    void writeRowRGB444(uint16_t canvasY, uint16_t width,
+                        const uint8_t* indices, const uint32_t* lut, int16_t transparentIndex) {
+        // Two pixels per 3 bytes: R1G1 B1R2 G2B2
+        uint8_t* row = _frameBuffer + canvasY * canvasStride();
+        
+        for (uint16_t x = 0; x < width; x++) {
+            uint8_t colorIndex = indices[x];
+            if (colorIndex == transparentIndex) continue;
+            
+            uint16_t canvasX = _frameX + x;
+            uint16_t value = lut[colorIndex];
+            uint8_t* p = row + (canvasX >> 1) * 3;
+            if (canvasX & 1) {
+                p[1] = (p[1] & 0xF0) | (value >> 8);
+                p[2] = value & 0xFF;
+            } else {
+                p[0] = value >> 4;
+                p[1] = (p[1] & 0x0F) | ((value & 0x0F) << 4);
+            }
+        }
+    }
+    
+    void emitSpan(uint16_t x, uint16_t y, uint16_t width) {
+        // Partial update with a composed canvas row; packed formats are
+        // widened to whole bytes so the span starts on a byte boundary
+        uint8_t bpp = ESP32_GIF_Utils::bitsPerPixel(_pixelFormat);
+        if (bpp % 8) {
+            // Smallest pixel group ending on a byte boundary (8 for 1 bpp, 2 for 12 bpp)
+            uint8_t group = (bpp & 1) ? 8 : (bpp & 2) ? 4 : 2;
+            uint16_t end = std::min<uint32_t>(_canvasWidth,
+                ((uint32_t)x + width + group - 1) / group * group);
+            x -= x % group;
+            width = end - x;
+        }
+        
+        const uint8_t* row = _frameBuffer + y * canvasStride() + ((size_t)x * bpp) / 8;
+        _frameCallback(_frameCallbackData, x, y, width, 1, row);
+    }
+    
+    void markOpaque(uint16_t canvasY, uint16_t width, const uint8_t* indices, int16_t transparentIndex) {
+        // Opaque pixels of the frame become covered, transparent ones keep
+        // the coverage of what is underneath
+        uint8_t* row = _alphaMask + canvasY * maskStride();
+        if (transparentIndex < 0) {
+            fillBits(row, _frameX, width, true);
+            return;
+        }
+        for (uint16_t x = 0; x < width; x++) {
+            if (indices[x] == transparentIndex) continue;
+            uint16_t canvasX = _frameX + x;
+            row[canvasX >> 3] |= 0x80 >> (canvasX & 7);
+        }
+    }
+    
+    void emitMaskSpan(uint16_t x, uint16_t y, uint16_t width) {
+        // Mask bytes of a span widened to whole bytes (multiples of 8 pixels)
+        uint16_t end = std::min<uint32_t>(_canvasWidth, ((uint32_t)x + width + 7) & ~7u);
+        x &= ~7;
+        _maskCallback(_maskCallbackData, x, y, end - x, _alphaMask + y * maskStride() + (x >> 3));
+    }
+    
+    void beginStreamFrame(uint16_t frame, uint16_t colorTableSize, uint16_t x, uint16_t y,
+                          uint16_t width, uint16_t height, bool resolved) {
+        if (!_stream.isEnabled()) return;
+        
+        _stream.beginFrame(frame, _canvasWidth, _canvasHeight);
+        if (resolved) {
+            // Background and restored pixels have no palette index
+            if (!_colorRow) {
+                _colorRow = (uint16_t*)ESP32_GIF_Utils::allocateMemory(_canvasWidth * sizeof(uint16_t), false);
+            }
+            if (!_colorRow) width = height = 0;
+            _stream.beginRect(x, y, width, height, StreamEncoding::RLE_RGB565);
+            return;
+        }
+        
+        if (_diffusing) {
+            _stream.writePalette(_device->stream565, _device->count);
+        } else {
+            _stream.writePalette(_streamPalette, colorTableSize);
+        }
+        _stream.beginRect(x, y, width, height);
+    }
+    
+    void storePixel(uint16_t x, uint16_t y, uint32_t value) {
+        // Store a converted color value in the frame buffer
+        if (!_frameBuffer || x >= _canvasWidth || y >= _canvasHeight) return;
+        
+        size_t offset = (y * _canvasWidth + x);
+        
+        switch (_pixelFormat) {
+            case PixelFormat::RGB565_LE: {
+                _frameBuffer[offset * 2] = value & 0xFF;
+                _frameBuffer[offset * 2 + 1] = value >> 8;
+                break;
+            }
+            case PixelFormat::RGB565_BE: {
+                _frameBuffer[offset * 2] = value >> 8;
+                _frameBuffer[offset * 2 + 1] = value & 0xFF;
+                break;
+            }
+            case PixelFormat::RGB888: {
+                _frameBuffer[offset * 3] = value >> 16;
+                _frameBuffer[offset * 3 + 1] = value >> 8;
+                _frameBuffer[offset * 3 + 2] = value;
+                break;
+            }
+            case PixelFormat::ARGB8888: {
+                _frameBuffer[offset * 4] = value >> 24; // Alpha
+                _frameBuffer[offset * 4 + 1] = value >> 16;
+                _frameBuffer[offset * 4 + 2] = value >> 8;
+                _frameBuffer[offset * 4 + 3] = value;
+                break;
+            }
+            case PixelFormat::GRAYSCALE_8BIT:
+            case PixelFormat::INDEXED8:
+            case PixelFormat::RGB332: {
+                _frameBuffer[offset] = value;
+                break;
+            }
+            case PixelFormat::RGB444: {
+                uint8_t* p = _frameBuffer + y * canvasStride() + (x >> 1) * 3;
+                if (x & 1) {
+                    p[1] = (p[1] & 0xF0) | (value >> 8);
+                    p[2] = value & 0xFF;
+                } else {
+                    p[0] = value >> 4;
+                    p[1] = (p[1] & 0x0F) | ((value & 0x0F) << 4);
+                }
+                break;
+            }
+            case PixelFormat::MONOCHROME_1BIT:
+            case PixelFormat::GRAY4:
+            case PixelFormat::GRAY2: {
+                // Packed MSB first, value is the level (gray when dithering)
+                uint8_t bpp = ESP32_GIF_Utils::bitsPerPixel(_pixelFormat);
+                uint8_t maxLevel = (1 << bpp) - 1;
+                if (_ditherMode == DitherMode::ORDERED) {
+                    value = (value * maxLevel + ESP32_GIF_Utils::bayerRow(y)[x & 7]) / 255;
+                }
+                size_t bitOffset = (size_t)x * bpp;
+                uint8_t shift = 8 - bpp - (bitOffset & 7);
+                uint8_t& byte = _frameBuffer[y * canvasStride() + (bitOffset >> 3)];
+                byte = (byte & ~(maxLevel << shift)) | ((value & maxLevel) << shift);
+                break;
+            }
+        }
+    }
+    
+    uint32_t readPixel(uint16_t x, uint16_t y) const {
+        // Canvas value of one pixel (levels for the packed gray formats)
+        const uint8_t* row = _frameBuffer + y * canvasStride();
+        switch (_pixelFormat) {
+            case PixelFormat::RGB565_LE:
+                return row[x * 2] | (row[x * 2 + 1] << 8);
+            case PixelFormat::RGB565_BE:
+                return (row[x * 2] << 8) | row[x * 2 + 1];
+            case PixelFormat::RGB888:
+                return ((uint32_t)row[x * 3] << 16) | (row[x * 3 + 1] << 8) | row[x * 3 + 2];
+            case PixelFormat::ARGB8888:
+                return ((uint32_t)row[x * 4] << 24) | ((uint32_t)row[x * 4 + 1] << 16) |
+                       (row[x * 4 + 2] << 8) | row[x * 4 + 3];
+            case PixelFormat::GRAYSCALE_8BIT:
+            case PixelFormat::INDEXED8:
+            case PixelFormat::RGB332:
+                return row[x];
+            case PixelFormat::RGB444: {
+                const uint8_t* p = row + (x >> 1) * 3;
+                return (x & 1) ? ((p[1] & 0x0F) << 8) | p[2] : (p[0] << 4) | (p[1] >> 4);
+            }
+            default: {
+                uint8_t bpp = ESP32_GIF_Utils::bitsPerPixel(_pixelFormat);
+                size_t bitOffset = (size_t)x * bpp;
+                uint8_t shift = 8 - bpp - (bitOffset & 7);
+                return (row[bitOffset >> 3] >> shift) & ((1 << bpp) - 1);
+            }
+        }
+    }
+    
+    uint16_t canvasToRGB565(uint32_t value) const {
+        // RGB565 of a canvas value, indices go through the active palette
+        switch (_pixelFormat) {
+            case PixelFormat::RGB565_LE:
+            case PixelFormat::RGB565_BE:
+                return value;
+            case PixelFormat::RGB888:
+            case PixelFormat::ARGB8888:
+                return ESP32_GIF_Utils::rgb888To565(value >> 16, value >> 8, value);
+            case PixelFormat::GRAYSCALE_8BIT:
+                return ESP32_GIF_Utils::rgb888To565(value, value, value);
+            case PixelFormat::INDEXED8:
+                return _device ? _device->stream565[value] : _streamPalette[value];
+            case PixelFormat::RGB332:
+                return ESP32_GIF_Utils::rgb888To565((value & 0xE0) * 255 / 0xE0,
+                                                    ((value << 3) & 0xE0) * 255 / 0xE0,
+                                                    (value & 0x03) * 85);
+            case PixelFormat::RGB444:
+                return ESP32_GIF_Utils::rgb888To565(((value >> 8) & 0x0F) * 17,
+                                                    ((value >> 4) & 0x0F) * 17, (value & 0x0F) * 17);
+            default: {
+                uint8_t maxLevel = (1 << ESP32_GIF_Utils::bitsPerPixel(_pixelFormat)) - 1;
+                uint8_t gray = value * 255 / maxLevel;
+                return ESP32_GIF_Utils::rgb888To565(gray, gray, gray);
+            }
+        }
+    }
+};
+
+// Public class implementation
+ESP32_AnimatedGIF::ESP32_AnimatedGIF() : _impl(new Impl()) {}
+
+ESP32_AnimatedGIF::~ESP32_AnimatedGIF() {
+    delete _impl;
+}
+
+bool ESP32_AnimatedGIF::begin(PixelFormat pixelFormat, bool usePSRAM) {
     return _impl->begin(pixelFormat, usePSRAM);
 }
 
@@ -828,6 +2783,28 @@ GIFError ESP32_AnimatedGIF::load(DataReader reader, void* userData) {
     return _impl->load(reader, userData);
 }
 
+GIFError ESP32_AnimatedGIF::loadBundle(const GIFBundle& bundle) {
+    return _impl->loadBundle(bundle);
+}
+
+GIFError ESP32_AnimatedGIF::loadPrerenderedFromMemory(const uint8_t* data, uint32_t length) {
+    return _impl->loadPrerenderedFromMemory(data, length);
+}
+
+GIFError ESP32_AnimatedGIF::loadPrerendered(DataReader reader, void* userData) {
+    return _impl->loadPrerendered(reader, userData);
+}
+
+GIFError ESP32_AnimatedGIF::estimateFromMemory(const uint8_t* data, uint32_t length, GIFEstimate& estimate,
+                                               const GIFCalibration* calibration) {
+    return _impl->estimateFromMemory(data, length, estimate, calibration);
+}
+
+GIFError ESP32_AnimatedGIF::estimate(DataReader reader, void* userData, GIFEstimate& estimate,
+                                     const GIFCalibration* calibration) {
+    return _impl->estimateLayout(reader, userData, estimate, calibration);
+}
+
 void ESP32_AnimatedGIF::setDisplaySize(uint16_t width, uint16_t height) {
     _impl->setDisplaySize(width, height);
 }
@@ -840,6 +2817,42 @@ void ESP32_AnimatedGIF::setPixelCallback(PixelCallback callback, void* userData)
     _impl->setPixelCallback(callback, userData);
 }
 
+void ESP32_AnimatedGIF::setPaletteCallback(PaletteCallback callback, void* userData, PixelFormat paletteFormat) {
+    _impl->setPaletteCallback(callback, userData, paletteFormat);
+}
+
+void ESP32_AnimatedGIF::setStreamWriter(StreamWriter writer, void* userData, StreamEncoding encoding) {
+    _impl->setStreamWriter(writer, userData, encoding);
+}
+
+bool ESP32_AnimatedGIF::getStreamStats(StreamStats& stats) const {
+    return _impl->getStreamStats(stats);
+}
+
+bool ESP32_AnimatedGIF::getFrameStats(GIFStats& stats) const {
+    return _impl->getFrameStats(stats);
+}
+
+bool ESP32_AnimatedGIF::getStats(GIFStats& stats) const {
+    return _impl->getStats(stats);
+}
+
+void ESP32_AnimatedGIF::resetStats() {
+    _impl->resetStats();
+}
+
+bool ESP32_AnimatedGIF::getPacingStats(PacingStats& stats) const {
+    return _impl->getPacingStats(stats);
+}
+
+void ESP32_AnimatedGIF::setPacingTolerance(uint16_t ms) {
+    _impl->setPacingTolerance(ms);
+}
+
+void ESP32_AnimatedGIF::setPacingCallback(PacingCallback callback, void* userData) {
+    _impl->setPacingCallback(callback, userData);
+}
+
 bool ESP32_AnimatedGIF::getInfo(GIFInfo& info) {
     return _impl->getInfo(info);
 }
@@ -894,6 +2907,42 @@ void ESP32_AnimatedGIF::setLoop(bool loop) {
     _impl->setLoop(loop);
 }
 
+void ESP32_AnimatedGIF::setDither(DitherMode mode) {
+    _impl->setDither(mode);
+}
+
+bool ESP32_AnimatedGIF::setDevicePalette(const uint8_t* palette, uint16_t count) {
+    return _impl->setDevicePalette(palette, count);
+}
+
+void ESP32_AnimatedGIF::setBackground(const uint8_t* image) {
+    _impl->setBackground(image);
+}
+
+void ESP32_AnimatedGIF::setBackgroundCallback(BackgroundCallback callback, void* userData) {
+    _impl->setBackgroundCallback(callback, userData);
+}
+
+void ESP32_AnimatedGIF::setAlphaMask(bool enable) {
+    _impl->setAlphaMask(enable);
+}
+
+void ESP32_AnimatedGIF::setMaskCallback(MaskCallback callback, void* userData) {
+    _impl->setMaskCallback(callback, userData);
+}
+
+const uint8_t* ESP32_AnimatedGIF::getAlphaMask() const {
+    return _impl->getAlphaMask();
+}
+
+bool ESP32_AnimatedGIF::setColorCorrection(const ColorCorrection* correction) {
+    return _impl->setColorCorrection(correction);
+}
+
+bool ESP32_AnimatedGIF::setBrightness(uint8_t brightness) {
+    return _impl->setBrightness(brightness);
+}
+
 void ESP32_AnimatedGIF::setScale(float scale) {
     _impl->setScale(scale);
 }
@@ -906,35 +2955,59 @@ uint16_t ESP32_AnimatedGIF::getCanvasHeight() const {
     return _impl->getCanvasHeight();
 }
 
+GIFError ESP32_AnimatedGIF::redraw(uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+    return _impl->redraw(x, y, width, height);
+}
+
+PixelFormat ESP32_AnimatedGIF::getPixelFormat() const {
+    return _impl->getPixelFormat();
+}
+
+const uint8_t* ESP32_AnimatedGIF::getFrameBuffer() const {
+    return _impl->getFrameBuffer();
+}
+
+bool ESP32_AnimatedGIF::getDirtyRect(uint16_t& x, uint16_t& y, uint16_t& width, uint16_t& height) const {
+    return _impl->getDirtyRect(x, y, width, height);
+}
+
 // Utility functions implementation
 namespace ESP32_GIF_Utils {
     
+#ifdef ESP32_ANIMATEDGIF_STATS
+    static uint32_t allocationCount = 0;
+    static uint32_t freeCount = 0;
+    static uint32_t allocatedBytes = 0;
+#endif
+    
     void* allocateMemory(size_t size, bool usePSRAM) {
         if (size == 0) return nullptr;
         
-#ifdef ESP32_ANIMATEDGIF_PSRAM_SUPPORT
-        if (usePSRAM && psramFound()) {
-            void* ptr = ps_malloc(size);
-            if (ptr) {
-                memset(ptr, 0, size);
-                return ptr;
-            }
-        }
-#endif
-        
-        void* ptr = malloc(size);
+        void* ptr = ESP32_GIF_Platform::allocate(size, usePSRAM);
         if (ptr) {
             memset(ptr, 0, size);
+            GIF_STATS(allocationCount++; allocatedBytes += size);
+        } else {
+            ESP32_GIF_LOG("ESP32_AnimatedGIF: allocation of %u bytes failed", (unsigned)size);
         }
         return ptr;
     }
     
     void freeMemory(void* ptr) {
         if (ptr) {
-            free(ptr);
+            GIF_STATS(freeCount++);
+            ESP32_GIF_Platform::release(ptr);
         }
     }
     
+#ifdef ESP32_ANIMATEDGIF_STATS
+    void getAllocationStats(uint32_t& allocations, uint32_t& frees, uint32_t& bytes) {
+        allocations = allocationCount;
+        frees = freeCount;
+        bytes = allocatedBytes;
+    }
+#endif
+    
     uint16_t rgb888To565(uint8_t r, uint8_t g, uint8_t b) {
         return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
     }
@@ -943,4 +3016,121 @@ namespace ESP32_GIF_Utils {
         // Using luminance formula: Y = 0.299R + 0.587G + 0.114B
         return (uint8_t)((r * 77 + g * 150 + b * 29) >> 8);
     }
+    
+    const uint8_t* bayerRow(uint16_t y) {
+        // 8x8 Bayer matrix scaled to 0-255 thresholds
+        static const uint8_t bayer[8][8] = {
+            {   2, 130,  34, 162,  10, 138,  42, 170 },
+            { 194,  66, 226,  98, 202,  74, 234, 106 },
+            {  50, 178,  18, 146,  58, 186,  26, 154 },
+            { 242, 114, 210,  82, 250, 122, 218,  90 },
+            {  14, 142,  46, 174,   6, 134,  38, 166 },
+            { 206,  78, 238, 110, 198,  70, 230, 102 },
+            {  62, 190,  30, 158,  54, 182,  22, 150 },
+            { 254, 126, 222,  94, 246, 118, 214,  86 }
+        };
+        return bayer[y & 7];
+    }
+    
+    uint8_t bitsPerPixel(PixelFormat format) {
+        switch (format) {
+            case PixelFormat::RGB565_LE:
+            case PixelFormat::RGB565_BE:
+                return 16;
+            case PixelFormat::RGB888:
+                return 24;
+            case PixelFormat::ARGB8888:
+                return 32;
+            case PixelFormat::GRAYSCALE_8BIT:
+            case PixelFormat::INDEXED8:
+            case PixelFormat::RGB332:
+                return 8;
+            case PixelFormat::RGB444:
+                return 12;
+            case PixelFormat::GRAY4:
+                return 4;
+            case PixelFormat::GRAY2:
+                return 2;
+            case PixelFormat::MONOCHROME_1BIT:
+                return 1;
+            default:
+                return 0;
+        }
+    }
+    
+    uint32_t convertColor(PixelFormat format, DitherMode dither, uint8_t r, uint8_t g, uint8_t b) {
+        switch (format) {
+            case PixelFormat::RGB565_LE:
+            case PixelFormat::RGB565_BE:
+                return rgb888To565(r, g, b);
+            case PixelFormat::RGB888:
+                return ((uint32_t)r << 16) | (g << 8) | b;
+            case PixelFormat::ARGB8888:
+                return 0xFF000000 | ((uint32_t)r << 16) | (g << 8) | b;
+            case PixelFormat::GRAYSCALE_8BIT:
+                return rgb888ToGrayscale(r, g, b);
+            case PixelFormat::RGB332:
+                return (r & 0xE0) | ((g & 0xE0) >> 3) | (b >> 6);
+            case PixelFormat::RGB444:
+                return ((uint32_t)(r >> 4) << 8) | ((g >> 4) << 4) | (b >> 4);
+            case PixelFormat::MONOCHROME_1BIT:
+            case PixelFormat::GRAY4:
+            case PixelFormat::GRAY2: {
+                // Gray level when dithering, otherwise the final level
+                uint8_t gray = rgb888ToGrayscale(r, g, b);
+                if (dither == DitherMode::ORDERED) return gray;
+                uint8_t maxLevel = (1 << bitsPerPixel(format)) - 1;
+                return (gray * maxLevel + 127) / 255;
+            }
+            default:
+                return 0;
+        }
+    }
+    
+    uint8_t packColor(uint8_t* dst, PixelFormat format, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+        switch (format) {
+            case PixelFormat::RGB565_LE: {
+                uint16_t color = rgb888To565(r, g, b);
+                dst[0] = color & 0xFF;
+                dst[1] = color >> 8;
+                return 2;
+            }
+            case PixelFormat::RGB565_BE: {
+                uint16_t color = rgb888To565(r, g, b);
+                dst[0] = color >> 8;
+                dst[1] = color & 0xFF;
+                return 2;
+            }
+            case PixelFormat::RGB888:
+                dst[0] = r;
+                dst[1] = g;
+                dst[2] = b;
+                return 3;
+            case PixelFormat::ARGB8888:
+                dst[0] = a;
+                dst[1] = r;
+                dst[2] = g;
+                dst[3] = b;
+                return 4;
+            case PixelFormat::GRAYSCALE_8BIT:
+                dst[0] = rgb888ToGrayscale(r, g, b);
+                return 1;
+            default:
+                return 0;
+        }
+    }
+    
+    void initColorCorrection(ColorCorrection& correction) {
+        static const int16_t identity[9] = { 256, 0, 0, 0, 256, 0, 0, 0, 256 };
+        memcpy(correction.matrix, identity, sizeof(identity));
+        correction.gamma = 1.0f;
+        correction.gammaTable = nullptr;
+        correction.brightness = 255;
+    }
+    
+    void buildGammaTable(uint8_t* table, float gamma) {
+        for (uint16_t i = 0; i < 256; i++) {
+            table[i] = (gamma == 1.0f || i == 0) ? i : (uint8_t)(255.0f * powf(i / 255.0f, gamma) + 0.5f);
+        }
+    }
 }
\ No newline at end of file
@@ -13,17 +13,16 @@
 #ifndef ESP32_ANIMATED_GIF_H
 #define ESP32_ANIMATED_GIF_H
 
-#include <Arduino.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#include "ESP32_AnimatedGIF_Platform.h"
+#include "ESP32_GIF_Stream.h"
+#include "ESP32_GIF_Gamma.h"
+#include "ESP32_GIF_Trace.h"
 
-// Platform detection
-#if defined(ESP32) || defined(ESP8266)
-  #define ESP32_ANIMATEDGIF_ESP_PLATFORM
-  #if defined(ESP32) && defined(PSRAM_ENABLE)
-    #define ESP32_ANIMATEDGIF_PSRAM_SUPPORT
-  #endif
-#endif
+// Library version (as in library.properties and library.json)
+#define ESP32_ANIMATEDGIF_VERSION "1.0.0"
 
 // Configuration
 #ifndef ESP32_ANIMATEDGIF_MAX_WIDTH
@@ -57,7 +56,19 @@ enum class PixelFormat {
     RGB888,             // 24-bit RGB
     ARGB8888,           // 32-bit ARGB
     GRAYSCALE_8BIT,     // 8-bit grayscale
-    MONOCHROME_1BIT     // 1-bit monochrome
+    MONOCHROME_1BIT,    // 1-bit monochrome, packed 8 pixels per byte (MSB first)
+    INDEXED8,           // 8-bit palette indices (palette via PaletteCallback)
+    RGB332,             // 8-bit RGB 3-3-2
+    RGB444,             // 12-bit RGB, packed 2 pixels in 3 bytes (R1G1 B1R2 G2B2)
+    GRAY4,              // 4-bit grayscale, packed 2 pixels per byte (MSB first)
+    GRAY2               // 2-bit grayscale, packed 4 pixels per byte (MSB first)
+};
+
+// Dithering for reduced-depth formats
+enum class DitherMode {
+    NONE = 0,           // Nearest level
+    ORDERED,            // 8x8 Bayer ordered dithering
+    ERROR_DIFFUSION     // Floyd-Steinberg against the device palette
 };
 
 // Disposal methods
@@ -91,10 +102,146 @@ struct FrameInfo {
     bool interlace;             // Interlaced image
 };
 
+// Decoder statistics (collected only when built with ESP32_ANIMATEDGIF_STATS)
+struct GIFStats {
+    uint32_t frames;            // Frames decoded (1 for the frame statistics)
+    uint64_t parseMicros;       // Extension and image descriptor parsing
+    uint64_t decodeMicros;      // LZW decoding of the image data
+    uint64_t composeMicros;     // Disposal, restore and canvas writes
+    uint64_t convertMicros;     // Palette LUT rebuilds and error diffusion
+    uint64_t outputMicros;      // Callbacks and stream encoding
+    uint64_t ioMicros;          // Time blocked in the DataReader (part of parse and decode)
+    uint64_t compressedBytes;   // LZW image data including sub-block headers
+    uint64_t readerCalls;       // Reads from the data source
+    uint64_t readerBytes;       // Bytes read from the data source
+    uint64_t pixelsWritten;     // Frame pixels composed onto the canvas (clipped)
+    uint64_t pixelsEmitted;     // Pixels of the rows sent to the outputs
+    uint64_t spans;             // FrameCallback spans
+    uint64_t dirtyArea;         // Dirty rect area in pixels
+    uint64_t allocations;       // Library allocations (process wide)
+    uint64_t paletteCacheHits;  // Frames that reused the palette LUTs
+    uint64_t paletteCacheMisses; // Frames that rebuilt the palette LUTs
+};
+
+// Presentation error buckets: early by more than 1 ms, within 1 ms, then
+// late by up to 2, 4, 8, ... 256 ms and more
+#define ESP32_ANIMATEDGIF_PACING_BUCKETS 11
+
+// Stage blamed for a missed frame deadline
+enum class PacingCause {
+    UNKNOWN = 0,        // Not reported, kept for the enum values
+    CALLER,             // nextFrame() was called after the frame was due
+    IO,                 // DataReader reads
+    DECODE,             // Parsing, LZW decoding, composing and color conversion
+    OUTPUT              // Callbacks and stream output
+};
+
+// A frame presented later than the pacing tolerance
+struct PacingMiss {
+    uint16_t frame;             // Frame number
+    uint32_t lateMicros;        // Presentation time minus scheduled time
+    PacingCause cause;          // Stage that took the largest share of the frame
+    uint32_t ioMicros;          // Stage times of the frame (decode is the rest of nextFrame())
+    uint32_t decodeMicros;
+    uint32_t outputMicros;
+};
+
+// Frame pacing since load or resetStats()
+struct PacingStats {
+    uint32_t frames;            // Frames presented
+    uint32_t misses;            // Frames later than the tolerance
+    uint32_t causes[5];         // Misses per PacingCause
+    int32_t minErrorMicros;     // Earliest presentation (negative = early)
+    int32_t maxErrorMicros;     // Latest presentation
+    int64_t totalErrorMicros;   // Sum of the errors, for the mean
+    uint32_t lastScheduled;     // Scheduled presentation of the last frame (micros())
+    uint32_t lastPresented;     // Actual presentation of the last frame (micros())
+    uint32_t histogram[ESP32_ANIMATEDGIF_PACING_BUCKETS];
+};
+
+// Decode cost of a device, pixel format and output path (gifbench --calibrate)
+struct GIFCalibration {
+    float usPerFrame;           // Fixed cost per frame (parsing, palette, setup)
+    float nsPerPixel;           // Per frame pixel composed onto the canvas (clipped)
+    float nsPerByte;            // Per byte of LZW image data
+};
+
+// Preflight prediction from a structural scan of a GIF, nothing is decoded
+struct GIFEstimate {
+    uint16_t width;             // Canvas width
+    uint16_t height;            // Canvas height
+    uint16_t frameCount;        // Number of frames
+    uint32_t totalDuration;     // Nominal animation duration (ms)
+    uint32_t fileBytes;         // File size up to the trailer
+    
+    // Peak memory in bytes, every buffer is kept until the next load
+    uint32_t memoryFromMemory;  // loadFromMemory(): the copy of the file plus memoryFromReader
+    uint32_t memoryFromReader;  // load() with a DataReader
+    uint32_t canvasBytes;       // Frame buffer in the current pixel format
+    uint32_t restoreBytes;      // "Restore to previous" copy (0 if no frame uses it)
+    uint32_t interlaceBytes;    // Largest interlaced frame (0 if none is interlaced)
+    uint32_t maskBytes;         // Alpha masks (0 without setAlphaMask())
+    uint32_t workingBytes;      // Decoder object, LZW table, color tables and row buffers
+    
+    // Workload per frame
+    uint32_t maxFramePixels;    // Largest clipped frame area
+    uint32_t averageFramePixels;
+    uint32_t maxFrameBytes;     // Largest LZW image data
+    uint32_t averageFrameBytes;
+    uint16_t paletteChanges;    // Frames with a local color table
+    
+    // Prediction, 0 without a calibration
+    uint32_t averageFrameMicros;
+    uint32_t maxFrameMicros;
+    uint16_t slowFrames;        // Frames predicted to take longer than their delay
+    float nominalFps;           // Frame rate given by the frame delays
+    float predictedFps;         // Frame rate with slow frames stretching the schedule
+};
+
+// Color correction applied while the palette LUTs are built
+struct ColorCorrection {
+    int16_t matrix[9];          // 3x3 RGB matrix, row major, 256 = 1.0 (white balance, channel mixing)
+    float gamma;                // Output gamma exponent (1.0 = linear)
+    const uint8_t* gammaTable;  // Optional 256-entry curve used instead of gamma
+    uint8_t brightness;         // Output brightness (255 = full)
+};
+
+// Embedded GIF bundle (written by tools/embed/gifembed), in declaration order
+struct GIFBundleFrame {
+    uint32_t offset;            // First block of the frame (extensions or image descriptor)
+    uint16_t delay;             // Frame delay as played (ms)
+    uint16_t palette;           // Index into the bundle palettes (0xFFFF: no color table)
+};
+
+struct GIFBundlePalette {
+    const uint32_t* canvas;     // Canvas format value per color index
+    const uint16_t* rgb565;     // RGB565 per color index (pixel callback, span stream)
+    uint16_t size;              // Color table entries
+};
+
+struct GIFBundle {
+    const uint8_t* data;        // The GIF file
+    uint32_t length;
+    uint16_t width;             // Canvas width
+    uint16_t height;            // Canvas height
+    uint16_t frameCount;
+    uint32_t totalDuration;     // Sum of the frame delays (ms)
+    const GIFBundleFrame* frames;
+    const GIFBundlePalette* palettes; // Global table first, then distinct local tables
+    uint16_t paletteCount;
+    PixelFormat format;         // Format the palettes were converted to
+    DitherMode dither;          // Dither mode they were converted for
+    uint32_t black;             // Canvas value of indices past the end of a table
+};
+
 // Callback function types
 typedef void (*FrameCallback)(void* userData, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* pixels);
 typedef void (*PixelCallback)(void* userData, uint16_t x, uint16_t y, uint16_t color);
 typedef bool (*DataReader)(void* userData, uint8_t* buffer, uint32_t length, uint32_t position);
+typedef void (*PaletteCallback)(void* userData, const uint8_t* palette, uint16_t count, PixelFormat format);
+typedef void (*BackgroundCallback)(void* userData, uint16_t x, uint16_t y, uint16_t width, uint8_t* row);
+typedef void (*MaskCallback)(void* userData, uint16_t x, uint16_t y, uint16_t width, const uint8_t* mask);
+typedef void (*PacingCallback)(void* userData, const PacingMiss& miss);
 
 // Main GIF decoder class
 class ESP32_AnimatedGIF {
@@ -133,6 +280,62 @@ public:
      */
     GIFError load(DataReader reader, void* userData = nullptr);
     
+    /**
+     * @brief Load a pre-rendered animation (ESP32_GIF_Prerendered.h) from memory
+     * @param data Pointer to the converted file
+     * @param length Length of the file
+     * @return GIFError code (UNSUPPORTED_FEATURE if it was rendered for
+     *         another pixel format than begin())
+     * @note Frames are played without LZW decoding through the same outputs
+     *       and frame pacing; palette, color, dither and background settings
+     *       were applied when the file was converted
+     */
+    GIFError loadPrerenderedFromMemory(const uint8_t* data, uint32_t length);
+    
+    /**
+     * @brief Load a pre-rendered animation using custom data reader
+     * @param reader Data reader callback
+     * @param userData User data for callback
+     * @return GIFError code
+     */
+    GIFError loadPrerendered(DataReader reader, void* userData = nullptr);
+    
+    /**
+     * @brief Load a GIF embedded as a bundle header (tools/embed/gifembed)
+     * @param bundle Bundle; it and its arrays must stay valid while playing
+     * @return GIFError code
+     * @note The GIF is played in place: no copy, no frame count scan, and the
+     *       palettes are used as converted when format and dither match and
+     *       no color correction or device palette is set
+     */
+    GIFError loadBundle(const GIFBundle& bundle);
+    
+    /**
+     * @brief Predict memory and decode cost of a GIF in memory without decoding it
+     * @param data Pointer to GIF data
+     * @param length Length of GIF data
+     * @param estimate Reference to GIFEstimate structure
+     * @param calibration Decode cost of the target (nullptr: memory and workload only)
+     * @return GIFError code
+     * @note Uses the current pixel format, outputs and options; the loaded GIF
+     *       and getLastError() are not affected
+     */
+    GIFError estimateFromMemory(const uint8_t* data, uint32_t length, GIFEstimate& estimate,
+                                const GIFCalibration* calibration = nullptr);
+    
+    /**
+     * @brief Predict memory and decode cost of a GIF read by a data reader
+     * @param reader Data reader callback
+     * @param userData User data for callback
+     * @param estimate Reference to GIFEstimate structure
+     * @param calibration Decode cost of the target (nullptr: memory and workload only)
+     * @return GIFError code
+     * @note Reads headers, color table flags and sub-block sizes only; reader
+     *       time is not part of the prediction
+     */
+    GIFError estimate(DataReader reader, void* userData, GIFEstimate& estimate,
+                      const GIFCalibration* calibration = nullptr);
+    
     /**
      * @brief Set display dimensions for scaling
      * @param width Display width
@@ -144,6 +347,8 @@ public:
      * @brief Set frame callback for partial updates
      * @param callback Frame callback function
      * @param userData User data for callback
+     * @note Called for every rendered row (height 1) with the composed
+     *       canvas span in the configured pixel format
      */
     void setFrameCallback(FrameCallback callback, void* userData = nullptr);
     
@@ -151,9 +356,76 @@ public:
      * @brief Set pixel callback for pixel-by-pixel rendering
      * @param callback Pixel callback function
      * @param userData User data for callback
+     * @note color is RGB565, or the palette index with PixelFormat::INDEXED8
      */
     void setPixelCallback(PixelCallback callback, void* userData = nullptr);
     
+    /**
+     * @brief Set palette callback, fired before a frame whose palette differs from the last one
+     * @param callback Palette callback function
+     * @param userData User data for callback
+     * @param paletteFormat Entry format of the delivered table (RGB565, RGB888, ARGB8888 or grayscale)
+     * @note ARGB8888 entries carry alpha 0 for the transparent index
+     */
+    void setPaletteCallback(PaletteCallback callback, void* userData = nullptr,
+                            PixelFormat paletteFormat = PixelFormat::RGB565_LE);
+    
+    /**
+     * @brief Set stream writer for compressed span output
+     * @param writer Writer receiving the encoded byte stream (nullptr disables)
+     * @param userData User data for writer
+     * @param encoding Span value encoding
+     * @note See ESP32_GIF_Stream.h for the stream format and receiver
+     */
+    void setStreamWriter(StreamWriter writer, void* userData = nullptr,
+                         StreamEncoding encoding = StreamEncoding::RLE_RGB565);
+    
+    /**
+     * @brief Get compressed stream statistics
+     * @param stats Reference to StreamStats structure
+     * @return true if a stream writer is set, false otherwise
+     */
+    bool getStreamStats(StreamStats& stats) const;
+    
+    /**
+     * @brief Get the statistics of the last decoded frame
+     * @param stats Reference to GIFStats structure
+     * @return true if statistics are compiled in (ESP32_ANIMATEDGIF_STATS), false otherwise
+     */
+    bool getFrameStats(GIFStats& stats) const;
+    
+    /**
+     * @brief Get the statistics summed over all frames since load or resetStats()
+     * @param stats Reference to GIFStats structure
+     * @return true if statistics are compiled in (ESP32_ANIMATEDGIF_STATS), false otherwise
+     */
+    bool getStats(GIFStats& stats) const;
+    
+    /**
+     * @brief Clear the frame, cumulative and pacing statistics
+     */
+    void resetStats();
+    
+    /**
+     * @brief Get the frame pacing statistics
+     * @param stats Reference to PacingStats structure
+     * @return true if any frame was presented, false otherwise
+     */
+    bool getPacingStats(PacingStats& stats) const;
+    
+    /**
+     * @brief Set how late a frame may be presented before it counts as a miss
+     * @param ms Tolerance in milliseconds (default 10)
+     */
+    void setPacingTolerance(uint16_t ms);
+    
+    /**
+     * @brief Set a callback for frames presented later than the tolerance
+     * @param callback Called from nextFrame() once per missed frame
+     * @param userData User data passed to callback
+     */
+    void setPacingCallback(PacingCallback callback, void* userData = nullptr);
+    
     /**
      * @brief Get GIF information
      * @param info Reference to GIFInfo structure
@@ -170,11 +442,24 @@ public:
     
     /**
      * @brief Decode and render next frame
-     * @param syncDelay Wait for frame delay if true
+     * @param syncDelay Wait until the next frame is due if true; the wait is
+     *                  the frame delay minus the expected decode time
      * @return GIFError code
      */
     GIFError nextFrame(bool syncDelay = true);
     
+    /**
+     * @brief Emit part of the current canvas again without decoding
+     * @param x Left edge
+     * @param y Top edge
+     * @param width Width (clipped to the canvas)
+     * @param height Height (clipped to the canvas)
+     * @return GIFError code
+     * @note Pixels go through the pixel, frame, mask and stream outputs like
+     *       resolved frame rows; the animation state is not changed
+     */
+    GIFError redraw(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+    
     /**
      * @brief Reset to first frame
      */
@@ -217,6 +502,77 @@ public:
      */
     void setLoop(bool loop);
     
+    /**
+     * @brief Set dithering for reduced-depth formats (MONOCHROME_1BIT, GRAY4, GRAY2)
+     * @param mode Dither mode, ERROR_DIFFUSION applies to device palette remapping
+     */
+    void setDither(DitherMode mode);
+    
+    /**
+     * @brief Remap all GIF colors to the nearest color of a fixed device palette
+     * @param palette Device colors as packed RGB triplets (nullptr disables)
+     * @param count Number of device colors (up to 255)
+     * @return true if successful, false if out of memory
+     * @note With PixelFormat::INDEXED8 the output carries device indices and
+     *       the palette callback delivers the device palette
+     */
+    bool setDevicePalette(const uint8_t* palette, uint16_t count);
+    
+    /**
+     * @brief Set color correction for the output
+     * @param correction Matrix, gamma curve and brightness (nullptr disables)
+     * @return true if successful, false if out of memory
+     * @note Correction is applied to the palette entries, not per pixel;
+     *       it takes effect from the next decoded frame
+     */
+    bool setColorCorrection(const ColorCorrection* correction);
+    
+    /**
+     * @brief Set output brightness, keeping the rest of the color correction
+     * @param brightness Brightness (255 = full)
+     * @return true if successful, false if out of memory
+     */
+    bool setBrightness(uint8_t brightness);
+    
+    /**
+     * @brief Compose transparent and disposed pixels over a static background image
+     * @param image Canvas-sized image in the output pixel format with rows of
+     *              (width * bitsPerPixel + 7) / 8 bytes (nullptr disables)
+     * @note The image must stay valid while frames are decoded. It fills the
+     *       canvas at the first frame and replaces the GIF background color
+     *       for disposal; outputs then receive fully resolved rows.
+     */
+    void setBackground(const uint8_t* image);
+    
+    /**
+     * @brief Compose over a background produced on demand (e.g. a UI skin in flash)
+     * @param callback Fills pixels x to x + width - 1 of canvas row y into row,
+     *                 which has the canvas row layout (nullptr disables)
+     * @param userData User data for callback
+     */
+    void setBackgroundCallback(BackgroundCallback callback, void* userData = nullptr);
+    
+    /**
+     * @brief Maintain a packed 1-bit alpha mask of the canvas
+     * @param enable true to keep the mask (1 = opaque, MSB first, rows of (width + 7) / 8 bytes)
+     * @note Enable before loading so the mask covers the first frame
+     */
+    void setAlphaMask(bool enable);
+    
+    /**
+     * @brief Receive the alpha mask of every emitted span (enables the mask)
+     * @param callback Mask callback; spans are widened to multiples of 8 pixels
+     *                 so mask starts on a byte boundary (nullptr disables)
+     * @param userData User data for callback
+     */
+    void setMaskCallback(MaskCallback callback, void* userData = nullptr);
+    
+    /**
+     * @brief Get the alpha mask of the composed canvas
+     * @return Packed 1-bit mask, or nullptr if disabled
+     */
+    const uint8_t* getAlphaMask() const;
+    
     /**
      * @brief Set scaling factor
      * @param scale Scaling factor (1.0 = no scaling)
@@ -235,6 +591,28 @@ public:
      */
     uint16_t getCanvasHeight() const;
     
+    /**
+     * @brief Get output pixel format
+     * @return PixelFormat passed to begin()
+     */
+    PixelFormat getPixelFormat() const;
+    
+    /**
+     * @brief Get the composed canvas
+     * @return Canvas in the output pixel format, or nullptr if nothing is loaded
+     */
+    const uint8_t* getFrameBuffer() const;
+    
+    /**
+     * @brief Get the canvas area changed by the last nextFrame()
+     * @param x Left edge
+     * @param y Top edge
+     * @param width Width (0 if nothing changed)
+     * @param height Height (0 if nothing changed)
+     * @return true if an area changed
+     */
+    bool getDirtyRect(uint16_t& x, uint16_t& y, uint16_t& width, uint16_t& height) const;
+    
 private:
     // Private implementation
     class Impl;
@@ -262,6 +640,17 @@ namespace ESP32_GIF_Utils {
      */
     void freeMemory(void* ptr);
     
+#ifdef ESP32_ANIMATEDGIF_STATS
+    /**
+     * @brief Get counters of allocateMemory() and freeMemory() since startup
+     * @param allocations Successful allocations
+     * @param frees Released blocks
+     * @param bytes Total bytes allocated (wraps around)
+     * @note Only available when built with ESP32_ANIMATEDGIF_STATS
+     */
+    void getAllocationStats(uint32_t& allocations, uint32_t& frees, uint32_t& bytes);
+#endif
+    
     /**
      * @brief Convert RGB888 to RGB565
      * @param r Red component (0-255)
@@ -279,6 +668,57 @@ namespace ESP32_GIF_Utils {
      * @return Grayscale value (0-255)
      */
     uint8_t rgb888ToGrayscale(uint8_t r, uint8_t g, uint8_t b);
+    
+    /**
+     * @brief Get one row of the 8x8 Bayer threshold matrix
+     * @param y Row (only the low 3 bits are used)
+     * @return 8 thresholds in the 0-255 range
+     */
+    const uint8_t* bayerRow(uint16_t y);
+    
+    /**
+     * @brief Get storage size of a pixel format
+     * @param format Pixel format
+     * @return Bits per pixel, 0 for an unknown format
+     */
+    uint8_t bitsPerPixel(PixelFormat format);
+    
+    /**
+     * @brief Convert a color to its canvas value, as the palette LUTs hold it
+     * @param format Pixel format (INDEXED8 has no color value, returns 0)
+     * @param dither Dither mode (packed gray formats keep the gray level for ORDERED)
+     * @param r Red component (0-255)
+     * @param g Green component (0-255)
+     * @param b Blue component (0-255)
+     * @return Canvas value
+     */
+    uint32_t convertColor(PixelFormat format, DitherMode dither, uint8_t r, uint8_t g, uint8_t b);
+    
+    /**
+     * @brief Write one color in the given pixel format
+     * @param dst Destination (up to 4 bytes)
+     * @param format RGB565, RGB888, ARGB8888 or grayscale
+     * @param r Red component (0-255)
+     * @param g Green component (0-255)
+     * @param b Blue component (0-255)
+     * @param a Alpha component (0-255), ARGB8888 only
+     * @return Number of bytes written, 0 for a non-color format
+     */
+    uint8_t packColor(uint8_t* dst, PixelFormat format, uint8_t r, uint8_t g, uint8_t b, uint8_t a = 0xFF);
+    
+    /**
+     * @brief Initialize a color correction to identity
+     * @param correction Reference to ColorCorrection structure
+     */
+    void initColorCorrection(ColorCorrection& correction);
+    
+    /**
+     * @brief Build a gamma curve at runtime
+     * @param table Destination (256 entries)
+     * @param gamma Gamma exponent (1.0 = linear)
+     * @note Prefer the constexpr tables of ESP32_GIF_Gamma.h when available
+     */
+    void buildGammaTable(uint8_t* table, float gamma);
 }
 
 #endif // ESP32_ANIMATED_GIF_H
\ No newline at end of file
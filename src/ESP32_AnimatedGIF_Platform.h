@@ -0,0 +1,119 @@
+/**
+ * @file ESP32_AnimatedGIF_Platform.h
+ * @brief Thin platform layer (clock, sleep, allocation, PSRAM, logging)
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * The decoder core only talks to the platform through these functions.
+ * ESP32_AnimatedGIF_Platform_Arduino.cpp implements them on top of the
+ * Arduino core, ESP32_AnimatedGIF_Platform_POSIX.cpp for Linux and other
+ * hosts, so the same sources can be built natively with CMake.
+ *
+ * The clock functions can be redirected to an ESP32_GIF_Clock, e.g. a
+ * virtual clock that lets host simulations replay hours of playback in
+ * seconds (see tools/sim).
+ */
+
+#ifndef ESP32_ANIMATEDGIF_PLATFORM_H
+#define ESP32_ANIMATEDGIF_PLATFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Platform detection
+#if defined(ESP32) || defined(ESP8266)
+  #define ESP32_ANIMATEDGIF_ESP_PLATFORM
+  #if defined(ESP32) && defined(PSRAM_ENABLE)
+    #define ESP32_ANIMATEDGIF_PSRAM_SUPPORT
+  #endif
+#endif
+
+// Debug logging, compiled out unless ESP32_ANIMATEDGIF_DEBUG is defined
+#ifdef ESP32_ANIMATEDGIF_DEBUG
+  #define ESP32_GIF_LOG(...) ESP32_GIF_Platform::log(__VA_ARGS__)
+#else
+  #define ESP32_GIF_LOG(...) do {} while (0)
+#endif
+
+// Replacement for the system clock
+struct ESP32_GIF_Clock {
+    uint64_t (*micros)(void* userData);             // Monotonic microseconds
+    void (*sleep)(void* userData, uint32_t ms);     // Block, or advance virtual time
+    void* userData;
+};
+
+namespace ESP32_GIF_Platform {
+
+    /**
+     * @brief Route millis(), micros(), ticks() and sleep() through a clock
+     * @param clock Clock to use, nullptr for the system clock; must stay
+     *              valid while set (not thread safe, set it before playback)
+     */
+    void setClock(const ESP32_GIF_Clock* clock);
+
+    /**
+     * @brief Monotonic clock
+     * @return Milliseconds since an arbitrary start
+     */
+    uint32_t millis();
+
+    /**
+     * @brief Monotonic clock
+     * @return Microseconds since an arbitrary start
+     */
+    uint32_t micros();
+
+    /**
+     * @brief Cheap high-resolution timestamp for profiling
+     * @return CPU cycles on ESP32, nanoseconds on hosts, microseconds with a
+     *         clock set; wraps, use differences
+     */
+    uint32_t ticks();
+
+    /**
+     * @brief Resolution of ticks()
+     * @return Ticks per microsecond
+     */
+    uint32_t ticksPerMicrosecond();
+
+    /**
+     * @brief Core (CPU) the caller runs on, for trace events
+     * @return Core number, 0 on single-core targets
+     */
+    uint8_t coreId();
+
+    /**
+     * @brief Block the calling task
+     * @param ms Milliseconds to sleep
+     */
+    void sleep(uint32_t ms);
+
+    /**
+     * @brief Allocate memory
+     * @param size Size in bytes
+     * @param usePSRAM Prefer external PSRAM if the platform has it
+     * @return Pointer to memory or nullptr
+     */
+    void* allocate(size_t size, bool usePSRAM);
+
+    /**
+     * @brief Release memory from allocate()
+     * @param ptr Pointer to memory (nullptr is ignored)
+     */
+    void release(void* ptr);
+
+    /**
+     * @brief Check for external PSRAM
+     * @return true if PSRAM is available
+     */
+    bool hasPSRAM();
+
+    /**
+     * @brief Print a printf-style log line
+     * @param format Format string
+     */
+    void log(const char* format, ...);
+}
+
+#endif // ESP32_ANIMATEDGIF_PLATFORM_H
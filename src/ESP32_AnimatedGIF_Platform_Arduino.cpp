@@ -0,0 +1,114 @@
+/**
+ * @file ESP32_AnimatedGIF_Platform_Arduino.cpp
+ * @brief Platform layer on top of the Arduino core
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#ifdef ARDUINO
+
+#include "ESP32_AnimatedGIF_Platform.h"
+#include <Arduino.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#ifdef ESP32_ANIMATEDGIF_PSRAM_SUPPORT
+  #include <esp32-hal-psram.h>
+#endif
+
+namespace ESP32_GIF_Platform {
+
+    static const ESP32_GIF_Clock* customClock = nullptr;
+
+    void setClock(const ESP32_GIF_Clock* clock) {
+        customClock = clock;
+    }
+
+    uint32_t millis() {
+        if (customClock) {
+            return (uint32_t)(customClock->micros(customClock->userData) / 1000);
+        }
+        return ::millis();
+    }
+
+    uint32_t micros() {
+        if (customClock) {
+            return (uint32_t)customClock->micros(customClock->userData);
+        }
+        return ::micros();
+    }
+
+    uint32_t ticks() {
+        if (customClock) {
+            return (uint32_t)customClock->micros(customClock->userData);
+        }
+#ifdef ESP32
+        return ESP.getCycleCount();
+#else
+        return ::micros();
+#endif
+    }
+
+    uint32_t ticksPerMicrosecond() {
+        if (customClock) {
+            return 1;
+        }
+#ifdef ESP32
+        return getCpuFrequencyMhz();
+#else
+        return 1;
+#endif
+    }
+
+    uint8_t coreId() {
+#ifdef ESP32
+        return xPortGetCoreID();
+#else
+        return 0;
+#endif
+    }
+
+    void sleep(uint32_t ms) {
+        if (customClock) {
+            customClock->sleep(customClock->userData, ms);
+            return;
+        }
+        ::delay(ms);
+    }
+
+    void* allocate(size_t size, bool usePSRAM) {
+#ifdef ESP32_ANIMATEDGIF_PSRAM_SUPPORT
+        if (usePSRAM && psramFound()) {
+            void* ptr = ps_malloc(size);
+            if (ptr) return ptr;
+        }
+#else
+        (void)usePSRAM;
+#endif
+        return malloc(size);
+    }
+
+    void release(void* ptr) {
+        free(ptr);
+    }
+
+    bool hasPSRAM() {
+#ifdef ESP32_ANIMATEDGIF_PSRAM_SUPPORT
+        return psramFound();
+#else
+        return false;
+#endif
+    }
+
+    void log(const char* format, ...) {
+        char line[128];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+        Serial.println(line);
+    }
+}
+
+#endif // ARDUINO
@@ -0,0 +1,104 @@
+/**
+ * @file ESP32_AnimatedGIF_Platform_POSIX.cpp
+ * @brief Platform layer for Linux and other POSIX hosts
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#ifndef ARDUINO
+
+#include "ESP32_AnimatedGIF_Platform.h"
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef __linux__
+  #include <sched.h>
+#endif
+
+namespace ESP32_GIF_Platform {
+
+    static const ESP32_GIF_Clock* customClock = nullptr;
+
+    void setClock(const ESP32_GIF_Clock* clock) {
+        customClock = clock;
+    }
+
+    static uint64_t monotonicMicros() {
+        if (customClock) {
+            return customClock->micros(customClock->userData);
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t)now.tv_sec * 1000000u + now.tv_nsec / 1000;
+    }
+
+    uint32_t millis() {
+        return (uint32_t)(monotonicMicros() / 1000);
+    }
+
+    uint32_t micros() {
+        return (uint32_t)monotonicMicros();
+    }
+
+    uint32_t ticks() {
+        if (customClock) {
+            return (uint32_t)customClock->micros(customClock->userData);
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint32_t)((uint64_t)now.tv_sec * 1000000000u + now.tv_nsec);
+    }
+
+    uint32_t ticksPerMicrosecond() {
+        return customClock ? 1 : 1000;
+    }
+
+    uint8_t coreId() {
+#ifdef __linux__
+        int cpu = sched_getcpu();
+        return cpu > 0 ? (uint8_t)cpu : 0;
+#else
+        return 0;
+#endif
+    }
+
+    void sleep(uint32_t ms) {
+        if (customClock) {
+            customClock->sleep(customClock->userData, ms);
+            return;
+        }
+        struct timespec duration;
+        duration.tv_sec = ms / 1000;
+        duration.tv_nsec = (long)(ms % 1000) * 1000000L;
+        while (nanosleep(&duration, &duration) != 0 && errno == EINTR) {
+            // Interrupted, sleep for the remaining time
+        }
+    }
+
+    void* allocate(size_t size, bool usePSRAM) {
+        (void)usePSRAM; // Hosts have a single heap
+        return malloc(size);
+    }
+
+    void release(void* ptr) {
+        free(ptr);
+    }
+
+    bool hasPSRAM() {
+        return false;
+    }
+
+    void log(const char* format, ...) {
+        va_list args;
+        va_start(args, format);
+        vfprintf(stderr, format, args);
+        va_end(args);
+        fputc('\n', stderr);
+    }
+}
+
+#endif // ARDUINO
@@ -0,0 +1,277 @@
+/**
+ * @file ESP32_GIF_Compositor.cpp
+ * @brief Multi-layer compositor for several GIFs sharing one screen region
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include "ESP32_GIF_Compositor.h"
+#include <algorithm>
+
+ESP32_GIF_Compositor::ESP32_GIF_Compositor()
+    : _layerCount(0)
+    , _width(0)
+    , _height(0)
+    , _pixelFormat(PixelFormat::RGB565_LE)
+    , _bytesPerPixel(2)
+    , _output(nullptr)
+    , _outputData(nullptr)
+    , _row(nullptr)
+    , _covered(nullptr)
+    , _dirtyLeft(0)
+    , _dirtyTop(0)
+    , _dirtyRight(0)
+    , _dirtyBottom(0) {
+    memset(_layers, 0, sizeof(_layers));
+    memset(_clear, 0, sizeof(_clear));
+}
+
+ESP32_GIF_Compositor::~ESP32_GIF_Compositor() {
+    freeBuffers();
+}
+
+bool ESP32_GIF_Compositor::begin(uint16_t width, uint16_t height, PixelFormat pixelFormat) {
+    uint8_t clear[4];
+    uint8_t bytes = ESP32_GIF_Utils::packColor(clear, pixelFormat, 0, 0, 0);
+    if (bytes == 0 || width == 0 || height == 0) {
+        return false; // Packed and indexed formats cannot be mixed per pixel
+    }
+
+    freeBuffers();
+    _row = (uint8_t*)ESP32_GIF_Utils::allocateMemory((size_t)width * bytes, false);
+    _covered = (uint8_t*)ESP32_GIF_Utils::allocateMemory(width, false);
+    if (!_row || !_covered) {
+        freeBuffers();
+        return false;
+    }
+
+    _width = width;
+    _height = height;
+    _pixelFormat = pixelFormat;
+    _bytesPerPixel = bytes;
+    memcpy(_clear, clear, sizeof(_clear));
+    memset(_layers, 0, sizeof(_layers));
+    _layerCount = 0;
+
+    // The first tick pushes the whole region
+    _dirtyLeft = _dirtyTop = _dirtyRight = _dirtyBottom = 0;
+    markDirty(0, 0, width, height);
+    return true;
+}
+
+void ESP32_GIF_Compositor::setOutput(FrameCallback callback, void* userData) {
+    _output = callback;
+    _outputData = userData;
+}
+
+void ESP32_GIF_Compositor::setClearColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    ESP32_GIF_Utils::packColor(_clear, _pixelFormat, r, g, b, a);
+    markDirty(0, 0, _width, _height);
+}
+
+int8_t ESP32_GIF_Compositor::addLayer(ESP32_AnimatedGIF* gif, int16_t x, int16_t y, int8_t z) {
+    if (!gif || gif->getPixelFormat() != _pixelFormat) {
+        return -1;
+    }
+
+    for (uint8_t i = 0; i < ESP32_GIF_COMPOSITOR_MAX_LAYERS; i++) {
+        Layer& layer = _layers[i];
+        if (layer.active) continue;
+
+        gif->setAlphaMask(true);
+        layer.gif = gif;
+        layer.x = x;
+        layer.y = y;
+        layer.z = z;
+        layer.visible = true;
+        layer.active = true;
+        layer.running = true;
+        layer.due = 0;
+        markLayer(layer);
+        return i;
+    }
+    return -1;
+}
+
+void ESP32_GIF_Compositor::removeLayer(int8_t layer) {
+    if (layer < 0 || layer >= ESP32_GIF_COMPOSITOR_MAX_LAYERS || !_layers[layer].active) return;
+
+    markLayer(_layers[layer]);
+    _layers[layer].active = false;
+}
+
+void ESP32_GIF_Compositor::setLayerPosition(int8_t layer, int16_t x, int16_t y) {
+    if (layer < 0 || layer >= ESP32_GIF_COMPOSITOR_MAX_LAYERS || !_layers[layer].active) return;
+
+    // Old and new position both change
+    markLayer(_layers[layer]);
+    _layers[layer].x = x;
+    _layers[layer].y = y;
+    markLayer(_layers[layer]);
+}
+
+void ESP32_GIF_Compositor::setLayerZ(int8_t layer, int8_t z) {
+    if (layer < 0 || layer >= ESP32_GIF_COMPOSITOR_MAX_LAYERS || !_layers[layer].active) return;
+
+    _layers[layer].z = z;
+    markLayer(_layers[layer]);
+}
+
+void ESP32_GIF_Compositor::setLayerVisible(int8_t layer, bool visible) {
+    if (layer < 0 || layer >= ESP32_GIF_COMPOSITOR_MAX_LAYERS || !_layers[layer].active) return;
+
+    if (_layers[layer].visible != visible) {
+        _layers[layer].visible = visible;
+        markLayer(_layers[layer]);
+    }
+}
+
+void ESP32_GIF_Compositor::invalidate(int16_t x, int16_t y, uint16_t width, uint16_t height) {
+    markDirty(x, y, width, height);
+}
+
+bool ESP32_GIF_Compositor::tick(uint32_t now) {
+    if (!_row) return false;
+
+    // Advance due layers, hidden layers are paused
+    for (uint8_t i = 0; i < ESP32_GIF_COMPOSITOR_MAX_LAYERS; i++) {
+        Layer& layer = _layers[i];
+        if (!layer.active || !layer.visible) continue;
+        if ((int32_t)(now - layer.due) < 0) continue;
+
+        // A finished or failed decoder returns its error at once and keeps
+        // the last frame; it plays again after reset() or a new load
+        if (layer.gif->nextFrame(false) != GIFError::SUCCESS) {
+            layer.running = false;
+            continue;
+        }
+        if (!layer.running) {
+            // The canvas was reset outside the played frames
+            layer.running = true;
+            markLayer(layer);
+        }
+
+        uint16_t x, y, width, height;
+        if (layer.gif->getDirtyRect(x, y, width, height)) {
+            markDirty(layer.x + x, layer.y + y, width, height);
+        }
+
+        // Advance on the schedule so tick lateness does not add up; a layer
+        // more than a frame behind plays on from now instead of catching up
+        FrameInfo info;
+        layer.gif->getFrameInfo(info);
+        if ((int32_t)(now - layer.due) >= (int32_t)info.delay) {
+            layer.due = now;
+        }
+        layer.due += info.delay;
+    }
+
+    // Clip the union to the region
+    int32_t left = std::max<int32_t>(_dirtyLeft, 0);
+    int32_t top = std::max<int32_t>(_dirtyTop, 0);
+    int32_t right = std::min<int32_t>(_dirtyRight, _width);
+    int32_t bottom = std::min<int32_t>(_dirtyBottom, _height);
+    _dirtyLeft = _dirtyTop = _dirtyRight = _dirtyBottom = 0;
+    if (left >= right || top >= bottom) return false;
+
+    sortLayers();
+    for (int32_t y = top; y < bottom; y++) {
+        composeRow(y, left, right);
+        if (_output) {
+            _output(_outputData, left, y, right - left, 1, _row);
+        }
+    }
+    return true;
+}
+
+void ESP32_GIF_Compositor::markDirty(int32_t x, int32_t y, int32_t width, int32_t height) {
+    if (width <= 0 || height <= 0) return;
+
+    if (_dirtyRight <= _dirtyLeft || _dirtyBottom <= _dirtyTop) {
+        _dirtyLeft = x;
+        _dirtyTop = y;
+        _dirtyRight = x + width;
+        _dirtyBottom = y + height;
+        return;
+    }
+    _dirtyLeft = std::min(_dirtyLeft, x);
+    _dirtyTop = std::min(_dirtyTop, y);
+    _dirtyRight = std::max(_dirtyRight, x + width);
+    _dirtyBottom = std::max(_dirtyBottom, y + height);
+}
+
+void ESP32_GIF_Compositor::markLayer(const Layer& layer) {
+    markDirty(layer.x, layer.y, layer.gif->getCanvasWidth(), layer.gif->getCanvasHeight());
+}
+
+void ESP32_GIF_Compositor::sortLayers() {
+    // Insertion sort by descending z, ties keep insertion order
+    _layerCount = 0;
+    for (uint8_t i = 0; i < ESP32_GIF_COMPOSITOR_MAX_LAYERS; i++) {
+        if (!_layers[i].active || !_layers[i].visible) continue;
+
+        uint8_t j = _layerCount++;
+        while (j > 0 && _layers[_order[j - 1]].z < _layers[i].z) {
+            _order[j] = _order[j - 1];
+            j--;
+        }
+        _order[j] = i;
+    }
+}
+
+void ESP32_GIF_Compositor::composeRow(int32_t y, int32_t left, int32_t right) {
+    const uint8_t bytes = _bytesPerPixel;
+    uint16_t remaining = right - left;
+    memset(_covered, 0, remaining);
+
+    for (uint8_t k = 0; k < _layerCount && remaining > 0; k++) {
+        const Layer& layer = _layers[_order[k]];
+        const uint8_t* frame = layer.gif->getFrameBuffer();
+        if (!frame) continue;
+
+        int32_t canvasWidth = layer.gif->getCanvasWidth();
+        int32_t sy = y - layer.y;
+        if (sy < 0 || sy >= layer.gif->getCanvasHeight()) continue;
+        int32_t start = std::max<int32_t>(left, layer.x);
+        int32_t end = std::min<int32_t>(right, layer.x + canvasWidth);
+        if (start >= end) continue;
+
+        const uint8_t* src = frame + (size_t)sy * canvasWidth * bytes;
+        const uint8_t* mask = layer.gif->getAlphaMask();
+        if (mask) {
+            mask += (size_t)sy * ((canvasWidth + 7) / 8);
+        }
+
+        // Pixels covered by higher layers are skipped without reading this layer
+        for (int32_t x = start; x < end; x++) {
+            uint16_t i = x - left;
+            if (_covered[i]) continue;
+            int32_t sx = x - layer.x;
+            if (mask && !(mask[sx >> 3] & (0x80 >> (sx & 7)))) continue;
+
+            memcpy(_row + i * bytes, src + sx * bytes, bytes);
+            _covered[i] = 1;
+            if (--remaining == 0) break;
+        }
+    }
+
+    if (remaining == 0) return;
+    for (uint16_t i = 0; i < right - left; i++) {
+        if (!_covered[i]) {
+            memcpy(_row + i * bytes, _clear, bytes);
+        }
+    }
+}
+
+void ESP32_GIF_Compositor::freeBuffers() {
+    if (_row) {
+        ESP32_GIF_Utils::freeMemory(_row);
+        _row = nullptr;
+    }
+
+    if (_covered) {
+        ESP32_GIF_Utils::freeMemory(_covered);
+        _covered = nullptr;
+    }
+}
@@ -0,0 +1,140 @@
+/**
+ * @file ESP32_GIF_Compositor.h
+ * @brief Multi-layer compositor for several GIFs sharing one screen region
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Each layer is a decoder placed at a position and z-order inside the
+ * region. On every tick the due layers advance one frame, their dirty rects
+ * are united and only that rect is composed, top layer first, into a single
+ * row buffer and pushed once. Pixels already covered by an opaque pixel of
+ * a higher layer are never read from the layers below, and a row stops as
+ * soon as it is fully covered.
+ *
+ * Layers must use the compositor's pixel format and keep an alpha mask;
+ * add them before their GIFs are loaded so the mask covers the first frame.
+ * A layer whose GIF has ended or failed keeps its last frame and resumes
+ * when the decoder is reset or loads another GIF.
+ */
+
+#ifndef ESP32_GIF_COMPOSITOR_H
+#define ESP32_GIF_COMPOSITOR_H
+
+#include "ESP32_AnimatedGIF.h"
+
+// Maximum number of layers
+#ifndef ESP32_GIF_COMPOSITOR_MAX_LAYERS
+  #define ESP32_GIF_COMPOSITOR_MAX_LAYERS 8
+#endif
+
+class ESP32_GIF_Compositor {
+public:
+    ESP32_GIF_Compositor();
+    ~ESP32_GIF_Compositor();
+
+    /**
+     * @brief Initialize the screen region
+     * @param width Region width
+     * @param height Region height
+     * @param pixelFormat RGB565_LE, RGB565_BE, RGB888, ARGB8888 or GRAYSCALE_8BIT
+     * @return true if successful, false for another format or out of memory
+     */
+    bool begin(uint16_t width, uint16_t height, PixelFormat pixelFormat = PixelFormat::RGB565_LE);
+
+    /**
+     * @brief Set the output receiving composed rows
+     * @param callback Called with one row (height 1) of the dirty rect at a time
+     * @param userData User data for callback
+     */
+    void setOutput(FrameCallback callback, void* userData = nullptr);
+
+    /**
+     * @brief Set the color of pixels not covered by any layer
+     */
+    void setClearColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 0xFF);
+
+    /**
+     * @brief Add a layer
+     * @param gif Decoder initialized with the compositor's pixel format
+     * @param x Left edge in the region (may be negative)
+     * @param y Top edge in the region (may be negative)
+     * @param z Z-order, higher layers are drawn on top
+     * @return Layer handle, or -1 if the format differs or all layers are in use
+     */
+    int8_t addLayer(ESP32_AnimatedGIF* gif, int16_t x, int16_t y, int8_t z = 0);
+
+    /**
+     * @brief Remove a layer, its area is recomposed on the next tick
+     */
+    void removeLayer(int8_t layer);
+
+    /**
+     * @brief Move a layer
+     */
+    void setLayerPosition(int8_t layer, int16_t x, int16_t y);
+
+    /**
+     * @brief Change the z-order of a layer
+     */
+    void setLayerZ(int8_t layer, int8_t z);
+
+    /**
+     * @brief Show or hide a layer
+     */
+    void setLayerVisible(int8_t layer, bool visible);
+
+    /**
+     * @brief Mark a region area for recomposition on the next tick
+     */
+    void invalidate(int16_t x, int16_t y, uint16_t width, uint16_t height);
+
+    /**
+     * @brief Advance due layers and push the union of the dirty rects
+     * @param now Current time in milliseconds (e.g. millis())
+     * @return true if rows were pushed
+     */
+    bool tick(uint32_t now);
+
+private:
+    struct Layer {
+        ESP32_AnimatedGIF* gif;
+        int16_t x;
+        int16_t y;
+        int8_t z;
+        bool visible;
+        bool active;
+        bool running;
+        uint32_t due;
+    };
+
+    Layer _layers[ESP32_GIF_COMPOSITOR_MAX_LAYERS];
+    uint8_t _order[ESP32_GIF_COMPOSITOR_MAX_LAYERS];   // Visible layers, top first
+    uint8_t _layerCount;                                // Entries in _order
+
+    uint16_t _width;
+    uint16_t _height;
+    PixelFormat _pixelFormat;
+    uint8_t _bytesPerPixel;
+    uint8_t _clear[4];
+
+    FrameCallback _output;
+    void* _outputData;
+
+    uint8_t* _row;
+    uint8_t* _covered;
+
+    // Dirty rect in region coordinates (right and bottom exclusive)
+    int32_t _dirtyLeft;
+    int32_t _dirtyTop;
+    int32_t _dirtyRight;
+    int32_t _dirtyBottom;
+
+    void markDirty(int32_t x, int32_t y, int32_t width, int32_t height);
+    void markLayer(const Layer& layer);
+    void sortLayers();
+    void composeRow(int32_t y, int32_t left, int32_t right);
+    void freeBuffers();
+};
+
+#endif // ESP32_GIF_COMPOSITOR_H
@@ -0,0 +1,82 @@
+/**
+ * @file ESP32_GIF_Gamma.h
+ * @brief Compile-time gamma correction tables
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * The tables are generated by the compiler (C++14 or newer) and live in
+ * flash; pass one as ColorCorrection::gammaTable. With older language
+ * modes use ESP32_GIF_Utils::buildGammaTable() at runtime instead.
+ */
+
+#ifndef ESP32_GIF_GAMMA_H
+#define ESP32_GIF_GAMMA_H
+
+#include <stdint.h>
+
+#if __cplusplus >= 201402L
+  #define ESP32_ANIMATEDGIF_CONSTEXPR_GAMMA
+#endif
+
+#ifdef ESP32_ANIMATEDGIF_CONSTEXPR_GAMMA
+
+namespace ESP32_GIF_Gamma {
+
+    // 256-entry output curve
+    struct GammaTable {
+        uint8_t value[256];
+    };
+
+    constexpr double logarithm(double x) {
+        // Range-reduce to [0.5, 1), then ln(m) = 2 * atanh((m - 1) / (m + 1))
+        int exponent = 0;
+        while (x < 0.5) { x *= 2.0; exponent--; }
+        while (x >= 1.0) { x *= 0.5; exponent++; }
+        double y = (x - 1.0) / (x + 1.0);
+        double y2 = y * y;
+        double term = y;
+        double sum = 0.0;
+        for (int n = 1; n < 40; n += 2) {
+            sum += term / n;
+            term *= y2;
+        }
+        return 2.0 * sum + exponent * 0.69314718055994530942;
+    }
+
+    constexpr double exponential(double x) {
+        // exp(x) = exp(x / 64) ^ 64
+        double r = x / 64.0;
+        double term = 1.0;
+        double sum = 1.0;
+        for (int n = 1; n < 20; n++) {
+            term *= r / n;
+            sum += term;
+        }
+        for (int i = 0; i < 6; i++) {
+            sum *= sum;
+        }
+        return sum;
+    }
+
+    constexpr uint8_t gammaValue(int i, double gamma) {
+        return i == 0 ? 0 : (uint8_t)(255.0 * exponential(gamma * logarithm(i / 255.0)) + 0.5);
+    }
+
+    constexpr GammaTable makeGammaTable(double gamma) {
+        GammaTable table{};
+        for (int i = 0; i < 256; i++) {
+            table.value[i] = gammaValue(i, gamma);
+        }
+        return table;
+    }
+
+    // Common display curves
+    constexpr GammaTable GAMMA_1_8 = makeGammaTable(1.8);
+    constexpr GammaTable GAMMA_2_2 = makeGammaTable(2.2);
+    constexpr GammaTable GAMMA_2_5 = makeGammaTable(2.5);
+}
+
+#endif // ESP32_ANIMATEDGIF_CONSTEXPR_GAMMA
+
+#endif // ESP32_GIF_GAMMA_H
@@ -0,0 +1,101 @@
+/**
+ * @file ESP32_GIF_IOProfiler.cpp
+ * @brief DataReader wrapper that profiles how the decoder reads its source
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include "ESP32_GIF_IOProfiler.h"
+
+ESP32_GIF_IOProfiler::ESP32_GIF_IOProfiler() {
+    begin(nullptr, nullptr);
+}
+
+void ESP32_GIF_IOProfiler::begin(DataReader reader, void* userData) {
+    _reader = reader;
+    _readerData = userData;
+    _nextPosition = 0;
+    _started = false;
+    memset(&_file, 0, sizeof(_file));
+    memset(&_current, 0, sizeof(_current));
+    memset(&_frame, 0, sizeof(_frame));
+}
+
+bool ESP32_GIF_IOProfiler::read(void* profiler, uint8_t* buffer, uint32_t length, uint32_t position) {
+    ESP32_GIF_IOProfiler* self = static_cast<ESP32_GIF_IOProfiler*>(profiler);
+    if (!self->_reader) return false;
+
+    uint32_t start = ESP32_GIF_Platform::micros();
+    bool ok = self->_reader(self->_readerData, buffer, length, position);
+    uint32_t micros = ESP32_GIF_Platform::micros() - start;
+
+    // The first request is not a seek, whatever its position
+    bool seek = self->_started && position != self->_nextPosition;
+    record(self->_file, length, position, self->_nextPosition, seek, ok, micros);
+    record(self->_current, length, position, self->_nextPosition, seek, ok, micros);
+    self->_nextPosition = position + length;
+    self->_started = true;
+    return ok;
+}
+
+void ESP32_GIF_IOProfiler::addSourceBytes(uint32_t bytes) {
+    _file.sourceBytes += bytes;
+    _current.sourceBytes += bytes;
+}
+
+void ESP32_GIF_IOProfiler::endFrame() {
+    _frame = _current;
+    memset(&_current, 0, sizeof(_current));
+}
+
+void ESP32_GIF_IOProfiler::getFileStats(IOStats& stats) const {
+    stats = _file;
+    finish(stats);
+}
+
+void ESP32_GIF_IOProfiler::getFrameStats(IOStats& stats) const {
+    stats = _frame;
+    finish(stats);
+}
+
+uint8_t ESP32_GIF_IOProfiler::sizeBucket(uint32_t length) {
+    uint8_t bucket = 0;
+    while (length > 1 && bucket < ESP32_GIF_IO_SIZE_BUCKETS - 1) {
+        length >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+uint32_t ESP32_GIF_IOProfiler::bucketSize(uint8_t bucket) {
+    return 1u << bucket;
+}
+
+void ESP32_GIF_IOProfiler::record(IOStats& stats, uint32_t length, uint32_t position, uint32_t expected,
+                                  bool seek, bool ok, uint32_t micros) {
+    stats.calls++;
+    stats.bytes += length;
+    stats.sizeHistogram[sizeBucket(length)]++;
+    if (!ok) {
+        stats.failures++;
+    }
+    if (seek) {
+        stats.seeks++;
+        if (position < expected) {
+            stats.backwardSeeks++;
+            stats.seekDistance += expected - position;
+        } else {
+            stats.seekDistance += position - expected;
+        }
+    }
+    stats.stallMicros += micros;
+    if (micros > stats.maxStallMicros) {
+        stats.maxStallMicros = micros;
+    }
+}
+
+void ESP32_GIF_IOProfiler::finish(IOStats& stats) {
+    // Without a caching layer reporting its reads nothing is over-read
+    stats.overReadBytes = stats.sourceBytes > stats.bytes ? stats.sourceBytes - stats.bytes : 0;
+}
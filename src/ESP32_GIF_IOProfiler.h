@@ -0,0 +1,118 @@
+/**
+ * @file ESP32_GIF_IOProfiler.h
+ * @brief DataReader wrapper that profiles how the decoder reads its source
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Sits between the decoder and an application DataReader and records every
+ * call: a power-of-two histogram of request sizes, seeks (requests that do
+ * not start where the previous one ended), failed reads and the time spent
+ * blocked in the reader. A caching layer below the reader (sector buffers,
+ * read-ahead) reports what it really fetched with addSourceBytes(), so
+ * over-read bytes show up too.
+ *
+ *   ESP32_GIF_IOProfiler io;
+ *   io.begin(sdCardReader, &file);
+ *   gif.load(ESP32_GIF_IOProfiler::read, &io);
+ *   io.endFrame();                      // close the load window
+ *   gif.nextFrame();
+ *   io.endFrame();                      // getFrameStats() now covers the frame
+ *
+ * Statistics are kept for the whole file (since begin()) and for the last
+ * window closed by endFrame(). Comparing stallMicros with the frame time
+ * shows whether storage bandwidth or decoding limits the frame rate.
+ */
+
+#ifndef ESP32_GIF_IOPROFILER_H
+#define ESP32_GIF_IOPROFILER_H
+
+#include "ESP32_AnimatedGIF.h"
+
+// Request size buckets: 1, 2-3, 4-7, ... 4096-8191, 8192 and more bytes
+#define ESP32_GIF_IO_SIZE_BUCKETS 14
+
+// Reader statistics of a file or a frame
+struct IOStats {
+    uint32_t calls;             // Reader calls
+    uint32_t failures;          // Calls that returned false
+    uint64_t bytes;             // Bytes requested by the decoder
+    uint64_t sourceBytes;       // Bytes fetched by the caching layer (addSourceBytes)
+    uint64_t overReadBytes;     // sourceBytes beyond the requested bytes
+    uint32_t seeks;             // Calls not starting where the previous one ended
+    uint32_t backwardSeeks;     // Seeks to an earlier position
+    uint64_t seekDistance;      // Sum of the seek distances in bytes
+    uint64_t stallMicros;       // Time blocked in the reader
+    uint32_t maxStallMicros;    // Longest single call
+    uint32_t sizeHistogram[ESP32_GIF_IO_SIZE_BUCKETS];
+};
+
+class ESP32_GIF_IOProfiler {
+public:
+    ESP32_GIF_IOProfiler();
+
+    /**
+     * @brief Wrap a reader and clear all statistics
+     * @param reader Application reader doing the actual I/O
+     * @param userData User data for reader
+     */
+    void begin(DataReader reader, void* userData);
+
+    /**
+     * @brief DataReader to pass to ESP32_AnimatedGIF::load()
+     * @param profiler The ESP32_GIF_IOProfiler (load() user data)
+     */
+    static bool read(void* profiler, uint8_t* buffer, uint32_t length, uint32_t position);
+
+    /**
+     * @brief Report bytes fetched from the medium by a caching layer
+     * @param bytes Bytes read from the storage for the current request(s)
+     */
+    void addSourceBytes(uint32_t bytes);
+
+    /**
+     * @brief Close the current window, e.g. after load() and each nextFrame()
+     */
+    void endFrame();
+
+    /**
+     * @brief Statistics since begin()
+     * @param stats Reference to IOStats structure
+     */
+    void getFileStats(IOStats& stats) const;
+
+    /**
+     * @brief Statistics of the window closed by the last endFrame()
+     * @param stats Reference to IOStats structure
+     */
+    void getFrameStats(IOStats& stats) const;
+
+    /**
+     * @brief Histogram bucket of a request size
+     * @param length Request size in bytes
+     * @return Bucket index
+     */
+    static uint8_t sizeBucket(uint32_t length);
+
+    /**
+     * @brief Smallest request size of a histogram bucket
+     * @param bucket Bucket index
+     * @return Size in bytes
+     */
+    static uint32_t bucketSize(uint8_t bucket);
+
+private:
+    DataReader _reader;
+    void* _readerData;
+    uint32_t _nextPosition;     // Where a sequential request would start
+    bool _started;              // Any request seen yet
+    IOStats _file;
+    IOStats _current;           // Window since the last endFrame()
+    IOStats _frame;             // Last closed window
+
+    static void record(IOStats& stats, uint32_t length, uint32_t position, uint32_t expected,
+                       bool seek, bool ok, uint32_t micros);
+    static void finish(IOStats& stats);
+};
+
+#endif // ESP32_GIF_IOPROFILER_H
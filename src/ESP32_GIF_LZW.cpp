@@ -0,0 +1,246 @@
+/**
+ * @file ESP32_GIF_LZW.cpp
+ * @brief Streaming LZW decoder for GIF image data
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include "ESP32_GIF_LZW.h"
+#include "ESP32_AnimatedGIF.h"
+#include <algorithm>
+
+ESP32_GIF_LZW::ESP32_GIF_LZW()
+    : _reader(nullptr)
+    , _readerData(nullptr)
+    , _position(0)
+    , _nextSize(-1)
+    , _blockPos(0)
+    , _blockLength(0)
+    , _terminated(true)
+    , _truncated(false)
+    , _ended(true)
+    , _failed(false)
+    , _bits(0)
+    , _bitCount(0)
+    , _minCodeSize(0)
+    , _codeSize(0)
+    , _clearCode(0)
+    , _nextCode(0)
+    , _previous(-1)
+    , _first(0)
+    , _prefix(nullptr)
+    , _suffix(nullptr)
+    , _stack(nullptr)
+    , _stackSize(0) {
+}
+
+ESP32_GIF_LZW::~ESP32_GIF_LZW() {
+    release();
+}
+
+bool ESP32_GIF_LZW::begin(uint8_t minCodeSize, Reader reader, void* userData, uint32_t position) {
+    if (minCodeSize < 1 || minCodeSize > 8 || !reader) {
+        return false;
+    }
+
+    if (!_prefix) {
+        uint8_t* table = (uint8_t*)ESP32_GIF_Utils::allocateMemory(ESP32_GIF_LZW_MAX_CODES * 4, false);
+        if (!table) return false;
+        _prefix = (uint16_t*)table;
+        _suffix = table + ESP32_GIF_LZW_MAX_CODES * 2;
+        _stack = table + ESP32_GIF_LZW_MAX_CODES * 3;
+    }
+
+    _reader = reader;
+    _readerData = userData;
+    _position = position;
+    _nextSize = -1;
+    _blockPos = 0;
+    _blockLength = 0;
+    _terminated = false;
+    _truncated = false;
+    _ended = false;
+    _failed = false;
+    _bits = 0;
+    _bitCount = 0;
+    _minCodeSize = minCodeSize;
+    _clearCode = 1 << minCodeSize;
+    _stackSize = 0;
+    resetTable();
+    return true;
+}
+
+uint32_t ESP32_GIF_LZW::read(uint8_t* pixels, uint32_t count) {
+    const uint16_t endCode = _clearCode + 1;
+    uint32_t produced = 0;
+
+    while (produced < count) {
+        if (_stackSize > 0) {
+            // Strings are unpacked backwards onto the stack
+            uint32_t n = std::min<uint32_t>(_stackSize, count - produced);
+            if (pixels) {
+                uint8_t* dst = pixels + produced;
+                for (uint32_t i = 0; i < n; i++) {
+                    dst[i] = _stack[--_stackSize];
+                }
+            } else {
+                _stackSize -= n;
+            }
+            produced += n;
+            continue;
+        }
+
+        if (_ended) break;
+
+        int32_t code = nextCode();
+        if (code < 0 || code == endCode) {
+            _ended = true;
+            break;
+        }
+
+        if (code == _clearCode) {
+            resetTable();
+            continue;
+        }
+
+        if (_previous < 0) {
+            // First code after a clear is a single pixel
+            if (code > _clearCode) {
+                _failed = _ended = true;
+                break;
+            }
+            _first = code;
+            _previous = code;
+            if (pixels) pixels[produced] = code;
+            produced++;
+            continue;
+        }
+
+        int32_t current = code;
+        if (code > _nextCode) {
+            _failed = _ended = true;
+            break;
+        }
+
+        if (code == _nextCode) {
+            // String not in the table yet: previous string + its first pixel
+            _stack[_stackSize++] = _first;
+            code = _previous;
+        }
+
+        while (code > endCode) {
+            _stack[_stackSize++] = _suffix[code];
+            code = _prefix[code];
+        }
+        _first = code;
+        _stack[_stackSize++] = _first;
+
+        // A full table stays as it is until the next clear code
+        if (_nextCode < ESP32_GIF_LZW_MAX_CODES) {
+            _prefix[_nextCode] = _previous;
+            _suffix[_nextCode] = _first;
+            _nextCode++;
+            if (_nextCode == (1u << _codeSize) && _codeSize < 12) {
+                _codeSize++;
+            }
+        }
+        _previous = current;
+    }
+
+    return produced;
+}
+
+bool ESP32_GIF_LZW::finish(uint32_t& position) {
+    // Skip the remaining sub-blocks without reading their data
+    while (!_terminated && !_truncated) {
+        if (_nextSize < 0) {
+            uint8_t size;
+            if (!_reader(_readerData, &size, 1, _position)) {
+                _truncated = true;
+                break;
+            }
+            _position += 1;
+            _nextSize = size;
+        }
+
+        if (_nextSize == 0) {
+            _terminated = true;
+        } else {
+            _position += _nextSize;
+        }
+        _nextSize = -1;
+    }
+
+    _ended = true;
+    _stackSize = 0;
+    position = _position;
+    return !_truncated;
+}
+
+void ESP32_GIF_LZW::release() {
+    if (_prefix) {
+        ESP32_GIF_Utils::freeMemory(_prefix);
+        _prefix = nullptr;
+        _suffix = nullptr;
+        _stack = nullptr;
+    }
+}
+
+bool ESP32_GIF_LZW::readBlock() {
+    if (_terminated || _truncated) return false;
+
+    if (_nextSize < 0) {
+        uint8_t size;
+        if (!_reader(_readerData, &size, 1, _position)) {
+            _truncated = _failed = true;
+            return false;
+        }
+        _position += 1;
+        _nextSize = size;
+    }
+
+    uint8_t size = _nextSize;
+    if (size == 0) {
+        _terminated = true;
+        _nextSize = -1;
+        return false;
+    }
+
+    // Fetch the size of the next sub-block with this one
+    if (_reader(_readerData, _block, size + 1, _position)) {
+        _nextSize = _block[size];
+        _position += size + 1;
+    } else if (_reader(_readerData, _block, size, _position)) {
+        _nextSize = -1;
+        _position += size;
+    } else {
+        _truncated = _failed = true;
+        return false;
+    }
+
+    _blockPos = 0;
+    _blockLength = size;
+    return true;
+}
+
+int32_t ESP32_GIF_LZW::nextCode() {
+    while (_bitCount < _codeSize) {
+        if (_blockPos >= _blockLength && !readBlock()) {
+            return -1;
+        }
+        _bits |= (uint32_t)_block[_blockPos++] << _bitCount;
+        _bitCount += 8;
+    }
+
+    int32_t code = _bits & ((1u << _codeSize) - 1);
+    _bits >>= _codeSize;
+    _bitCount -= _codeSize;
+    return code;
+}
+
+void ESP32_GIF_LZW::resetTable() {
+    _codeSize = _minCodeSize + 1;
+    _nextCode = _clearCode + 2;
+    _previous = -1;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file ESP32_GIF_LZW.h
+ * @brief Streaming LZW decoder for GIF image data
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Codes are pulled across the data sub-blocks through a DataReader-style
+ * callback and unpacked into caller buffers in chunks of any size, so a
+ * frame is decoded one row at a time without buffering the whole image.
+ * Each sub-block is read together with the size byte of the next one,
+ * one reader call per block. The string table (16 KB) is allocated on
+ * first use and kept for later frames.
+ */
+
+#ifndef ESP32_GIF_LZW_H
+#define ESP32_GIF_LZW_H
+
+#include <stdint.h>
+
+// GIF codes are at most 12 bits wide
+#define ESP32_GIF_LZW_MAX_CODES 4096
+
+class ESP32_GIF_LZW {
+public:
+    typedef bool (*Reader)(void* userData, uint8_t* buffer, uint32_t length, uint32_t position);
+
+    ESP32_GIF_LZW();
+    ~ESP32_GIF_LZW();
+
+    /**
+     * @brief Start decoding the image data of one frame
+     * @param minCodeSize LZW minimum code size (1-8), the first image data byte
+     * @param reader Data source
+     * @param userData User data for reader
+     * @param position Position of the first sub-block size byte
+     * @return true if successful, false for a bad code size or out of memory
+     */
+    bool begin(uint8_t minCodeSize, Reader reader, void* userData, uint32_t position);
+
+    /**
+     * @brief Decode the next pixels
+     * @param pixels Destination for palette indices, nullptr to drop them
+     * @param count Number of pixels
+     * @return Pixels decoded, less than count once the data ends
+     */
+    uint32_t read(uint8_t* pixels, uint32_t count);
+
+    /**
+     * @brief Skip the rest of the image data
+     * @param position Receives the position after the block terminator
+     * @return true if successful, false if the data is truncated
+     */
+    bool finish(uint32_t& position);
+
+    /**
+     * @brief Check for corrupt codes or a failed read
+     */
+    bool failed() const { return _failed; }
+
+    /**
+     * @brief Release the string table
+     */
+    void release();
+
+private:
+    Reader _reader;
+    void* _readerData;
+    uint32_t _position;     // Next byte to read from the source
+    int16_t _nextSize;      // Prefetched size of the next sub-block, -1 if unknown
+
+    uint8_t _block[256];
+    uint8_t _blockPos;
+    uint8_t _blockLength;
+    bool _terminated;       // Block terminator reached
+    bool _truncated;        // Reader failed before the terminator
+    bool _ended;            // End code or end of data reached
+    bool _failed;
+
+    uint32_t _bits;
+    uint8_t _bitCount;
+    uint8_t _minCodeSize;
+    uint8_t _codeSize;
+    uint16_t _clearCode;
+    uint16_t _nextCode;
+    int16_t _previous;      // Previous code, -1 after a clear code
+    uint8_t _first;         // First pixel of the previous string
+
+    // String table and unpack stack, one allocation
+    uint16_t* _prefix;
+    uint8_t* _suffix;
+    uint8_t* _stack;
+    uint16_t _stackSize;
+
+    bool readBlock();
+    int32_t nextCode();
+    void resetTable();
+};
+
+#endif // ESP32_GIF_LZW_H
@@ -0,0 +1,96 @@
+/**
+ * @file ESP32_GIF_Prerendered.cpp
+ * @brief Pre-rendered animation format played without LZW decoding
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include "ESP32_GIF_Prerendered.h"
+#include <string.h>
+
+namespace ESP32_GIF_Prerendered {
+    bool isPrerendered(const uint8_t* header) {
+        return memcmp(header, "GIFR", 4) == 0 && header[4] == ESP32_GIF_PRERENDERED_VERSION;
+    }
+
+    uint32_t maxEncodedSize(uint32_t rowBytes, uint8_t unitBytes) {
+        // All literals: one token per ESP32_GIF_PRERENDERED_MAX_RUN units
+        uint32_t units = rowBytes / unitBytes;
+        return rowBytes + (units + ESP32_GIF_PRERENDERED_MAX_RUN - 1) / ESP32_GIF_PRERENDERED_MAX_RUN;
+    }
+
+    static uint32_t runLength(const uint8_t* row, uint32_t unit, uint32_t units, uint8_t unitBytes) {
+        // Units equal to the one at unit, at most one token
+        const uint8_t* first = row + unit * unitBytes;
+        uint32_t length = 1;
+        while (unit + length < units && length < ESP32_GIF_PRERENDERED_MAX_RUN &&
+               memcmp(first, first + length * unitBytes, unitBytes) == 0) {
+            length++;
+        }
+        return length;
+    }
+
+    uint32_t encodeRow(const uint8_t* row, uint32_t rowBytes, uint8_t unitBytes, uint8_t* out) {
+        // A repeat pays off from 2 units, or 3 single-byte units
+        const uint32_t units = rowBytes / unitBytes;
+        const uint32_t minRun = unitBytes > 1 ? 2 : 3;
+        uint8_t* start = out;
+        uint32_t unit = 0;
+
+        while (unit < units) {
+            uint32_t run = runLength(row, unit, units, unitBytes);
+            if (run >= minRun) {
+                *out++ = 0x7F + run;
+                memcpy(out, row + unit * unitBytes, unitBytes);
+                out += unitBytes;
+                unit += run;
+                continue;
+            }
+
+            // Literal up to the next worthwhile run
+            uint32_t literal = 0;
+            while (unit + literal < units && literal < ESP32_GIF_PRERENDERED_MAX_RUN) {
+                if (literal > 0 && runLength(row, unit + literal, units, unitBytes) >= minRun) break;
+                literal++;
+            }
+            *out++ = literal - 1;
+            memcpy(out, row + unit * unitBytes, literal * unitBytes);
+            out += literal * unitBytes;
+            unit += literal;
+        }
+        return out - start;
+    }
+
+    bool decodeRow(const uint8_t* in, uint32_t length, uint8_t* row, uint32_t rowBytes, uint8_t unitBytes) {
+        const uint8_t* end = in + length;
+        uint32_t filled = 0;
+
+        while (in < end) {
+            uint8_t token = *in++;
+            if (token < 0x80) {
+                uint32_t bytes = (token + 1) * unitBytes;
+                if (bytes > (uint32_t)(end - in) || filled + bytes > rowBytes) return false;
+                memcpy(row + filled, in, bytes);
+                in += bytes;
+                filled += bytes;
+            } else {
+                uint32_t count = token - 0x7F;
+                uint32_t bytes = count * unitBytes;
+                if (unitBytes > (uint32_t)(end - in) || filled + bytes > rowBytes) return false;
+                if (unitBytes == 1) {
+                    memset(row + filled, *in, count);
+                } else {
+                    // Double the copied units until the run is filled
+                    memcpy(row + filled, in, unitBytes);
+                    for (uint32_t done = unitBytes; done < bytes; done *= 2) {
+                        memcpy(row + filled + done, row + filled, (done < bytes - done) ? done : bytes - done);
+                    }
+                }
+                filled += bytes;
+                in += unitBytes;
+            }
+        }
+        return filled == rowBytes;
+    }
+}
@@ -0,0 +1,88 @@
+/**
+ * @file ESP32_GIF_Prerendered.h
+ * @brief Pre-rendered animation format played without LZW decoding
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * A GIF converted on the host (tools/prerender/gifprerender) into the
+ * changed canvas rect of every frame, already in the display pixel format.
+ * ESP32_AnimatedGIF::loadPrerendered() plays it through the same outputs
+ * and frame pacing as a GIF: playing a frame is reading its rows into the
+ * canvas, optionally expanding runs, and emitting them.
+ *
+ * File layout (all multi-byte values little endian):
+ *
+ *   header        'G' 'I' 'F' 'R', u8 version, u8 pixelFormat, u8 flags,
+ *                 u8 reserved, u16 width, u16 height, u16 frameCount,
+ *                 u16 reserved, u32 totalDuration (ms), u32 tableOffset
+ *   frame table   (frameCount + 1) x u32 record offset, the last one is the
+ *                 end of the data (random access, record sizes)
+ *   frame record  u16 delay (ms), u16 x, u16 y, u16 width, u16 height,
+ *                 u16 reserved, then height rows
+ *
+ * A raw row is the canvas bytes of the rect row. Packed formats (less than
+ * 8 bits or RGB444) have x on a byte boundary and width widened like the
+ * frame callback spans. With ESP32_GIF_PRERENDERED_RLE every row is a u16
+ * byte count followed by run tokens over units of one pixel (one byte for
+ * the packed formats):
+ *
+ *   0x00-0x7F    literal  followed by (token + 1) units
+ *   0x80-0xFF    repeat   followed by one unit, repeated (token - 0x7F) times
+ *
+ * An empty rect (frame identical to the previous one) only holds a delay.
+ */
+
+#ifndef ESP32_GIF_PRERENDERED_H
+#define ESP32_GIF_PRERENDERED_H
+
+#include <stdint.h>
+
+#define ESP32_GIF_PRERENDERED_VERSION       1
+#define ESP32_GIF_PRERENDERED_HEADER_SIZE   24
+#define ESP32_GIF_PRERENDERED_RECORD_SIZE   12
+
+// Header flags
+#define ESP32_GIF_PRERENDERED_RLE           0x01
+
+// Longest run of one token
+#define ESP32_GIF_PRERENDERED_MAX_RUN       128
+
+namespace ESP32_GIF_Prerendered {
+    /**
+     * @brief Check the magic and version of a file header
+     * @param header First ESP32_GIF_PRERENDERED_HEADER_SIZE bytes of the file
+     */
+    bool isPrerendered(const uint8_t* header);
+
+    /**
+     * @brief Largest encoded size of a row
+     * @param rowBytes Raw row size
+     * @param unitBytes Run unit size (bytes per pixel, 1 for packed formats)
+     * @return Token bytes, without the u16 byte count
+     */
+    uint32_t maxEncodedSize(uint32_t rowBytes, uint8_t unitBytes);
+
+    /**
+     * @brief Run-length code one row
+     * @param row Raw row (a whole number of units)
+     * @param rowBytes Raw row size
+     * @param unitBytes Run unit size
+     * @param out Buffer of at least maxEncodedSize() bytes
+     * @return Encoded size
+     */
+    uint32_t encodeRow(const uint8_t* row, uint32_t rowBytes, uint8_t unitBytes, uint8_t* out);
+
+    /**
+     * @brief Expand one run-length coded row
+     * @param in Run tokens
+     * @param length Token bytes
+     * @param row Destination of rowBytes bytes
+     * @param rowBytes Raw row size
+     * @param unitBytes Run unit size
+     * @return false if the tokens do not cover exactly rowBytes
+     */
+    bool decodeRow(const uint8_t* in, uint32_t length, uint8_t* row, uint32_t rowBytes, uint8_t unitBytes);
+}
+
+#endif // ESP32_GIF_PRERENDERED_H
@@ -0,0 +1,446 @@
+/**
+ * @file ESP32_GIF_Reference.cpp
+ * @brief Reference GIF decoder for conformance checks
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include "ESP32_GIF_Reference.h"
+
+ESP32_GIF_Reference::ESP32_GIF_Reference()
+    : _data(nullptr)
+    , _length(0)
+    , _position(0)
+    , _width(0)
+    , _height(0)
+    , _frame(0)
+    , _globalColorTable(nullptr)
+    , _globalColorTableSize(0)
+    , _backgroundColor(0)
+    , _canvas(nullptr)
+    , _saved(nullptr)
+    , _indices(nullptr)
+    , _indicesSize(0)
+    , _colorMap(nullptr)
+    , _colorMapData(nullptr)
+    , _pendingDisposal(0)
+    , _disposeX(0)
+    , _disposeY(0)
+    , _disposeWidth(0)
+    , _disposeHeight(0)
+    , _blockRemaining(0)
+    , _blockEnd(true)
+    , _bits(0)
+    , _bitCount(0) {
+}
+
+ESP32_GIF_Reference::~ESP32_GIF_Reference() {
+    release();
+}
+
+void ESP32_GIF_Reference::release() {
+    ESP32_GIF_Utils::freeMemory(_canvas);
+    ESP32_GIF_Utils::freeMemory(_saved);
+    ESP32_GIF_Utils::freeMemory(_indices);
+    _canvas = nullptr;
+    _saved = nullptr;
+    _indices = nullptr;
+    _indicesSize = 0;
+}
+
+void ESP32_GIF_Reference::setColorMap(ReferenceColorMap map, void* userData) {
+    _colorMap = map;
+    _colorMapData = userData;
+}
+
+bool ESP32_GIF_Reference::load(const uint8_t* data, uint32_t length) {
+    release();
+    _data = data;
+    _length = length;
+    _frame = 0;
+    _pendingDisposal = 0;
+
+    if (!data || length < 13 || memcmp(data, "GIF", 3) != 0) {
+        return false;
+    }
+
+    _width = data[6] | (data[7] << 8);
+    _height = data[8] | (data[9] << 8);
+    _backgroundColor = data[11];
+    _position = 13;
+    _globalColorTable = nullptr;
+    _globalColorTableSize = 0;
+
+    if (data[10] & 0x80) {
+        _globalColorTableSize = 2 << (data[10] & 0x07);
+        _globalColorTable = data + 13;
+        _position += _globalColorTableSize * 3;
+        if (_position > length) return false;
+    }
+
+    if (_width == 0 || _height == 0) return false;
+    size_t size = (size_t)_width * _height * sizeof(Pixel);
+    _canvas = (Pixel*)ESP32_GIF_Utils::allocateMemory(size, true);
+    _saved = (Pixel*)ESP32_GIF_Utils::allocateMemory(size, true);
+    if (!_canvas || !_saved) return false;
+    memset(_canvas, 0, size);
+    memset(_saved, 0, size);
+    return true;
+}
+
+bool ESP32_GIF_Reference::nextFrame() {
+    if (!_canvas) return false;
+
+    uint8_t disposal = 0;
+    int16_t transparent = -1;
+
+    while (_position < _length) {
+        uint8_t type = _data[_position];
+
+        if (type == 0x21) {
+            // Extension; only the graphics control extension matters
+            if (_position + 2 > _length) return false;
+            uint8_t label = _data[_position + 1];
+            _position += 2;
+            if (label == 0xF9 && _position + 5 <= _length) {
+                uint8_t packed = _data[_position + 1];
+                disposal = (packed >> 2) & 0x07;
+                transparent = (packed & 0x01) ? _data[_position + 4] : -1;
+            }
+            if (!skipSubBlocks()) return false;
+            continue;
+        }
+
+        if (type != 0x2C) {
+            // Trailer or garbage
+            return false;
+        }
+
+        // Image descriptor
+        if (_position + 10 > _length) return false;
+        const uint8_t* d = _data + _position + 1;
+        uint16_t frameX = d[0] | (d[1] << 8);
+        uint16_t frameY = d[2] | (d[3] << 8);
+        uint16_t frameWidth = d[4] | (d[5] << 8);
+        uint16_t frameHeight = d[6] | (d[7] << 8);
+        uint8_t flags = d[8];
+        _position += 10;
+
+        const uint8_t* colorTable = _globalColorTable;
+        uint16_t colorTableSize = _globalColorTableSize;
+        if (flags & 0x80) {
+            colorTableSize = 2 << (flags & 0x07);
+            colorTable = _data + _position;
+            _position += colorTableSize * 3;
+        }
+        if (_position + 1 > _length) return false;
+
+        uint8_t minCodeSize = _data[_position++];
+        if (minCodeSize < 1 || minCodeSize > 8) return false;
+
+        // Decode the whole frame rect, missing pixels become transparent
+        uint32_t pixelCount = (uint32_t)frameWidth * frameHeight;
+        if (pixelCount > _indicesSize) {
+            ESP32_GIF_Utils::freeMemory(_indices);
+            _indices = (uint8_t*)ESP32_GIF_Utils::allocateMemory(pixelCount, true);
+            _indicesSize = _indices ? pixelCount : 0;
+            if (!_indices) return false;
+        }
+        uint32_t decoded = decodeImage(minCodeSize, pixelCount);
+        if (decoded < pixelCount) {
+            memset(_indices + decoded, transparent >= 0 ? transparent : 0, pixelCount - decoded);
+        }
+        if (!skipSubBlocks()) return false;
+
+        if (!colorTable) {
+            // Nothing to draw with; the frame is skipped
+            _frame++;
+            return true;
+        }
+
+        // Dispose the previous frame
+        for (uint16_t y = _disposeY; y < _disposeY + _disposeHeight; y++) {
+            for (uint16_t x = _disposeX; x < _disposeX + _disposeWidth; x++) {
+                size_t i = (size_t)y * _width + x;
+                if (_pendingDisposal == 2) {
+                    _canvas[i].state = BACKGROUND;
+                } else if (_pendingDisposal == 3) {
+                    _canvas[i] = _saved[i];
+                }
+            }
+        }
+
+        // Clip the frame rect to the canvas
+        uint16_t width = 0;
+        uint16_t height = 0;
+        if (frameX < _width && frameY < _height) {
+            width = frameWidth < _width - frameX ? frameWidth : _width - frameX;
+            height = frameHeight < _height - frameY ? frameHeight : _height - frameY;
+        }
+
+        if (disposal == 3) {
+            for (uint16_t y = frameY; y < frameY + height; y++) {
+                for (uint16_t x = frameX; x < frameX + width; x++) {
+                    _saved[(size_t)y * _width + x] = _canvas[(size_t)y * _width + x];
+                }
+            }
+        }
+
+        for (uint32_t y = 0; y < height; y++) {
+            // Row of the image data that holds image row y
+            uint32_t row = y;
+            if (flags & 0x40) {
+                uint32_t pass1 = (frameHeight + 7) / 8;
+                uint32_t pass2 = pass1 + (frameHeight + 3) / 8;
+                uint32_t pass3 = pass2 + (frameHeight + 1) / 4;
+                if (y % 8 == 0) {
+                    row = y / 8;
+                } else if (y % 8 == 4) {
+                    row = pass1 + y / 8;
+                } else if (y % 4 == 2) {
+                    row = pass2 + y / 4;
+                } else {
+                    row = pass3 + y / 2;
+                }
+            }
+
+            for (uint32_t x = 0; x < width; x++) {
+                uint8_t index = _indices[row * frameWidth + x];
+                if (index == transparent) continue;
+
+                Pixel& pixel = _canvas[(size_t)(frameY + y) * _width + frameX + x];
+                pixel.index = index;
+                pixel.state = OPAQUE;
+                if (index < colorTableSize) {
+                    uint8_t rgb[3] = { colorTable[index * 3], colorTable[index * 3 + 1], colorTable[index * 3 + 2] };
+                    if (_colorMap) {
+                        _colorMap(_colorMapData, frameX + x, frameY + y, rgb);
+                    }
+                    pixel.r = rgb[0];
+                    pixel.g = rgb[1];
+                    pixel.b = rgb[2];
+                } else {
+                    pixel.r = pixel.g = pixel.b = 0;
+                }
+            }
+        }
+
+        _pendingDisposal = disposal;
+        _disposeX = frameX;
+        _disposeY = frameY;
+        _disposeWidth = width;
+        _disposeHeight = height;
+        _frame++;
+        return true;
+    }
+    return false;
+}
+
+void ESP32_GIF_Reference::render(uint8_t* canvas, PixelFormat format, const uint8_t* background, bool dither) const {
+    uint8_t bpp = ESP32_GIF_Utils::bitsPerPixel(format);
+    size_t stride = ((size_t)_width * bpp + 7) / 8;
+    memset(canvas, 0, stride * _height);
+    if (!_canvas || bpp == 0) return;
+
+    uint8_t bgR = 0, bgG = 0, bgB = 0, bgIndex = 0;
+    if (_globalColorTable && _backgroundColor < _globalColorTableSize) {
+        bgR = _globalColorTable[_backgroundColor * 3];
+        bgG = _globalColorTable[_backgroundColor * 3 + 1];
+        bgB = _globalColorTable[_backgroundColor * 3 + 2];
+        bgIndex = _backgroundColor;
+        if (_colorMap) {
+            uint8_t rgb[3] = { bgR, bgG, bgB };
+            _colorMap(_colorMapData, -1, -1, rgb);
+            bgR = rgb[0];
+            bgG = rgb[1];
+            bgB = rgb[2];
+        }
+    }
+
+    for (uint16_t y = 0; y < _height; y++) {
+        for (uint16_t x = 0; x < _width; x++) {
+            const Pixel& pixel = _canvas[(size_t)y * _width + x];
+            size_t bit = (size_t)y * stride * 8 + (size_t)x * bpp;
+            uint32_t value = 0;
+
+            if (pixel.state != OPAQUE && background) {
+                // Copy the pixel bits of the background image
+                for (uint8_t i = 0; i < bpp; i++) {
+                    size_t b = bit + i;
+                    value = (value << 1) | ((background[b >> 3] >> (7 - (b & 7))) & 1);
+                }
+            } else if (pixel.state != EMPTY) {
+                bool opaque = pixel.state == OPAQUE;
+                uint8_t r = opaque ? pixel.r : bgR;
+                uint8_t g = opaque ? pixel.g : bgG;
+                uint8_t b = opaque ? pixel.b : bgB;
+                uint8_t gray = ESP32_GIF_Utils::rgb888ToGrayscale(r, g, b);
+                uint16_t rgb565 = ESP32_GIF_Utils::rgb888To565(r, g, b);
+
+                switch (format) {
+                    case PixelFormat::RGB565_LE:
+                        value = ((rgb565 & 0xFF) << 8) | (rgb565 >> 8);
+                        break;
+                    case PixelFormat::RGB565_BE:
+                        value = rgb565;
+                        break;
+                    case PixelFormat::RGB888:
+                        value = ((uint32_t)r << 16) | (g << 8) | b;
+                        break;
+                    case PixelFormat::ARGB8888:
+                        value = ((uint32_t)(opaque ? 0xFF : 0x00) << 24) | ((uint32_t)r << 16) | (g << 8) | b;
+                        break;
+                    case PixelFormat::GRAYSCALE_8BIT:
+                        value = gray;
+                        break;
+                    case PixelFormat::INDEXED8:
+                        value = opaque ? pixel.index : bgIndex;
+                        break;
+                    case PixelFormat::RGB332:
+                        value = (r & 0xE0) | ((g & 0xE0) >> 3) | (b >> 6);
+                        break;
+                    case PixelFormat::RGB444:
+                        value = ((r >> 4) << 8) | ((g >> 4) << 4) | (b >> 4);
+                        break;
+                    default: {
+                        uint8_t maxLevel = (1 << bpp) - 1;
+                        uint8_t threshold = dither ? ESP32_GIF_Utils::bayerRow(y)[x & 7] : 127;
+                        value = (gray * maxLevel + threshold) / 255;
+                        break;
+                    }
+                }
+            }
+
+            // Store MSB first; multi-byte formats are big endian bit strings
+            for (uint8_t i = 0; i < bpp; i++) {
+                size_t b = bit + i;
+                if ((value >> (bpp - 1 - i)) & 1) {
+                    canvas[b >> 3] |= 0x80 >> (b & 7);
+                }
+            }
+        }
+    }
+}
+
+void ESP32_GIF_Reference::renderMask(uint8_t* mask, bool background) const {
+    size_t stride = (_width + 7) / 8;
+    memset(mask, 0, stride * _height);
+    if (!_canvas) return;
+
+    for (uint16_t y = 0; y < _height; y++) {
+        for (uint16_t x = 0; x < _width; x++) {
+            if (_canvas[(size_t)y * _width + x].state == OPAQUE || background) {
+                mask[y * stride + (x >> 3)] |= 0x80 >> (x & 7);
+            }
+        }
+    }
+}
+
+int16_t ESP32_GIF_Reference::readByte() {
+    // Next image data byte across the sub-blocks, -1 at the terminator
+    if (_blockEnd) return -1;
+    if (_blockRemaining == 0) {
+        if (_position >= _length || _data[_position] == 0) {
+            _blockEnd = true;
+            return -1;
+        }
+        _blockRemaining = _data[_position++];
+    }
+    if (_position >= _length) {
+        _blockEnd = true;
+        return -1;
+    }
+    _blockRemaining--;
+    return _data[_position++];
+}
+
+int32_t ESP32_GIF_Reference::readCode(uint8_t size) {
+    while (_bitCount < size) {
+        int16_t byte = readByte();
+        if (byte < 0) return -1;
+        _bits |= (uint32_t)byte << _bitCount;
+        _bitCount += 8;
+    }
+    int32_t code = _bits & ((1u << size) - 1);
+    _bits >>= size;
+    _bitCount -= size;
+    return code;
+}
+
+uint32_t ESP32_GIF_Reference::decodeImage(uint8_t minCodeSize, uint32_t pixelCount) {
+    // Textbook LZW: every string is its prefix string plus one suffix byte
+    const uint16_t clearCode = 1 << minCodeSize;
+    const uint16_t endCode = clearCode + 1;
+    uint16_t nextCode = clearCode + 2;
+    uint8_t codeSize = minCodeSize + 1;
+    int32_t previous = -1;
+    uint32_t count = 0;
+
+    for (uint16_t i = 0; i < clearCode; i++) {
+        _prefix[i] = 0;
+        _suffix[i] = i;
+    }
+    _blockRemaining = 0;
+    _blockEnd = false;
+    _bits = 0;
+    _bitCount = 0;
+
+    while (count < pixelCount) {
+        int32_t code = readCode(codeSize);
+        if (code < 0 || code == endCode) break;
+
+        if (code == clearCode) {
+            nextCode = clearCode + 2;
+            codeSize = minCodeSize + 1;
+            previous = -1;
+            continue;
+        }
+        if (code > nextCode || (code == nextCode && previous < 0)) {
+            break; // Corrupt data
+        }
+
+        // Unwind the string of code (of previous for a code not yet in the table)
+        uint16_t depth = 0;
+        uint16_t c = (code == nextCode) ? previous : code;
+        while (true) {
+            _stack[depth++] = _suffix[c];
+            if (c < clearCode) break;
+            c = _prefix[c];
+        }
+        uint8_t first = _stack[depth - 1];
+
+        while (depth > 0 && count < pixelCount) {
+            _indices[count++] = _stack[--depth];
+        }
+        if (code == nextCode && count < pixelCount) {
+            _indices[count++] = first;
+        }
+
+        if (previous >= 0 && nextCode < 4096) {
+            _prefix[nextCode] = previous;
+            _suffix[nextCode] = first;
+            nextCode++;
+            if (nextCode == (1 << codeSize) && codeSize < 12) {
+                codeSize++;
+            }
+        }
+        previous = code;
+    }
+    return count;
+}
+
+bool ESP32_GIF_Reference::skipSubBlocks() {
+    // Skip the rest of the current sub-block and everything up to the terminator
+    if (!_blockEnd && _blockRemaining > 0) {
+        _position += _blockRemaining;
+    }
+    _blockRemaining = 0;
+    _blockEnd = true;
+    while (_position < _length) {
+        uint8_t size = _data[_position++];
+        if (size == 0) return true;
+        _position += size;
+    }
+    return false;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file ESP32_GIF_Reference.h
+ * @brief Reference GIF decoder for conformance checks
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Decodes an in-memory GIF with the plainest code possible: the whole
+ * frame is LZW-decoded into an index buffer, composed pixel by pixel onto
+ * a canvas of (color, palette index, state) entries, and only converted to
+ * a pixel format on request. It has no LUTs, caches, spans or streaming,
+ * and none of its code is shared with the ESP32_AnimatedGIF render path,
+ * so the canvas and outputs of the decoder can be compared against it
+ * frame by frame (see tools/conform).
+ *
+ * It follows the documented behavior of ESP32_AnimatedGIF: an untouched
+ * canvas is all zero bits, disposal to background uses the GIF background
+ * color with alpha 0 (or the background image), and palette indices past
+ * the end of the color table are black. It is slow and uses 5 bytes per
+ * canvas pixel plus the frame rect; it is meant for hosts, not displays.
+ */
+
+#ifndef ESP32_GIF_REFERENCE_H
+#define ESP32_GIF_REFERENCE_H
+
+#include "ESP32_AnimatedGIF.h"
+
+/**
+ * @brief Maps a color in place before it reaches the canvas
+ * @param x Canvas x of a frame pixel, -1 for the background color
+ * @param y Canvas y of a frame pixel, -1 for the background color
+ * @param rgb Red, green and blue
+ */
+typedef void (*ReferenceColorMap)(void* userData, int32_t x, int32_t y, uint8_t* rgb);
+
+class ESP32_GIF_Reference {
+public:
+    ESP32_GIF_Reference();
+    ~ESP32_GIF_Reference();
+
+    /**
+     * @brief Parse the header of a GIF in memory
+     * @param data GIF data, must stay valid while decoding
+     * @param length Data length
+     * @return true if successful
+     */
+    bool load(const uint8_t* data, uint32_t length);
+
+    /**
+     * @brief Map the colors of the following frames, e.g. to a device palette
+     * @param map Called for every opaque pixel of a frame, top-down and left
+     *            to right, and for the background color on every render
+     *            (nullptr disables); it is kept across load()
+     * @param userData User data passed to the map
+     */
+    void setColorMap(ReferenceColorMap map, void* userData);
+
+    /**
+     * @brief Compose the next frame onto the canvas
+     * @return true if a frame was composed, false at the trailer or on bad data
+     */
+    bool nextFrame();
+
+    /**
+     * @brief Number of frames composed so far
+     */
+    uint16_t getCurrentFrame() const { return _frame; }
+
+    uint16_t getCanvasWidth() const { return _width; }
+    uint16_t getCanvasHeight() const { return _height; }
+
+    /**
+     * @brief Convert the canvas to a pixel format
+     * @param canvas Destination in the frame buffer layout of the format
+     *               (rows of (width * bits + 7) / 8 bytes)
+     * @param format Pixel format
+     * @param background Optional background image in the same layout, shown
+     *                   where the canvas is untouched or disposed
+     * @param dither Ordered dithering of the packed gray formats
+     */
+    void render(uint8_t* canvas, PixelFormat format, const uint8_t* background = nullptr, bool dither = false) const;
+
+    /**
+     * @brief Packed 1-bit coverage mask of the canvas (1 = opaque, MSB first)
+     * @param mask Destination, (width + 7) / 8 bytes per row
+     * @param background true if a background image or callback is set
+     */
+    void renderMask(uint8_t* mask, bool background) const;
+
+private:
+    enum State : uint8_t {
+        EMPTY = 0,      // Never drawn
+        BACKGROUND,     // Disposed to background
+        OPAQUE          // Pixel of a frame
+    };
+
+    struct Pixel {
+        uint8_t r, g, b;
+        uint8_t index;
+        uint8_t state;
+    };
+
+    const uint8_t* _data;
+    uint32_t _length;
+    uint32_t _position;
+
+    uint16_t _width;
+    uint16_t _height;
+    uint16_t _frame;
+    const uint8_t* _globalColorTable;
+    uint16_t _globalColorTableSize;
+    uint8_t _backgroundColor;
+
+    Pixel* _canvas;
+    Pixel* _saved;              // Canvas before a "restore to previous" frame
+    uint8_t* _indices;          // Palette indices of the frame rect
+    uint32_t _indicesSize;
+
+    ReferenceColorMap _colorMap;
+    void* _colorMapData;
+
+    // Disposal of the last frame, applied before the next one
+    uint8_t _pendingDisposal;
+    uint16_t _disposeX, _disposeY, _disposeWidth, _disposeHeight;
+
+    // LZW string table and image data reader state
+    uint16_t _prefix[4096];
+    uint8_t _suffix[4096];
+    uint8_t _stack[4096];
+    uint32_t _blockRemaining;
+    bool _blockEnd;
+    uint32_t _bits;
+    uint8_t _bitCount;
+
+    int16_t readByte();
+    int32_t readCode(uint8_t size);
+    uint32_t decodeImage(uint8_t minCodeSize, uint32_t pixelCount);
+    bool skipSubBlocks();
+    void release();
+};
+
+#endif // ESP32_GIF_REFERENCE_H
@@ -0,0 +1,403 @@
+/**
+ * @file ESP32_GIF_Stream.cpp
+ * @brief Compact span stream encoder and decoder
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include "ESP32_GIF_Stream.h"
+
+// ---------------------------------------------------------------------------
+// Encoder
+// ---------------------------------------------------------------------------
+
+ESP32_GIF_StreamEncoder::ESP32_GIF_StreamEncoder()
+    : _writer(nullptr)
+    , _writerData(nullptr)
+    , _encoding(StreamEncoding::RLE_RGB565)
+    , _rectEncoding(StreamEncoding::RLE_RGB565)
+    , _paletteCount(0)
+    , _chunkLength(0) {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void ESP32_GIF_StreamEncoder::begin(StreamWriter writer, void* userData, StreamEncoding encoding) {
+    _writer = writer;
+    _writerData = userData;
+    _encoding = encoding;
+    _paletteCount = 0;
+    _chunkLength = 0;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void ESP32_GIF_StreamEncoder::beginFrame(uint16_t frame, uint16_t canvasWidth, uint16_t canvasHeight) {
+    if (!_writer) return;
+
+    _stats.frameBytes = 0;
+    _stats.frameRawBytes = 0;
+
+    putRecord(ESP32_GIF_STREAM_FRAME_BEGIN);
+    put16(frame);
+    put16(canvasWidth);
+    put16(canvasHeight);
+}
+
+void ESP32_GIF_StreamEncoder::writePalette(const uint16_t* palette, uint16_t count) {
+    if (!_writer || _encoding != StreamEncoding::RLE_INDEXED) return;
+
+    // Only resend on change; compared in full, a skipped update would
+    // leave the receiver drawing with the old colors
+    if (count > 256) count = 256;
+    if (count == _paletteCount && memcmp(palette, _palette, count * sizeof(uint16_t)) == 0) return;
+    _paletteCount = count;
+    memcpy(_palette, palette, count * sizeof(uint16_t));
+
+    putRecord(ESP32_GIF_STREAM_PALETTE);
+    put16(count);
+    for (uint16_t i = 0; i < count; i++) {
+        put16(palette[i]);
+    }
+}
+
+void ESP32_GIF_StreamEncoder::beginRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+    beginRect(x, y, width, height, _encoding);
+}
+
+void ESP32_GIF_StreamEncoder::beginRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+                                        StreamEncoding encoding) {
+    if (!_writer) return;
+
+    _rectEncoding = encoding;
+    putRecord(ESP32_GIF_STREAM_RECT);
+    put((uint8_t)encoding);
+    put16(x);
+    put16(y);
+    put16(width);
+    put16(height);
+
+    _stats.frameRawBytes += (uint32_t)width * height * 2;
+}
+
+void ESP32_GIF_StreamEncoder::writeRow(const uint8_t* indices, uint16_t count,
+                                       const uint16_t* palette, int16_t transparentIndex) {
+    encodeRow(indices, nullptr, count, palette, transparentIndex);
+}
+
+void ESP32_GIF_StreamEncoder::writeColors(const uint16_t* colors, uint16_t count) {
+    encodeRow(nullptr, colors, count, nullptr, -1);
+}
+
+void ESP32_GIF_StreamEncoder::encodeRow(const uint8_t* indices, const uint16_t* colors, uint16_t count,
+                                        const uint16_t* palette, int16_t transparentIndex) {
+    if (!_writer) return;
+
+    const bool indexed = !colors && (_rectEncoding == StreamEncoding::RLE_INDEXED);
+    // A repeat token pays off from 2 pixels for RGB565 and 3 for indices
+    const uint16_t minRepeat = indexed ? 3 : 2;
+
+    #define STREAM_TRANSPARENT(i) (transparentIndex >= 0 && indices[i] == (uint8_t)transparentIndex)
+    #define STREAM_VALUE(i) (colors ? colors[i] : indexed ? (uint16_t)indices[i] : palette[indices[i]])
+
+    uint16_t i = 0;
+    while (i < count) {
+        uint16_t run = 1;
+
+        if (STREAM_TRANSPARENT(i)) {
+            while (i + run < count && run < ESP32_GIF_STREAM_MAX_RUN && STREAM_TRANSPARENT(i + run)) {
+                run++;
+            }
+            put(ESP32_GIF_STREAM_RUN_SKIP | (run - 1));
+            i += run;
+            continue;
+        }
+
+        uint16_t value = STREAM_VALUE(i);
+        while (i + run < count && run < ESP32_GIF_STREAM_MAX_RUN &&
+               !STREAM_TRANSPARENT(i + run) && STREAM_VALUE(i + run) == value) {
+            run++;
+        }
+
+        if (run >= minRepeat) {
+            put(ESP32_GIF_STREAM_RUN_REPEAT | (run - 1));
+            putValue(value);
+            i += run;
+            continue;
+        }
+
+        // Gather literals until a repeat run or transparent pixel starts
+        uint16_t length = 0;
+        while (i + length < count && length < ESP32_GIF_STREAM_MAX_RUN && !STREAM_TRANSPARENT(i + length)) {
+            uint16_t j = i + length;
+            uint16_t same = 1;
+            while (same < minRepeat && j + same < count && !STREAM_TRANSPARENT(j + same) &&
+                   STREAM_VALUE(j + same) == STREAM_VALUE(j)) {
+                same++;
+            }
+            if (same >= minRepeat && length > 0) break;
+            length++;
+        }
+
+        put(ESP32_GIF_STREAM_RUN_LITERAL | (length - 1));
+        for (uint16_t j = 0; j < length; j++) {
+            putValue(STREAM_VALUE(i + j));
+        }
+        i += length;
+    }
+
+    #undef STREAM_TRANSPARENT
+    #undef STREAM_VALUE
+}
+
+void ESP32_GIF_StreamEncoder::endFrame() {
+    if (!_writer) return;
+
+    putRecord(ESP32_GIF_STREAM_FRAME_END);
+    flush();
+
+    _stats.totalBytes += _stats.frameBytes;
+    _stats.totalRawBytes += _stats.frameRawBytes;
+    _stats.frames++;
+}
+
+void ESP32_GIF_StreamEncoder::putRecord(uint8_t opcode) {
+    putByte(ESP32_GIF_STREAM_SYNC);
+    putByte(opcode);
+}
+
+void ESP32_GIF_StreamEncoder::putByte(uint8_t value) {
+    _chunk[_chunkLength++] = value;
+    _stats.frameBytes++;
+    if (_chunkLength == ESP32_GIF_STREAM_CHUNK_SIZE) {
+        flush();
+    }
+}
+
+void ESP32_GIF_StreamEncoder::put(uint8_t value) {
+    // Record data never contains a bare sync byte
+    putByte(value);
+    if (value == ESP32_GIF_STREAM_SYNC) {
+        putByte(ESP32_GIF_STREAM_ESCAPE);
+    }
+}
+
+void ESP32_GIF_StreamEncoder::put16(uint16_t value) {
+    put(value & 0xFF);
+    put(value >> 8);
+}
+
+void ESP32_GIF_StreamEncoder::putValue(uint16_t value) {
+    if (_rectEncoding == StreamEncoding::RLE_INDEXED) {
+        put((uint8_t)value);
+    } else {
+        put16(value);
+    }
+}
+
+void ESP32_GIF_StreamEncoder::flush() {
+    if (_chunkLength > 0) {
+        _writer(_writerData, _chunk, _chunkLength);
+        _chunkLength = 0;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Decoder
+// ---------------------------------------------------------------------------
+
+ESP32_GIF_StreamDecoder::ESP32_GIF_StreamDecoder()
+    : _pixelCallback(nullptr)
+    , _runCallback(nullptr)
+    , _callbackData(nullptr)
+    , _frames(0) {
+    memset(_palette, 0, sizeof(_palette));
+    reset();
+}
+
+void ESP32_GIF_StreamDecoder::setPixelCallback(StreamPixelCallback callback, void* userData) {
+    _pixelCallback = callback;
+    _callbackData = userData;
+}
+
+void ESP32_GIF_StreamDecoder::setRunCallback(StreamRunCallback callback) {
+    _runCallback = callback;
+}
+
+void ESP32_GIF_StreamDecoder::reset() {
+    _state = State::SYNC;
+    _escape = false;
+    _opcode = 0;
+    _headerLength = 0;
+    _headerPos = 0;
+    _valuePos = 0;
+    _frameIndex = 0;
+    _indexed = false;
+    _rectX = _rectY = _rectWidth = _rectHeight = 0;
+    _x = _row = 0;
+    _runLength = 0;
+    _paletteCount = 0;
+    _palettePos = 0;
+}
+
+void ESP32_GIF_StreamDecoder::feed(const uint8_t* data, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        uint8_t b = data[i];
+
+        // A sync byte starts a record, unless it is followed by the escape;
+        // a record cut short by lost bytes is dropped. Two sync bytes in a
+        // row only occur after a lost opcode, the second one counts
+        if (_escape) {
+            if (b == ESP32_GIF_STREAM_SYNC) continue;
+            _escape = false;
+            if (b != ESP32_GIF_STREAM_ESCAPE) {
+                handleOpcode(b);
+                continue;
+            }
+            b = ESP32_GIF_STREAM_SYNC;
+        } else if (b == ESP32_GIF_STREAM_SYNC) {
+            _escape = true;
+            continue;
+        }
+        handleByte(b);
+    }
+}
+
+void ESP32_GIF_StreamDecoder::handleOpcode(uint8_t opcode) {
+    _opcode = opcode;
+    _headerPos = 0;
+    switch (opcode) {
+        case ESP32_GIF_STREAM_FRAME_BEGIN: _headerLength = 6; _state = State::HEADER; break;
+        case ESP32_GIF_STREAM_PALETTE:     _headerLength = 2; _state = State::HEADER; break;
+        case ESP32_GIF_STREAM_RECT:        _headerLength = 9; _state = State::HEADER; break;
+        case ESP32_GIF_STREAM_FRAME_END:   _frames++; _state = State::SYNC; break;
+        default:                           _state = State::SYNC; break;
+    }
+}
+
+void ESP32_GIF_StreamDecoder::handleByte(uint8_t b) {
+    switch (_state) {
+        case State::SYNC:
+            // Data outside a record (after a corrupt record) is ignored
+            break;
+
+        case State::HEADER:
+            _header[_headerPos++] = b;
+            if (_headerPos == _headerLength) {
+                handleHeader();
+            }
+            break;
+
+        case State::PALETTE:
+            _valueBytes[_valuePos++] = b;
+            if (_valuePos == 2) {
+                _valuePos = 0;
+                if (_palettePos < 256) {
+                    _palette[_palettePos] = _valueBytes[0] | (_valueBytes[1] << 8);
+                }
+                if (++_palettePos == _paletteCount) {
+                    _state = State::SYNC;
+                }
+            }
+            break;
+
+        case State::TOKEN: {
+            uint8_t type = b & 0xC0;
+            _runLength = (b & 0x3F) + 1;
+            if (_x + _runLength > _rectWidth) {
+                _state = State::SYNC; // Corrupt stream, resynchronize
+            } else if (type == ESP32_GIF_STREAM_RUN_SKIP) {
+                advance(_runLength);
+            } else if (type == ESP32_GIF_STREAM_RUN_REPEAT) {
+                _state = State::REPEAT;
+            } else if (type == ESP32_GIF_STREAM_RUN_LITERAL) {
+                _state = State::LITERAL;
+            } else {
+                _state = State::SYNC;
+            }
+            _valuePos = 0;
+            break;
+        }
+
+        case State::LITERAL:
+        case State::REPEAT:
+            if (_indexed) {
+                handleValue(_palette[b]);
+            } else {
+                _valueBytes[_valuePos++] = b;
+                if (_valuePos == 2) {
+                    _valuePos = 0;
+                    handleValue(_valueBytes[0] | (_valueBytes[1] << 8));
+                }
+            }
+            break;
+    }
+}
+
+void ESP32_GIF_StreamDecoder::handleHeader() {
+    switch (_opcode) {
+        case ESP32_GIF_STREAM_FRAME_BEGIN:
+            _frameIndex = _header[0] | (_header[1] << 8);
+            _state = State::SYNC;
+            break;
+
+        case ESP32_GIF_STREAM_PALETTE:
+            _paletteCount = _header[0] | (_header[1] << 8);
+            _palettePos = 0;
+            _valuePos = 0;
+            _state = _paletteCount ? State::PALETTE : State::SYNC;
+            break;
+
+        case ESP32_GIF_STREAM_RECT:
+            _indexed = (_header[0] == (uint8_t)StreamEncoding::RLE_INDEXED);
+            _rectX = _header[1] | (_header[2] << 8);
+            _rectY = _header[3] | (_header[4] << 8);
+            _rectWidth = _header[5] | (_header[6] << 8);
+            _rectHeight = _header[7] | (_header[8] << 8);
+            _x = 0;
+            _row = 0;
+            _state = (_rectWidth && _rectHeight) ? State::TOKEN : State::SYNC;
+            break;
+
+        default:
+            _state = State::SYNC;
+            break;
+    }
+}
+
+void ESP32_GIF_StreamDecoder::handleValue(uint16_t value) {
+    if (_state == State::REPEAT) {
+        emitRun(value, _runLength);
+        advance(_runLength);
+        return;
+    }
+
+    if (_pixelCallback) {
+        _pixelCallback(_callbackData, _rectX + _x, _rectY + _row, value);
+    }
+    _state = State::TOKEN;
+    advance(1);
+    if (_state == State::TOKEN && --_runLength > 0) {
+        _state = State::LITERAL;
+    }
+}
+
+void ESP32_GIF_StreamDecoder::advance(uint16_t count) {
+    _state = State::TOKEN;
+    _x += count;
+    if (_x >= _rectWidth) {
+        _x = 0;
+        if (++_row >= _rectHeight) {
+            _state = State::SYNC;
+        }
+    }
+}
+
+void ESP32_GIF_StreamDecoder::emitRun(uint16_t color, uint16_t length) {
+    if (_runCallback) {
+        _runCallback(_callbackData, _rectX + _x, _rectY + _row, length, color);
+    } else if (_pixelCallback) {
+        for (uint16_t i = 0; i < length; i++) {
+            _pixelCallback(_callbackData, _rectX + _x + i, _rectY + _row, color);
+        }
+    }
+}
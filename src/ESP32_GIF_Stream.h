@@ -0,0 +1,267 @@
+/**
+ * @file ESP32_GIF_Stream.h
+ * @brief Compact span stream format for remote / low-bandwidth displays
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * The decoder can encode every rendered frame as a byte stream that is
+ * sent over UART, RS-485 or any other byte pipe. Only the changed region
+ * of each frame is transmitted, row by row, as run-length coded spans of
+ * either RGB565 colors or palette indices. ESP32_GIF_StreamDecoder is the
+ * matching receiver; it depends on nothing but this header and is small
+ * enough to run on the display-side MCU.
+ *
+ * Stream layout (all multi-byte values little endian):
+ *
+ *   0xA5 'F' u16 frame, u16 canvasWidth, u16 canvasHeight    frame begin
+ *   0xA5 'P' u16 count, count x u16 RGB565                   palette (indexed only)
+ *   0xA5 'R' u8 encoding, u16 x, u16 y, u16 w, u16 h, rows   dirty rect
+ *   0xA5 'E'                                                 frame end
+ *
+ * Each row of a rect is a sequence of run tokens covering exactly w
+ * pixels. A token byte holds the run type in its top two bits and
+ * (length - 1) in the low six bits:
+ *
+ *   00 literal  followed by length values
+ *   01 repeat   followed by one value, repeated length times
+ *   10 skip     no payload, pixels are left untouched (transparent)
+ *
+ * A value is a u16 RGB565 color or a u8 palette index depending on the
+ * rect encoding. Rows composed over a background are sent fully resolved
+ * as RGB565 rects without skips.
+ *
+ * 0xA5 only starts a record: a 0xA5 byte inside a record is sent as
+ * 0xA5 0x00. A receiver that lost bytes drops the broken record at the
+ * next record start and decodes on from there.
+ */
+
+#ifndef ESP32_GIF_STREAM_H
+#define ESP32_GIF_STREAM_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Stream protocol constants
+#define ESP32_GIF_STREAM_SYNC         0xA5
+#define ESP32_GIF_STREAM_ESCAPE       0x00    // After SYNC: a 0xA5 data byte
+#define ESP32_GIF_STREAM_FRAME_BEGIN  'F'
+#define ESP32_GIF_STREAM_PALETTE      'P'
+#define ESP32_GIF_STREAM_RECT         'R'
+#define ESP32_GIF_STREAM_FRAME_END    'E'
+
+#define ESP32_GIF_STREAM_RUN_LITERAL  0x00
+#define ESP32_GIF_STREAM_RUN_REPEAT   0x40
+#define ESP32_GIF_STREAM_RUN_SKIP     0x80
+#define ESP32_GIF_STREAM_MAX_RUN      64
+
+// Encoder output chunk size (bytes handed to the writer at once)
+#ifndef ESP32_GIF_STREAM_CHUNK_SIZE
+  #define ESP32_GIF_STREAM_CHUNK_SIZE 64
+#endif
+
+// Span value encoding
+enum class StreamEncoding {
+    RLE_RGB565 = 0,     // Runs of RGB565 colors (2 bytes per value)
+    RLE_INDEXED         // Runs of palette indices (1 byte per value) plus palette updates
+};
+
+// Stream statistics
+struct StreamStats {
+    uint32_t frameBytes;        // Encoded bytes of the last frame
+    uint32_t frameRawBytes;     // Raw RGB565 bytes of the same region
+    uint32_t totalBytes;        // Encoded bytes since the writer was set
+    uint32_t totalRawBytes;     // Raw RGB565 bytes since the writer was set
+    uint32_t frames;            // Frames encoded since the writer was set
+};
+
+// Callback function types
+typedef void (*StreamWriter)(void* userData, const uint8_t* data, uint32_t length);
+typedef void (*StreamPixelCallback)(void* userData, uint16_t x, uint16_t y, uint16_t color);
+typedef void (*StreamRunCallback)(void* userData, uint16_t x, uint16_t y, uint16_t length, uint16_t color);
+
+// Span stream encoder (used by the decoder on the sending side)
+class ESP32_GIF_StreamEncoder {
+public:
+    ESP32_GIF_StreamEncoder();
+
+    /**
+     * @brief Set output writer and value encoding, resets statistics
+     * @param writer Writer receiving encoded bytes (nullptr disables)
+     * @param userData User data for writer
+     * @param encoding Span value encoding
+     */
+    void begin(StreamWriter writer, void* userData, StreamEncoding encoding);
+
+    /**
+     * @brief Check if a writer is attached
+     * @return true if encoding is enabled
+     */
+    bool isEnabled() const { return _writer != nullptr; }
+
+    /**
+     * @brief Get configured value encoding
+     * @return StreamEncoding
+     */
+    StreamEncoding getEncoding() const { return _encoding; }
+
+    /**
+     * @brief Start a frame
+     */
+    void beginFrame(uint16_t frame, uint16_t canvasWidth, uint16_t canvasHeight);
+
+    /**
+     * @brief Send the palette used by following indexed rects
+     * @param palette RGB565 palette entries
+     * @param count Number of entries
+     * @note Skipped when identical to the last palette sent
+     */
+    void writePalette(const uint16_t* palette, uint16_t count);
+
+    /**
+     * @brief Start a dirty rect, followed by exactly height rows
+     */
+    void beginRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+
+    /**
+     * @brief Start a dirty rect with an explicit value encoding
+     */
+    void beginRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height, StreamEncoding encoding);
+
+    /**
+     * @brief Encode one row of palette indices
+     * @param indices Palette indices
+     * @param count Number of pixels (rect width)
+     * @param palette RGB565 palette used for RGB565 encoding
+     * @param transparentIndex Index encoded as skip, or -1 for none
+     */
+    void writeRow(const uint8_t* indices, uint16_t count, const uint16_t* palette, int16_t transparentIndex);
+
+    /**
+     * @brief Encode one fully resolved row of RGB565 colors
+     * @param colors RGB565 colors
+     * @param count Number of pixels (rect width)
+     * @note The rect must use StreamEncoding::RLE_RGB565
+     */
+    void writeColors(const uint16_t* colors, uint16_t count);
+
+    /**
+     * @brief Finish the frame and flush pending bytes
+     */
+    void endFrame();
+
+    /**
+     * @brief Get stream statistics
+     * @param stats Reference to StreamStats structure
+     */
+    void getStats(StreamStats& stats) const { stats = _stats; }
+
+private:
+    StreamWriter _writer;
+    void* _writerData;
+    StreamEncoding _encoding;
+    StreamEncoding _rectEncoding;
+    StreamStats _stats;
+    uint16_t _palette[256];         // Last palette sent
+    uint16_t _paletteCount;
+    uint16_t _chunkLength;
+    uint8_t _chunk[ESP32_GIF_STREAM_CHUNK_SIZE];
+
+    void encodeRow(const uint8_t* indices, const uint16_t* colors, uint16_t count,
+                   const uint16_t* palette, int16_t transparentIndex);
+    void putRecord(uint8_t opcode);
+    void putByte(uint8_t value);
+    void put(uint8_t value);
+    void put16(uint16_t value);
+    void putValue(uint16_t value);
+    void flush();
+};
+
+// Span stream decoder (runs on the receiving side)
+class ESP32_GIF_StreamDecoder {
+public:
+    ESP32_GIF_StreamDecoder();
+
+    /**
+     * @brief Set pixel callback used for literal spans
+     * @param callback Pixel callback (color is RGB565)
+     * @param userData User data for callbacks
+     */
+    void setPixelCallback(StreamPixelCallback callback, void* userData = nullptr);
+
+    /**
+     * @brief Set optional run callback used for repeated spans
+     * @param callback Horizontal line callback; falls back to pixels if not set
+     */
+    void setRunCallback(StreamRunCallback callback);
+
+    /**
+     * @brief Reset parser state
+     */
+    void reset();
+
+    /**
+     * @brief Feed received bytes, may be called with any chunk size
+     * @param data Received bytes
+     * @param length Number of bytes
+     */
+    void feed(const uint8_t* data, uint32_t length);
+
+    /**
+     * @brief Get number of completed frames
+     * @return Frame count
+     */
+    uint32_t getFrameCount() const { return _frames; }
+
+    /**
+     * @brief Get index of the last frame begun
+     * @return Frame index from the stream
+     */
+    uint16_t getCurrentFrame() const { return _frameIndex; }
+
+private:
+    enum class State : uint8_t {
+        SYNC,
+        HEADER,
+        PALETTE,
+        TOKEN,
+        LITERAL,
+        REPEAT
+    };
+
+    StreamPixelCallback _pixelCallback;
+    StreamRunCallback _runCallback;
+    void* _callbackData;
+
+    State _state;
+    bool _escape;                   // Received SYNC, opcode or escape follows
+    uint8_t _opcode;
+    uint8_t _header[9];
+    uint8_t _headerLength;
+    uint8_t _headerPos;
+    uint8_t _valueBytes[2];
+    uint8_t _valuePos;
+
+    uint16_t _frameIndex;
+    uint32_t _frames;
+    bool _indexed;
+    uint16_t _rectX;
+    uint16_t _rectY;
+    uint16_t _rectWidth;
+    uint16_t _rectHeight;
+    uint16_t _x;
+    uint16_t _row;
+    uint16_t _runLength;
+    uint16_t _paletteCount;
+    uint16_t _palettePos;
+    uint16_t _palette[256];
+
+    void handleOpcode(uint8_t opcode);
+    void handleByte(uint8_t b);
+    void handleHeader();
+    void handleValue(uint16_t value);
+    void advance(uint16_t count);
+    void emitRun(uint16_t color, uint16_t length);
+};
+
+#endif // ESP32_GIF_STREAM_H
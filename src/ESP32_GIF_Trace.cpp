@@ -0,0 +1,154 @@
+/**
+ * @file ESP32_GIF_Trace.cpp
+ * @brief Begin/end event tracer with Chrome trace-event export
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include "ESP32_GIF_Trace.h"
+#include "ESP32_AnimatedGIF_Platform.h"
+
+#ifdef ESP32_ANIMATEDGIF_TRACE
+
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+static_assert((ESP32_ANIMATEDGIF_TRACE_EVENTS & (ESP32_ANIMATEDGIF_TRACE_EVENTS - 1)) == 0,
+              "ESP32_ANIMATEDGIF_TRACE_EVENTS must be a power of two");
+
+namespace {
+
+    struct TraceEvent {
+        const char* name;
+        uint32_t ticks;
+        uint32_t micros;        // Unwraps gaps longer than half a tick wrap
+        char phase;
+        uint8_t core;
+        // Index + 1 of the event in the slot, 0 while it is written
+        std::atomic<uint32_t> sequence;
+    };
+
+    TraceEvent events[ESP32_ANIMATEDGIF_TRACE_EVENTS];
+    std::atomic<uint32_t> nextEvent(0);
+    std::atomic<bool> enabled(true);
+
+    void writeText(TraceWriter writer, void* userData, const char* text) {
+        writer(userData, text, strlen(text));
+    }
+}
+
+namespace ESP32_GIF_Trace {
+
+    void record(const char* name, char phase) {
+        if (!enabled.load(std::memory_order_relaxed)) return;
+
+        uint32_t index = nextEvent.fetch_add(1, std::memory_order_relaxed);
+        TraceEvent& event = events[index & (ESP32_ANIMATEDGIF_TRACE_EVENTS - 1)];
+        event.sequence.store(0, std::memory_order_relaxed);
+        event.name = name;
+        event.ticks = ESP32_GIF_Platform::ticks();
+        event.micros = ESP32_GIF_Platform::micros();
+        event.phase = phase;
+        event.core = ESP32_GIF_Platform::coreId();
+        event.sequence.store(index + 1, std::memory_order_release);
+    }
+
+    void setEnabled(bool enable) {
+        enabled.store(enable, std::memory_order_relaxed);
+    }
+
+    void clear() {
+        for (TraceEvent& event : events) {
+            event.sequence.store(0, std::memory_order_relaxed);
+        }
+        nextEvent.store(0, std::memory_order_relaxed);
+    }
+
+    uint32_t getEventCount() {
+        return nextEvent.load(std::memory_order_relaxed);
+    }
+
+    bool dump(TraceWriter writer, void* userData) {
+        if (!writer) return false;
+
+        uint32_t end = nextEvent.load(std::memory_order_acquire);
+        uint32_t begin = end > ESP32_ANIMATEDGIF_TRACE_EVENTS ? end - ESP32_ANIMATEDGIF_TRACE_EVENTS : 0;
+        uint32_t perMicrosecond = ESP32_GIF_Platform::ticksPerMicrosecond();
+        if (perMicrosecond == 0) perMicrosecond = 1;
+
+        char line[160];
+        writeText(writer, userData, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+        // Ticks wrap within seconds at CPU clock rates. Consecutive events
+        // are unwrapped by their signed tick difference while the micros
+        // gap is under half a tick wrap, else by the micros gap; events of
+        // another core may be slightly out of order
+        int64_t halfWrap = ((int64_t)1 << 31) / perMicrosecond;
+        bool first = true;
+        uint32_t lastTicks = 0;
+        uint32_t lastMicros = 0;
+        int64_t baseNanos = 0;
+        int64_t ticksSinceBase = 0;
+        for (uint32_t index = begin; index < end; index++) {
+            const TraceEvent& event = events[index & (ESP32_ANIMATEDGIF_TRACE_EVENTS - 1)];
+            if (event.sequence.load(std::memory_order_acquire) != index + 1) continue;
+            const char* name = event.name;
+            uint32_t ticks = event.ticks;
+            uint32_t micros = event.micros;
+            char phase = event.phase;
+            uint8_t core = event.core;
+            if (event.sequence.load(std::memory_order_acquire) != index + 1) continue;
+
+            if (!first) {
+                int32_t microsGap = (int32_t)(micros - lastMicros);
+                if (microsGap > -halfWrap && microsGap < halfWrap) {
+                    ticksSinceBase += (int32_t)(ticks - lastTicks);
+                } else {
+                    baseNanos += ticksSinceBase * 1000 / perMicrosecond + (int64_t)microsGap * 1000;
+                    ticksSinceBase = 0;
+                }
+            }
+            lastTicks = ticks;
+            lastMicros = micros;
+
+            int64_t nanos = baseNanos + ticksSinceBase * 1000 / perMicrosecond;
+            uint64_t magnitude = nanos < 0 ? -nanos : nanos;
+            snprintf(line, sizeof(line),
+                     "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%s%llu.%03u,\"pid\":1,\"tid\":%u%s}",
+                     first ? "" : ",", name ? name : "?", phase, nanos < 0 ? "-" : "",
+                     (unsigned long long)(magnitude / 1000), (unsigned)(magnitude % 1000),
+                     (unsigned)core, phase == 'i' ? ",\"s\":\"t\"" : "");
+            writeText(writer, userData, line);
+            first = false;
+        }
+
+        writeText(writer, userData, "\n]}\n");
+        return true;
+    }
+}
+
+#else
+
+namespace ESP32_GIF_Trace {
+
+    void record(const char*, char) {
+    }
+
+    void setEnabled(bool) {
+    }
+
+    void clear() {
+    }
+
+    uint32_t getEventCount() {
+        return 0;
+    }
+
+    bool dump(TraceWriter, void*) {
+        return false;
+    }
+}
+
+#endif // ESP32_ANIMATEDGIF_TRACE
@@ -0,0 +1,93 @@
+/**
+ * @file ESP32_GIF_Trace.h
+ * @brief Begin/end event tracer with Chrome trace-event export
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Records begin / end / instant events with a platform tick and microsecond
+ * timestamp and the core ID into a fixed-size ring buffer, so the time of a frame can be
+ * followed across tasks (decode, read-ahead, display DMA). The decoder
+ * traces its own stages; applications add theirs with the same macros:
+ *
+ *   ESP32_GIF_TRACE_BEGIN("dma");
+ *   ...
+ *   ESP32_GIF_TRACE_END("dma");
+ *
+ * Recording is lock-free: a slot is claimed with one atomic increment and
+ * the oldest events are overwritten once the ring is full. dump() writes
+ * the ring as Chrome trace-event JSON (chrome://tracing, Perfetto) through
+ * a writer callback, e.g. to Serial on a device or a file on a host.
+ *
+ * The tracer only exists when ESP32_ANIMATEDGIF_TRACE is defined. Without
+ * it the macros expand to nothing, no ring buffer is allocated and dump()
+ * returns false.
+ */
+
+#ifndef ESP32_GIF_TRACE_H
+#define ESP32_GIF_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Ring buffer size in events, a power of two (20 or 24 bytes per event)
+#ifndef ESP32_ANIMATEDGIF_TRACE_EVENTS
+  #define ESP32_ANIMATEDGIF_TRACE_EVENTS 1024
+#endif
+
+// Trace points, compiled out unless ESP32_ANIMATEDGIF_TRACE is defined.
+// Names must outlive the dump (string literals) and are not JSON escaped.
+#ifdef ESP32_ANIMATEDGIF_TRACE
+  #define ESP32_GIF_TRACE_BEGIN(name) ESP32_GIF_Trace::record(name, 'B')
+  #define ESP32_GIF_TRACE_END(name) ESP32_GIF_Trace::record(name, 'E')
+  #define ESP32_GIF_TRACE_INSTANT(name) ESP32_GIF_Trace::record(name, 'i')
+#else
+  #define ESP32_GIF_TRACE_BEGIN(name) do {} while (0)
+  #define ESP32_GIF_TRACE_END(name) do {} while (0)
+  #define ESP32_GIF_TRACE_INSTANT(name) do {} while (0)
+#endif
+
+// Receives the JSON text of a dump in chunks
+typedef void (*TraceWriter)(void* userData, const char* text, size_t length);
+
+namespace ESP32_GIF_Trace {
+
+    /**
+     * @brief Record one event (use the ESP32_GIF_TRACE_* macros instead)
+     * @param name Event name, must stay valid until the ring is dumped
+     * @param phase 'B' begin, 'E' end or 'i' instant
+     */
+    void record(const char* name, char phase);
+
+    /**
+     * @brief Pause or resume recording (recording is on by default)
+     * @param enable false to drop events, e.g. while dumping
+     */
+    void setEnabled(bool enable);
+
+    /**
+     * @brief Discard all recorded events
+     */
+    void clear();
+
+    /**
+     * @brief Number of events recorded since the last clear()
+     * @return Event count, including overwritten events
+     */
+    uint32_t getEventCount();
+
+    /**
+     * @brief Write the ring as Chrome trace-event JSON, oldest event first
+     * @param writer Callback receiving the JSON text
+     * @param userData User data passed to the writer
+     * @return true if the tracer is compiled in, false otherwise
+     *
+     * Timestamps are microseconds since the oldest event, with tick
+     * resolution; gaps up to half a micros() wrap (35 minutes) between
+     * consecutive events are exact. Pause recording while dumping; events
+     * overwritten during the dump are skipped.
+     */
+    bool dump(TraceWriter writer, void* userData);
+}
+
+#endif // ESP32_GIF_TRACE_H
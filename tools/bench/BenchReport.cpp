@@ -0,0 +1,317 @@
+/**
+ * @file BenchReport.cpp
+ * @brief Benchmark results, JSON baselines and regression comparison
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include "BenchReport.h"
+#include "GifFiles.h"
+#include "Json.h"
+
+#include <algorithm>
+#include <map>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+    // Scales a MAD to the standard deviation of normally distributed noise
+    const double kMadToSigma = 1.4826;
+    const double kNoiseSigmas = 3.0;
+    // Fewest shared cases from which the spread between two runs is estimated
+    const size_t kMinSpreadCases = 8;
+
+    double median(std::vector<double> values) {
+        if (values.empty()) return 0;
+        std::sort(values.begin(), values.end());
+        size_t n = values.size();
+        return (n & 1) ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+    }
+
+    std::string jsonEscape(const std::string& text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if ((unsigned char)c < 0x20) {
+                out += ' ';
+            } else {
+                out += c;
+            }
+        }
+        return out;
+    }
+
+    // One scaled MAD of the repeats of either run, percent of the baseline
+    double repeatSigmaPercent(const BenchRecord& base, const BenchRecord& now) {
+        if (base.medianNs <= 0) return 0;
+        return kMadToSigma * std::max(base.madNs, now.madNs) * 100.0 / base.medianNs;
+    }
+}
+
+void summarizeTimes(std::vector<double> times, BenchRecord& record) {
+    record.repeat = times.size();
+    record.medianNs = median(times);
+    record.minNs = times.empty() ? 0 : *std::min_element(times.begin(), times.end());
+    for (double& t : times) {
+        t = fabs(t - record.medianNs);
+    }
+    record.madNs = median(times);
+}
+
+void splitCaseName(BenchRecord& record) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (true) {
+        size_t slash = record.name.find('/', start);
+        parts.push_back(record.name.substr(start, slash == std::string::npos ? std::string::npos : slash - start));
+        if (slash == std::string::npos) break;
+        start = slash + 1;
+    }
+    record.file = parts[0];
+    record.stage = parts.size() > 1 ? parts[1] : "";
+    record.format = parts.size() > 2 ? parts[2] : "";
+    record.output = parts.size() > 3 ? parts[3] : "";
+}
+
+void printReport(const BenchReport& report) {
+    printf("%-56s %10s %9s %9s %9s %10s %7s\n", "case", "median us", "mad %", "ns/px", "MB/s", "frames/s", "allocs");
+    for (const BenchRecord& r : report.records) {
+        printf("%-56s %10.1f %9.2f %9.2f %9.1f %10.1f %7u\n", r.name.c_str(), r.medianNs / 1e3,
+               r.medianNs > 0 ? r.madNs * 100.0 / r.medianNs : 0, r.nsPerPixel(), r.megabytesPerSecond(),
+               r.framesPerSecond(), r.allocations);
+    }
+}
+
+bool writeReport(const BenchReport& report, const char* path) {
+    FILE* out = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "gifbench: cannot write %s\n", path);
+        return false;
+    }
+
+    fprintf(out, "{\n  \"tool\": \"gifbench\",\n  \"schema\": %d,\n  \"source\": \"%s\",\n  \"library\": \"%s\",\n"
+            "  \"compiler\": \"%s\",\n  \"results\": [\n", BENCH_REPORT_SCHEMA, jsonEscape(report.source).c_str(),
+            jsonEscape(report.library).c_str(), jsonEscape(report.compiler).c_str());
+    for (size_t i = 0; i < report.records.size(); i++) {
+        const BenchRecord& r = report.records[i];
+        fprintf(out, "    {\"name\": \"%s\", \"file\": \"%s\", \"stage\": \"%s\", \"format\": \"%s\", \"output\": \"%s\", "
+                "\"frames\": %u, \"pixels\": %llu, \"input_bytes\": %llu, \"repeat\": %u, \"median_ns\": %.0f, "
+                "\"mad_ns\": %.0f, \"min_ns\": %.0f, \"ns_per_pixel\": %.4f, \"mb_per_s\": %.3f, \"frames_per_s\": %.3f, "
+                "\"allocations\": %u, \"allocated_bytes\": %u}%s\n",
+                jsonEscape(r.name).c_str(), jsonEscape(r.file).c_str(), r.stage.c_str(), r.format.c_str(), r.output.c_str(),
+                r.frames, (unsigned long long)r.pixels, (unsigned long long)r.inputBytes, r.repeat, r.medianNs,
+                r.madNs, r.minNs, r.nsPerPixel(), r.megabytesPerSecond(), r.framesPerSecond(), r.allocations,
+                r.allocatedBytes, i + 1 < report.records.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+
+    if (out != stdout) fclose(out);
+    return true;
+}
+
+bool readReport(const char* path, BenchReport& report, std::string& error) {
+    std::vector<uint8_t> data;
+    if (!readFile(path, data)) {
+        error = std::string("cannot read ") + path;
+        return false;
+    }
+
+    JsonValue root;
+    if (!parseJson(std::string(data.begin(), data.end()), root, error)) {
+        error = std::string(path) + ": " + error;
+        return false;
+    }
+    int schema = (int)root.getNumber("schema");
+    const JsonValue* results = root.get("results");
+    if (root.getString("tool") != "gifbench" || schema < 1 || schema > BENCH_REPORT_SCHEMA ||
+        !results || results->type != JsonValue::ARRAY) {
+        error = std::string(path) + ": not a gifbench report of schema 1-" + std::to_string(BENCH_REPORT_SCHEMA);
+        return false;
+    }
+
+    report = BenchReport();
+    report.source = root.getString("source", "host");
+    report.library = root.getString("library");
+    report.compiler = root.getString("compiler");
+    for (const JsonValue& item : results->items) {
+        BenchRecord r;
+        r.name = item.getString("name");
+        if (r.name.empty()) continue;
+        r.file = item.getString("file");
+        r.stage = item.getString("stage");
+        r.format = item.getString("format");
+        r.output = item.getString("output");
+        r.frames = item.getNumber("frames");
+        r.pixels = item.getNumber("pixels");
+        r.inputBytes = item.getNumber("input_bytes", item.getNumber("compressed_bytes"));
+        r.repeat = item.getNumber("repeat", root.getNumber("repeat"));
+        r.medianNs = item.getNumber("median_ns");
+        r.madNs = item.getNumber("mad_ns");
+        r.minNs = item.getNumber("min_ns");
+        r.allocations = item.getNumber("allocations");
+        r.allocatedBytes = item.getNumber("allocated_bytes");
+        report.records.push_back(r);
+    }
+    return true;
+}
+
+bool importSerialLog(const char* path, BenchReport& report, std::string& error) {
+    std::vector<uint8_t> data;
+    if (!readFile(path, data)) {
+        error = std::string("cannot read ") + path;
+        return false;
+    }
+
+    // Lines may carry serial monitor prefixes (timestamps, "->")
+    report = BenchReport();
+    std::map<std::string, std::vector<double>> times;
+    std::map<std::string, BenchRecord> records;
+    std::vector<std::string> order;
+    std::string text(data.begin(), data.end());
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) end = text.size();
+        std::string line = text.substr(start, end - start);
+        start = end + 1;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        size_t info = line.find("GIFBENCH-INFO ");
+        if (info != std::string::npos) {
+            // GIFBENCH-INFO library=<version> compiler=<rest of line>
+            size_t library = line.find("library=", info);
+            size_t compiler = line.find("compiler=", info);
+            if (library != std::string::npos) {
+                size_t end = line.find(' ', library);
+                report.library = line.substr(library + 8, end == std::string::npos ? std::string::npos : end - library - 8);
+            }
+            if (compiler != std::string::npos) {
+                report.compiler = line.substr(compiler + 9);
+            }
+            continue;
+        }
+
+        size_t tag = line.find("GIFBENCH ");
+        if (tag == std::string::npos) continue;
+        char name[128];
+        unsigned frames;
+        unsigned long long pixels;
+        double micros;
+        if (sscanf(line.c_str() + tag + 9, "%127s %u %llu %lf", name, &frames, &pixels, &micros) != 4) continue;
+
+        if (!records.count(name)) {
+            BenchRecord r;
+            r.name = name;
+            r.frames = frames;
+            r.pixels = pixels;
+            splitCaseName(r);
+            records[name] = r;
+            order.push_back(name);
+        }
+        times[name].push_back(micros * 1e3);
+    }
+
+    if (order.empty()) {
+        error = std::string(path) + ": no GIFBENCH lines";
+        return false;
+    }
+    report.source = "device";
+    report.records.clear();
+    for (const std::string& name : order) {
+        BenchRecord r = records[name];
+        summarizeTimes(times[name], r);
+        report.records.push_back(r);
+    }
+    return true;
+}
+
+uint32_t compareReports(const BenchReport& baseline, const BenchReport& current, double thresholdPercent, FILE* out) {
+    std::map<std::string, const BenchRecord*> base;
+    for (const BenchRecord& r : baseline.records) {
+        base[r.name] = &r;
+    }
+
+    // The host drifts between runs far more than between the repeats of one
+    // run, and mostly by the same factor for every case. Cases are judged
+    // after removing the median ratio of the run; the spread of the ratios
+    // around it is the between-run noise, added to the repeat noise
+    std::vector<double> ratios;
+    for (const BenchRecord& now : current.records) {
+        auto it = base.find(now.name);
+        if (it == base.end()) continue;
+        if (it->second->medianNs > 0 && now.medianNs > 0) ratios.push_back(now.medianNs / it->second->medianNs);
+    }
+    double shift = 1;
+    double runSigma = 0;
+    if (ratios.size() >= kMinSpreadCases) {
+        shift = median(ratios);
+        std::vector<double> spread;
+        for (double ratio : ratios) {
+            spread.push_back(fabs(ratio / shift - 1) * 100.0);
+        }
+        runSigma = kMadToSigma * median(spread);
+    }
+
+    uint32_t regressions = 0;
+    uint32_t improvements = 0;
+    uint32_t unchanged = 0;
+    uint32_t added = 0;
+
+    fprintf(out, "%-56s %10s %10s %8s %8s %8s  %s\n", "case", "base us", "now us", "delta %", "vs run %", "noise %",
+            "verdict");
+    for (const BenchRecord& now : current.records) {
+        auto it = base.find(now.name);
+        if (it == base.end()) {
+            fprintf(out, "%-56s %10s %10.1f %8s %8s %8s  new\n", now.name.c_str(), "-", now.medianNs / 1e3, "-", "-", "-");
+            added++;
+            continue;
+        }
+        const BenchRecord& was = *it->second;
+        base.erase(it);
+
+        double delta = was.medianNs > 0 ? (now.medianNs - was.medianNs) * 100.0 / was.medianNs : 0;
+        double relative = was.medianNs > 0 ? (now.medianNs / (was.medianNs * shift) - 1) * 100.0 : 0;
+        double noise = kNoiseSigmas * hypot(repeatSigmaPercent(was, now), runSigma);
+        const char* verdict = "ok";
+        if (fabs(relative) > thresholdPercent) {
+            if (fabs(relative) <= noise) {
+                verdict = "within noise";
+                unchanged++;
+            } else if (relative > 0) {
+                verdict = "REGRESSION";
+                regressions++;
+            } else {
+                verdict = "faster";
+                improvements++;
+            }
+        } else {
+            unchanged++;
+        }
+        fprintf(out, "%-56s %10.1f %10.1f %+8.1f %+8.1f %8.1f  %s\n", now.name.c_str(), was.medianNs / 1e3,
+                now.medianNs / 1e3, delta, relative, noise, verdict);
+    }
+    for (const BenchRecord& r : baseline.records) {
+        if (base.count(r.name)) {
+            fprintf(out, "%-56s %10.1f %10s %8s %8s %8s  missing\n", r.name.c_str(), r.medianNs / 1e3, "-", "-", "-",
+                    "-");
+        }
+    }
+
+    fprintf(out, "%u regressions, %u faster, %u unchanged, %u new, %zu missing (threshold %.1f%%, baseline %s %s)\n",
+           regressions, improvements, unchanged, added, base.size(), thresholdPercent,
+           baseline.source.c_str(), baseline.library.c_str());
+    if (ratios.size() >= kMinSpreadCases) {
+        fprintf(out, "run: %+.1f%% for all cases alike (host drift or a change in every case, not judged), "
+                "%.1f%% between-run noise\n", (shift - 1) * 100.0, kNoiseSigmas * runSigma);
+    }
+    if (baseline.source != current.source) {
+        fprintf(out, "note: comparing a %s run against a %s baseline\n", current.source.c_str(), baseline.source.c_str());
+    }
+    return regressions;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file BenchReport.h
+ * @brief Benchmark results, JSON baselines and regression comparison
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * A report is the set of results of one benchmark run, either measured on
+ * the host by gifbench or imported from the serial log of a device run.
+ * Reports are saved as versioned JSON and a later run is compared against
+ * one as a baseline. The host speed drifts between runs, mostly by the same
+ * factor for every case, so each case is judged against the median ratio
+ * of all shared cases: it regresses when it grows by more than the
+ * threshold beyond that ratio and by more than 3 sigmas of the noise. The
+ * noise adds the repeats' own (scaled median absolute deviation) and the
+ * spread of the case ratios around the median ratio. A change that slows
+ * every case alike is printed but cannot be told from drift.
+ *
+ * Device runs print one line per timed repeat, anywhere in the log:
+ *
+ *   GIFBENCH <case> <frames> <pixels> <microseconds>
+ *
+ * Cases with several lines are aggregated like host repeats. An optional
+ * "GIFBENCH-INFO library=<version> compiler=<text>" line names the build.
+ */
+
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Current JSON schema; schema 1 files (no MAD, no metadata) are still read
+#define BENCH_REPORT_SCHEMA 2
+
+struct BenchRecord {
+    std::string name;           // file/stage[/format/output]
+    std::string file;
+    std::string stage;
+    std::string format;
+    std::string output;
+    uint32_t frames = 0;
+    uint64_t pixels = 0;
+    uint64_t inputBytes = 0;    // Bytes the MB/s figure refers to
+    uint32_t repeat = 0;
+    double medianNs = 0;
+    double madNs = 0;           // Median absolute deviation of the repeats
+    double minNs = 0;
+    uint32_t allocations = 0;
+    uint32_t allocatedBytes = 0;
+
+    double nsPerPixel() const { return pixels ? medianNs / pixels : 0; }
+    double megabytesPerSecond() const { return medianNs > 0 ? inputBytes * 1e3 / medianNs : 0; }
+    double framesPerSecond() const { return medianNs > 0 ? frames * 1e9 / medianNs : 0; }
+};
+
+struct BenchReport {
+    std::string source;         // "host" or "device"
+    std::string library;        // Library version
+    std::string compiler;
+    std::vector<BenchRecord> records;
+};
+
+/**
+ * @brief Fill the median, MAD and minimum of a record from repeat times
+ */
+void summarizeTimes(std::vector<double> times, BenchRecord& record);
+
+/**
+ * @brief Split a case name into file, stage, format and output
+ */
+void splitCaseName(BenchRecord& record);
+
+/**
+ * @brief Print the results as a table
+ */
+void printReport(const BenchReport& report);
+
+/**
+ * @brief Write a report as JSON
+ * @param path File path, "-" for stdout
+ * @return false (after printing an error) if the file cannot be written
+ */
+bool writeReport(const BenchReport& report, const char* path);
+
+/**
+ * @brief Read a JSON report written by writeReport()
+ * @return false with a message in error on failure
+ */
+bool readReport(const char* path, BenchReport& report, std::string& error);
+
+/**
+ * @brief Read the GIFBENCH lines of a device serial log
+ * @return false with a message in error if the log has no results
+ */
+bool importSerialLog(const char* path, BenchReport& report, std::string& error);
+
+/**
+ * @brief Print per-case deltas of a run against a baseline
+ * @param thresholdPercent Smallest slowdown reported as a regression
+ * @param out Destination of the comparison table
+ * @return Number of regressions
+ */
+uint32_t compareReports(const BenchReport& baseline, const BenchReport& current, double thresholdPercent, FILE* out);
+
+#endif // BENCH_REPORT_H
@@ -0,0 +1,726 @@
+/**
+ * @file gifbench.cpp
+ * @brief Host benchmark of the decoder pipeline stages
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Runs every file of a corpus through each pipeline stage in isolation:
+ *
+ *   parse    loadFromMemory(): header, frame scan and buffer setup
+ *   decode   LZW image data to palette indices only
+ *   compose  nextFrame() into an INDEXED8 canvas, no output
+ *   convert  nextFrame() into every other pixel format, no output
+ *   output   nextFrame() with each output path, for every pixel format
+ *
+ * and reports ns/pixel, MB/s of compressed input, frames/s and library
+ * allocations per run (0 unless built with ESP32_ANIMATEDGIF_STATS).
+ * Without file arguments a generated corpus set (see GifCorpus.h) is used,
+ * so runs are reproducible on any machine.
+ *
+ * Results can be saved as a JSON report and later runs compared against it
+ * as a baseline (see BenchReport.h); --import compares device runs the same
+ * way from their serial log instead of running on the host.
+ *
+ * --stats prints the decoder's own stage breakdown (GIFStats) for one
+ * RGB565 + FrameCallback pass per file; the library has to be built with
+ * ESP32_ANIMATEDGIF_STATS (cmake -DESP32_ANIMATEDGIF_STATS=ON). --trace
+ * writes the same pass as a Chrome trace (ESP32_ANIMATEDGIF_TRACE builds).
+ * --io runs it through a DataReader and ESP32_GIF_IOProfiler and prints the
+ * request pattern the decoder puts on storage.
+ *
+ * --calibrate fits the GIFCalibration used by ESP32_AnimatedGIF::estimate()
+ * to the rendered cases of a run (or of an --import'ed device log) and
+ * writes it as a C header. Filter the run to one pixel format and output,
+ * e.g. --filter RGB565_LE/frame, so the costs describe one configuration.
+ *
+ *   gifbench [--repeat N] [--filter TEXT] [--corpus SET] [--json PATH|-] [--list]
+ *            [--baseline PATH] [--threshold PCT] [--import LOG] [--stats] [--trace PATH]
+ *            [--io] [--calibrate PATH] [file.gif|dir ...]
+ */
+
+#include "ESP32_AnimatedGIF.h"
+#include "ESP32_GIF_IOProfiler.h"
+#include "ESP32_GIF_LZW.h"
+#include "BenchReport.h"
+#include "GifFiles.h"
+#include "GifScan.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct CorpusFile : GifFile {
+        GifScan scan;
+        uint64_t framePixels;       // Clipped frame area over all frames
+        uint64_t compressedBytes;   // LZW bytes over all frames
+    };
+
+    enum class Output {
+        NONE = 0,
+        FRAME,
+        PIXEL,
+        STREAM_RGB565,
+        STREAM_INDEXED
+    };
+
+    struct Case {
+        std::string name;
+        const CorpusFile* file;
+        std::string stage;
+        PixelFormat format;
+        Output output;
+    };
+
+    struct Sink {
+        uint64_t checksum;
+    };
+
+    volatile uint64_t sinkChecksum = 0;
+
+    const char* outputName(Output output) {
+        switch (output) {
+            case Output::NONE: return "none";
+            case Output::FRAME: return "frame";
+            case Output::PIXEL: return "pixel";
+            case Output::STREAM_RGB565: return "stream_rgb565";
+            case Output::STREAM_INDEXED: return "stream_indexed";
+        }
+        return "?";
+    }
+
+    // -----------------------------------------------------------------------
+    // Corpus
+    // -----------------------------------------------------------------------
+
+    void measureFile(CorpusFile& file) {
+        scanGif(file.data.data(), file.data.size(), file.scan);
+        file.framePixels = 0;
+        file.compressedBytes = 0;
+        for (const GifScanFrame& frame : file.scan.frames) {
+            if (frame.x < file.scan.width && frame.y < file.scan.height) {
+                uint32_t width = std::min<uint32_t>(frame.width, file.scan.width - frame.x);
+                uint32_t height = std::min<uint32_t>(frame.height, file.scan.height - frame.y);
+                file.framePixels += (uint64_t)width * height;
+            }
+            file.compressedBytes += frame.dataBytes;
+        }
+    }
+
+    // -----------------------------------------------------------------------
+    // Stages
+    // -----------------------------------------------------------------------
+
+    void frameSink(void* userData, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* pixels) {
+        ((Sink*)userData)->checksum += x + y + width + height + pixels[0];
+    }
+
+    void pixelSink(void* userData, uint16_t x, uint16_t y, uint16_t color) {
+        ((Sink*)userData)->checksum += x + y + color;
+    }
+
+    void streamSink(void* userData, const uint8_t* data, uint32_t length) {
+        ((Sink*)userData)->checksum += length + data[0];
+    }
+
+    const std::vector<uint8_t>* lzwSource = nullptr;
+
+    bool readSource(void*, uint8_t* buffer, uint32_t length, uint32_t position) {
+        if (position + length > lzwSource->size()) return false;
+        memcpy(buffer, lzwSource->data() + position, length);
+        return true;
+    }
+
+    uint32_t runDecode(const CorpusFile& file, Sink& sink) {
+        ESP32_GIF_LZW lzw;
+        static std::vector<uint8_t> pixels;
+        lzwSource = &file.data;
+
+        for (const GifScanFrame& frame : file.scan.frames) {
+            size_t count = (size_t)frame.width * frame.height;
+            if (pixels.size() < count) pixels.resize(count);
+            if (!lzw.begin(frame.minCodeSize, readSource, nullptr, frame.dataOffset)) continue;
+            sink.checksum += lzw.read(pixels.data(), count);
+            uint32_t position;
+            lzw.finish(position);
+        }
+        return file.scan.frames.size();
+    }
+
+    uint32_t runRender(ESP32_AnimatedGIF& gif) {
+        uint32_t frames = 0;
+        while (gif.nextFrame(false) == GIFError::SUCCESS) {
+            frames++;
+        }
+        return frames;
+    }
+
+    bool prepareRender(ESP32_AnimatedGIF& gif, const Case& benchCase, Sink& sink) {
+        gif.begin(benchCase.format, false);
+        gif.setLoop(false);
+        switch (benchCase.output) {
+            case Output::NONE:
+                break;
+            case Output::FRAME:
+                gif.setFrameCallback(frameSink, &sink);
+                break;
+            case Output::PIXEL:
+                gif.setPixelCallback(pixelSink, &sink);
+                break;
+            case Output::STREAM_RGB565:
+                gif.setStreamWriter(streamSink, &sink, StreamEncoding::RLE_RGB565);
+                break;
+            case Output::STREAM_INDEXED:
+                gif.setStreamWriter(streamSink, &sink, StreamEncoding::RLE_INDEXED);
+                break;
+        }
+        return gif.loadFromMemory(benchCase.file->data.data(), benchCase.file->data.size()) == GIFError::SUCCESS;
+    }
+
+    double elapsedNs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void countAllocations(uint32_t& allocations, uint32_t& bytes) {
+        // Library allocation counters only exist in statistics builds
+        allocations = bytes = 0;
+#ifdef ESP32_ANIMATEDGIF_STATS
+        uint32_t frees;
+        ESP32_GIF_Utils::getAllocationStats(allocations, frees, bytes);
+#endif
+    }
+
+    void startRecord(const Case& benchCase, BenchRecord& result) {
+        const CorpusFile& file = *benchCase.file;
+        result.name = benchCase.name;
+        result.file = file.name;
+        result.stage = benchCase.stage;
+        result.output = outputName(benchCase.output);
+        bool rendered = benchCase.stage != "parse" && benchCase.stage != "decode";
+        result.format = rendered ? pixelFormatName(benchCase.format) : "";
+        result.frames = 0;
+        result.pixels = file.framePixels;
+        result.inputBytes = (benchCase.stage == "parse") ? file.data.size() : file.compressedBytes;
+        result.allocations = 0;
+        result.allocatedBytes = 0;
+    }
+
+    bool runCase(const Case& benchCase, bool first, BenchRecord& result, double& ns) {
+        const CorpusFile& file = *benchCase.file;
+        Sink sink = { 0 };
+        uint32_t allocationsBefore, bytesBefore;
+        uint32_t allocationsAfter, bytesAfter;
+
+        if (benchCase.stage == "parse") {
+            countAllocations(allocationsBefore, bytesBefore);
+            auto start = std::chrono::steady_clock::now();
+            {
+                ESP32_AnimatedGIF gif;
+                gif.begin(PixelFormat::RGB565_LE, false);
+                if (gif.loadFromMemory(file.data.data(), file.data.size()) != GIFError::SUCCESS) return false;
+                result.frames = gif.getFrameCount();
+            }
+            ns = elapsedNs(start);
+            countAllocations(allocationsAfter, bytesAfter);
+            result.pixels = 0;
+        } else if (benchCase.stage == "decode") {
+            countAllocations(allocationsBefore, bytesBefore);
+            auto start = std::chrono::steady_clock::now();
+            result.frames = runDecode(file, sink);
+            ns = elapsedNs(start);
+            countAllocations(allocationsAfter, bytesAfter);
+            // Full frame rects are decoded, clipped or not
+            result.pixels = 0;
+            for (const GifScanFrame& frame : file.scan.frames) {
+                result.pixels += (uint64_t)frame.width * frame.height;
+            }
+        } else {
+            // Loading is not part of the timed region
+            ESP32_AnimatedGIF gif;
+            if (!prepareRender(gif, benchCase, sink)) return false;
+            countAllocations(allocationsBefore, bytesBefore);
+            auto start = std::chrono::steady_clock::now();
+            result.frames = runRender(gif);
+            ns = elapsedNs(start);
+            countAllocations(allocationsAfter, bytesAfter);
+        }
+
+        if (first) {
+            result.allocations = allocationsAfter - allocationsBefore;
+            result.allocatedBytes = bytesAfter - bytesBefore;
+        }
+        sinkChecksum = sink.checksum; // Keeps the sink work observable
+        return true;
+    }
+
+    void buildCases(const std::vector<CorpusFile>& corpus, std::vector<Case>& cases) {
+        for (const CorpusFile& file : corpus) {
+            Case parse = { file.name + "/parse", &file, "parse", PixelFormat::RGB565_LE, Output::NONE };
+            Case decode = { file.name + "/decode", &file, "decode", PixelFormat::INDEXED8, Output::NONE };
+            cases.push_back(parse);
+            cases.push_back(decode);
+
+            for (PixelFormat format : kPixelFormats) {
+                for (int o = (int)Output::NONE; o <= (int)Output::STREAM_INDEXED; o++) {
+                    Output output = (Output)o;
+                    Case render;
+                    render.file = &file;
+                    render.format = format;
+                    render.output = output;
+                    if (output != Output::NONE) {
+                        render.stage = "output";
+                    } else {
+                        render.stage = (format == PixelFormat::INDEXED8) ? "compose" : "convert";
+                    }
+                    render.name = file.name + "/" + render.stage + "/" + pixelFormatName(format) + "/" + outputName(output);
+                    cases.push_back(render);
+                }
+            }
+        }
+    }
+
+    bool printDecoderStats(const std::vector<CorpusFile>& corpus, const char* filter) {
+        bool header = false;
+        for (const CorpusFile& file : corpus) {
+            if (filter && file.name.find(filter) == std::string::npos) continue;
+
+            Sink sink = { 0 };
+            Case statsCase = { file.name, &file, "output", PixelFormat::RGB565_LE, Output::FRAME };
+            ESP32_AnimatedGIF gif;
+            if (!prepareRender(gif, statsCase, sink)) continue;
+            runRender(gif);
+
+            GIFStats stats;
+            if (!gif.getStats(stats)) {
+                fprintf(stderr, "gifbench: --stats needs the library built with ESP32_ANIMATEDGIF_STATS\n");
+                return false;
+            }
+            if (!header) {
+                printf("%-28s %6s %10s %10s %10s %10s %10s %8s %8s %8s %7s\n", "file", "frames", "parse_us",
+                       "decode_us", "compose_us", "convert_us", "output_us", "io_us", "reads", "spans", "lut_hit");
+                header = true;
+            }
+            uint64_t palettes = stats.paletteCacheHits + stats.paletteCacheMisses;
+            printf("%-28s %6u %10llu %10llu %10llu %10llu %10llu %8llu %8llu %8llu %6.0f%%\n", file.name.c_str(),
+                   (unsigned)stats.frames, (unsigned long long)stats.parseMicros,
+                   (unsigned long long)stats.decodeMicros, (unsigned long long)stats.composeMicros,
+                   (unsigned long long)stats.convertMicros, (unsigned long long)stats.outputMicros,
+                   (unsigned long long)stats.ioMicros, (unsigned long long)stats.readerCalls, (unsigned long long)stats.spans,
+                   palettes ? 100.0 * stats.paletteCacheHits / palettes : 0.0);
+        }
+        return true;
+    }
+
+    bool readFile(void* userData, uint8_t* buffer, uint32_t length, uint32_t position) {
+        const std::vector<uint8_t>* data = (const std::vector<uint8_t>*)userData;
+        if ((uint64_t)position + length > data->size()) return false;
+        memcpy(buffer, data->data() + position, length);
+        return true;
+    }
+
+    void printIOProfile(const std::vector<CorpusFile>& corpus, const char* filter) {
+        printf("%-28s %6s %8s %10s %6s %6s %10s %10s %9s  %s\n", "file", "frames", "calls", "bytes",
+               "seeks", "back", "load_calls", "max_calls", "stall_us", "request sizes (calls)");
+        for (const CorpusFile& file : corpus) {
+            if (filter && file.name.find(filter) == std::string::npos) continue;
+
+            ESP32_GIF_IOProfiler io;
+            io.begin(readFile, (void*)&file.data);
+            Sink sink = { 0 };
+            ESP32_AnimatedGIF gif;
+            gif.begin(PixelFormat::RGB565_LE, false);
+            gif.setLoop(false);
+            gif.setFrameCallback(frameSink, &sink);
+            if (gif.load(ESP32_GIF_IOProfiler::read, &io) != GIFError::SUCCESS) continue;
+
+            IOStats frameStats;
+            io.endFrame();
+            io.getFrameStats(frameStats);
+            uint32_t loadCalls = frameStats.calls;
+            uint32_t maxCalls = 0;
+            uint32_t frames = 0;
+            while (gif.nextFrame(false) == GIFError::SUCCESS) {
+                io.endFrame();
+                io.getFrameStats(frameStats);
+                maxCalls = std::max(maxCalls, frameStats.calls);
+                frames++;
+            }
+
+            IOStats stats;
+            io.getFileStats(stats);
+            std::string sizes;
+            for (uint8_t bucket = 0; bucket < ESP32_GIF_IO_SIZE_BUCKETS; bucket++) {
+                if (!stats.sizeHistogram[bucket]) continue;
+                char entry[32];
+                snprintf(entry, sizeof(entry), "%s%u+:%u", sizes.empty() ? "" : " ",
+                         (unsigned)ESP32_GIF_IOProfiler::bucketSize(bucket), (unsigned)stats.sizeHistogram[bucket]);
+                sizes += entry;
+            }
+            printf("%-28s %6u %8u %10llu %6u %6u %10u %10u %9llu  %s\n", file.name.c_str(), (unsigned)frames,
+                   (unsigned)stats.calls, (unsigned long long)stats.bytes, (unsigned)stats.seeks,
+                   (unsigned)stats.backwardSeeks, (unsigned)loadCalls, (unsigned)maxCalls,
+                   (unsigned long long)stats.stallMicros, sizes.c_str());
+        }
+    }
+
+    void traceSink(void* userData, const char* text, size_t length) {
+        fwrite(text, 1, length, (FILE*)userData);
+    }
+
+    bool writeTrace(const std::vector<CorpusFile>& corpus, const char* filter, const char* path) {
+        ESP32_GIF_Trace::clear();
+        for (const CorpusFile& file : corpus) {
+            if (filter && file.name.find(filter) == std::string::npos) continue;
+
+            Sink sink = { 0 };
+            Case traceCase = { file.name, &file, "output", PixelFormat::RGB565_LE, Output::FRAME };
+            ESP32_AnimatedGIF gif;
+            ESP32_GIF_TRACE_BEGIN(file.name.c_str());
+            if (prepareRender(gif, traceCase, sink)) {
+                runRender(gif);
+            }
+            ESP32_GIF_TRACE_END(file.name.c_str());
+        }
+        ESP32_GIF_Trace::setEnabled(false);
+
+        FILE* out = fopen(path, "w");
+        if (!out) {
+            fprintf(stderr, "gifbench: cannot write %s\n", path);
+            return false;
+        }
+        bool traced = ESP32_GIF_Trace::dump(traceSink, out);
+        fclose(out);
+        if (!traced) {
+            fprintf(stderr, "gifbench: --trace needs the library built with ESP32_ANIMATEDGIF_TRACE\n");
+            return false;
+        }
+        fprintf(stderr, "gifbench: %u trace events, last %u written to %s\n",
+                (unsigned)ESP32_GIF_Trace::getEventCount(),
+                (unsigned)std::min<uint32_t>(ESP32_GIF_Trace::getEventCount(), ESP32_ANIMATEDGIF_TRACE_EVENTS), path);
+        return true;
+    }
+
+    // -----------------------------------------------------------------------
+    // Calibration
+    // -----------------------------------------------------------------------
+
+    bool solveCosts(const std::vector<const BenchRecord*>& records, const bool* active, double* costs) {
+        // Least squares of time = frames * c0 + pixels * c1 + bytes * c2,
+        // each record weighted by 1 / time so every file counts the same
+        double matrix[3][4] = {};
+        for (const BenchRecord* record : records) {
+            double terms[3] = { (double)record->frames, (double)record->pixels, (double)record->inputBytes };
+            double weight = 1.0 / (record->medianNs * record->medianNs);
+            for (int row = 0; row < 3; row++) {
+                for (int col = 0; col < 3; col++) {
+                    matrix[row][col] += terms[row] * terms[col] * weight;
+                }
+                matrix[row][3] += terms[row] * record->medianNs * weight;
+            }
+        }
+        double scale[3];
+        for (int i = 0; i < 3; i++) {
+            scale[i] = matrix[i][i];
+            if (!active[i]) {
+                // Inactive terms are pinned to 0
+                for (int col = 0; col < 4; col++) matrix[i][col] = 0;
+                for (int row = 0; row < 3; row++) matrix[row][i] = 0;
+                matrix[i][i] = 1;
+            }
+        }
+
+        for (int pivot = 0; pivot < 3; pivot++) {
+            int best = pivot;
+            for (int row = pivot + 1; row < 3; row++) {
+                if (fabs(matrix[row][pivot]) > fabs(matrix[best][pivot])) best = row;
+            }
+            // Terms proportional to another one (e.g. a single file) leave no pivot
+            if (!active[pivot]) continue;
+            if (fabs(matrix[best][pivot]) < 1e-9 * scale[pivot]) return false;
+            for (int col = 0; col < 4; col++) std::swap(matrix[pivot][col], matrix[best][col]);
+            for (int row = 0; row < 3; row++) {
+                if (row == pivot) continue;
+                double factor = matrix[row][pivot] / matrix[pivot][pivot];
+                for (int col = pivot; col < 4; col++) matrix[row][col] -= factor * matrix[pivot][col];
+            }
+        }
+        for (int i = 0; i < 3; i++) {
+            costs[i] = matrix[i][3] / matrix[i][i];
+        }
+        return true;
+    }
+
+    bool fitCalibration(const std::vector<const BenchRecord*>& records, GIFCalibration& calibration) {
+        // Terms no record measures (device logs carry no byte counts) are not fitted
+        bool active[3] = { false, false, false };
+        for (const BenchRecord* record : records) {
+            active[0] = active[0] || record->frames;
+            active[1] = active[1] || record->pixels;
+            active[2] = active[2] || record->inputBytes;
+        }
+        // Each retry fits fewer terms, so this ends
+        double costs[3] = {};
+        while (true) {
+            if (!solveCosts(records, active, costs)) {
+                // Too few distinct files for all terms: keep the per-pixel cost
+                if (!active[1] || (!active[0] && !active[2])) return false;
+                active[0] = active[2] = false;
+                continue;
+            }
+            // A negative cost is not physical; drop that term and fit again
+            int negative = -1;
+            for (int i = 0; i < 3; i++) {
+                if (active[i] && costs[i] < 0 && (negative < 0 || costs[i] < costs[negative])) negative = i;
+            }
+            if (negative < 0) break;
+            active[negative] = false;
+        }
+        calibration.usPerFrame = std::max(0.0, costs[0]) / 1000.0;
+        calibration.nsPerPixel = std::max(0.0, costs[1]);
+        calibration.nsPerByte = std::max(0.0, costs[2]);
+        return true;
+    }
+
+    bool writeCalibration(const BenchReport& report, const char* filter, const char* path) {
+        std::vector<const BenchRecord*> records;
+        std::string configuration;
+        bool mixed = false;
+        for (const BenchRecord& record : report.records) {
+            if (record.stage == "parse" || record.stage == "decode" || !record.frames || record.medianNs <= 0) continue;
+            std::string name = record.format + "/" + record.output;
+            if (records.empty()) {
+                configuration = name;
+            } else if (name != configuration) {
+                mixed = true;
+            }
+            records.push_back(&record);
+        }
+        if (records.empty()) {
+            fprintf(stderr, "gifbench: --calibrate found no rendered cases\n");
+            return false;
+        }
+        if (mixed) {
+            fprintf(stderr, "gifbench: warning: calibrating over several formats / outputs, use --filter\n");
+        }
+
+        GIFCalibration calibration;
+        if (!fitCalibration(records, calibration)) {
+            fprintf(stderr, "gifbench: --calibrate: the cases do not determine the costs\n");
+            return false;
+        }
+
+        double worst = 0;
+        double total = 0;
+        for (const BenchRecord* record : records) {
+            double predicted = record->frames * calibration.usPerFrame * 1000.0 +
+                               record->pixels * (double)calibration.nsPerPixel +
+                               record->inputBytes * (double)calibration.nsPerByte;
+            double error = fabs(predicted - record->medianNs) / record->medianNs;
+            worst = std::max(worst, error);
+            total += error;
+        }
+        const char* described = mixed ? "mixed configurations" : configuration.c_str();
+        printf("calibration %s: %.3f us/frame, %.3f ns/pixel, %.3f ns/byte (%u cases, error mean %.1f%% max %.1f%%)\n",
+               described, calibration.usPerFrame, calibration.nsPerPixel, calibration.nsPerByte,
+               (unsigned)records.size(), 100.0 * total / records.size(), 100.0 * worst);
+
+        FILE* out = fopen(path, "w");
+        if (!out) {
+            fprintf(stderr, "gifbench: cannot write %s\n", path);
+            return false;
+        }
+        fprintf(out,
+                "// Generated by gifbench --calibrate%s%s\n"
+                "// %s run, %s, library %s, %u cases, prediction error mean %.1f%% max %.1f%%\n"
+                "#pragma once\n"
+                "\n"
+                "#include \"ESP32_AnimatedGIF.h\"\n"
+                "\n"
+                "static const GIFCalibration kGIFCalibration = { %.3ff, %.3ff, %.3ff };\n",
+                filter ? " --filter " : "", filter ? filter : "", report.source.c_str(), described,
+                report.library.empty() ? "unknown" : report.library.c_str(), (unsigned)records.size(), 100.0 * total / records.size(), 100.0 * worst,
+                calibration.usPerFrame, calibration.nsPerPixel, calibration.nsPerByte);
+        fclose(out);
+        return true;
+    }
+
+    void usage() {
+        fprintf(stderr,
+                "usage: gifbench [--repeat N] [--filter TEXT] [--corpus SET] [--json PATH|-] [--list]\n"
+                "                [--baseline PATH] [--threshold PCT] [--import LOG] [--stats] [--trace PATH]\n"
+                "                [--io] [--calibrate PATH] [file.gif|dir ...]\n"
+                "  --repeat N       timed runs per case, the median is reported (default 9)\n"
+                "  --filter TEXT    only run cases whose name contains TEXT\n"
+                "  --corpus SET     generated corpus when no files are given: bench (default) or sweep\n"
+                "  --json PATH      write the results as a JSON report / baseline ('-' for stdout)\n"
+                "  --list           list the cases and exit\n"
+                "  --baseline PATH  compare against a saved report, exit 1 on regressions\n"
+                "  --threshold PCT  smallest slowdown reported as a regression (default 5)\n"
+                "  --import LOG     take the results from the GIFBENCH lines of a device serial log\n"
+                "  --stats          print the decoder stage statistics per file instead (needs\n"
+                "                   a library built with ESP32_ANIMATEDGIF_STATS)\n"
+                "  --trace PATH     write a Chrome trace of one decode pass per file instead\n"
+                "                   (needs a library built with ESP32_ANIMATEDGIF_TRACE)\n"
+                "  --io             print the reader request pattern per file instead\n"
+                "  --calibrate PATH fit the estimate() costs to the rendered cases and write\n"
+                "                   them as a C header (filter to one format and output)\n"
+                "Files and directories replace the generated corpus.\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    int repeat = 9;
+    const char* filter = nullptr;
+    const char* jsonPath = nullptr;
+    const char* baselinePath = nullptr;
+    const char* importPath = nullptr;
+    double threshold = 5.0;
+    std::string corpusName = "bench";
+    bool list = false;
+    bool stats = false;
+    const char* tracePath = nullptr;
+    bool io = false;
+    const char* calibrationPath = nullptr;
+    std::vector<GifFile> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--corpus") == 0 && i + 1 < argc) {
+            corpusName = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = std::max(0.0, atof(argv[++i]));
+        } else if (strcmp(argv[i], "--import") == 0 && i + 1 < argc) {
+            importPath = argv[++i];
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--io") == 0) {
+            io = true;
+        } else if (strcmp(argv[i], "--calibrate") == 0 && i + 1 < argc) {
+            calibrationPath = argv[++i];
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else if (!addGifPath(files, argv[i], "gifbench")) {
+            return 2;
+        }
+    }
+
+    // Load the baseline first so a bad path fails before a long run
+    BenchReport baseline;
+    std::string error;
+    if (baselinePath && !readReport(baselinePath, baseline, error)) {
+        fprintf(stderr, "gifbench: %s\n", error.c_str());
+        return 2;
+    }
+
+    BenchReport report;
+    if (importPath) {
+        if (!importSerialLog(importPath, report, error)) {
+            fprintf(stderr, "gifbench: %s\n", error.c_str());
+            return 2;
+        }
+        std::vector<BenchRecord> kept;
+        for (const BenchRecord& record : report.records) {
+            if (!filter || record.name.find(filter) != std::string::npos) {
+                kept.push_back(record);
+            }
+        }
+        report.records.swap(kept);
+    } else {
+        if (files.empty() && !addCorpusSet(files, corpusName, "gifbench")) {
+            return 2;
+        }
+        std::vector<CorpusFile> corpus(files.size());
+        for (size_t i = 0; i < files.size(); i++) {
+            corpus[i].name = files[i].name;
+            corpus[i].data.swap(files[i].data);
+            measureFile(corpus[i]);
+        }
+
+        if (stats) {
+            return printDecoderStats(corpus, filter) ? 0 : 2;
+        }
+        if (tracePath) {
+            return writeTrace(corpus, filter, tracePath) ? 0 : 2;
+        }
+        if (io) {
+            printIOProfile(corpus, filter);
+            return 0;
+        }
+
+        std::vector<Case> cases;
+        buildCases(corpus, cases);
+
+        report.source = "host";
+        report.library = ESP32_ANIMATEDGIF_VERSION;
+#ifdef __VERSION__
+        report.compiler = __VERSION__;
+#endif
+        std::vector<const Case*> selected;
+        for (const Case& benchCase : cases) {
+            if (filter && benchCase.name.find(filter) == std::string::npos) continue;
+            if (list) {
+                printf("%s\n", benchCase.name.c_str());
+                continue;
+            }
+            selected.push_back(&benchCase);
+        }
+        if (list) return 0;
+
+        // Repeats go round-robin over the cases, so a slow phase of the host
+        // lands in one repeat of many cases instead of all repeats of a few
+        report.records.resize(selected.size());
+        std::vector<std::vector<double>> times(selected.size());
+        for (size_t i = 0; i < selected.size(); i++) {
+            startRecord(*selected[i], report.records[i]);
+        }
+        for (int r = 0; r < repeat; r++) {
+            for (size_t i = 0; i < selected.size(); i++) {
+                double ns = 0;
+                if (!runCase(*selected[i], r == 0, report.records[i], ns)) {
+                    fprintf(stderr, "gifbench: %s failed to load\n", selected[i]->name.c_str());
+                    return 1;
+                }
+                times[i].push_back(ns);
+            }
+        }
+        for (size_t i = 0; i < selected.size(); i++) {
+            summarizeTimes(times[i], report.records[i]);
+        }
+    }
+
+    if (calibrationPath) {
+        return writeCalibration(report, filter, calibrationPath) ? 0 : 1;
+    }
+
+    // With the JSON report on stdout the comparison goes to stderr
+    bool jsonToStdout = jsonPath && strcmp(jsonPath, "-") == 0;
+    uint32_t regressions = 0;
+    if (baselinePath) {
+        regressions = compareReports(baseline, report, threshold, jsonToStdout ? stderr : stdout);
+    } else if (!jsonToStdout) {
+        printReport(report);
+    }
+    if (jsonPath && !writeReport(report, jsonPath)) {
+        return 1;
+    }
+    return regressions ? 1 : 0;
+}
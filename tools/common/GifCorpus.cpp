@@ -0,0 +1,313 @@
+/**
+ * @file GifCorpus.cpp
+ * @brief Deterministic synthetic GIF corpus for the host tools
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include "GifCorpus.h"
+#include "GifWriter.h"
+#include "ESP32_AnimatedGIF.h"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+namespace {
+
+    uint32_t nextRandom(uint32_t& state) {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    std::vector<uint8_t> makePalette(uint16_t colors, uint32_t seed) {
+        std::vector<uint8_t> palette(colors * 3);
+        for (uint16_t i = 0; i < colors; i++) {
+            palette[i * 3 + 0] = (uint8_t)(i * 255 / std::max(1, colors - 1));
+            palette[i * 3 + 1] = (uint8_t)((i * 97 + seed * 31) & 0xFF);
+            palette[i * 3 + 2] = (uint8_t)(255 - palette[i * 3]);
+        }
+        return palette;
+    }
+
+    uint8_t contentPixel(const CorpusSpec& spec, uint16_t opaque, int16_t transparent,
+                         uint32_t cx, uint32_t cy, uint32_t x, uint32_t y,
+                         uint32_t width, uint32_t height, uint16_t frame, uint32_t& rng) {
+        switch (spec.content) {
+            case CorpusContent::NOISE:
+                return nextRandom(rng) % opaque;
+
+            case CorpusContent::FLAT: {
+                bool glyph = ((cx / 6 + cy / 10 + frame) % 7) != 0 && (cx % 6) < 4 && (cy % 10) < 7;
+                if (!glyph || opaque < 2) return 0;
+                return 1 + (cx / 48 + cy / 40) % (opaque - 1);
+            }
+
+            case CorpusContent::SPRITE: {
+                int32_t dx = 2 * (int32_t)x - (int32_t)width + 1;
+                int32_t dy = 2 * (int32_t)y - (int32_t)height + 1;
+                int32_t r = std::min(width, height);
+                if (dx * dx + dy * dy >= r * r) {
+                    return transparent >= 0 ? transparent : 0;
+                }
+                return opaque < 2 ? 0 : 1 + (x + y + frame) % (opaque - 1);
+            }
+
+            case CorpusContent::GRADIENT:
+            default: {
+                uint32_t base = (cx * opaque / spec.width + cy * opaque / spec.height) / 2;
+                uint32_t noise = nextRandom(rng) % (opaque / 16 + 1);
+                return (base + noise + frame) % opaque;
+            }
+        }
+    }
+
+    CorpusSpec named(const char* name) {
+        CorpusSpec spec;
+        spec.name = name;
+        return spec;
+    }
+
+    CorpusSpec named(const char* format, int value) {
+        char name[64];
+        snprintf(name, sizeof(name), format, value);
+        return named(name);
+    }
+}
+
+std::vector<uint8_t> generateCorpusFile(const CorpusSpec& spec) {
+    uint32_t rng = spec.seed * 2654435761u + 1;
+    uint16_t colors = std::max<uint16_t>(2, std::min<uint16_t>(256, spec.colors));
+    uint16_t width = std::max<uint16_t>(1, spec.width);
+    uint16_t height = std::max<uint16_t>(1, spec.height);
+
+    bool hasTransparency = spec.transparency > 0 || spec.content == CorpusContent::SPRITE;
+    int16_t transparent = hasTransparency ? colors - 1 : -1;
+    uint16_t opaque = hasTransparency ? colors - 1 : colors;
+
+    GifWriter writer(width, height, spec.localPalettes ? std::vector<uint8_t>() : makePalette(colors, spec.seed));
+    GifEncodeOptions options;
+    options.minCodeSize = spec.minCodeSize;
+    options.deferredClear = spec.deferredClear;
+    options.subBlockSize = spec.subBlockSize;
+    writer.setEncodeOptions(options);
+
+    // Delta frames keep the canvas aspect ratio
+    double scale = sqrt(std::max(1, std::min(100, (int)spec.deltaArea)) / 100.0);
+    uint16_t deltaWidth = std::max<uint16_t>(1, (uint16_t)(width * scale + 0.5));
+    uint16_t deltaHeight = std::max<uint16_t>(1, (uint16_t)(height * scale + 0.5));
+
+    for (uint16_t f = 0; f < std::max<uint16_t>(1, spec.frames); f++) {
+        GifFrame frame;
+        if (f > 0 || spec.deltaFirst) {
+            frame.width = deltaWidth;
+            frame.height = deltaHeight;
+            frame.x = nextRandom(rng) % (width - deltaWidth + 1);
+            frame.y = nextRandom(rng) % (height - deltaHeight + 1);
+        } else {
+            frame.width = width;
+            frame.height = height;
+        }
+        frame.delay = spec.delay;
+        frame.disposal = spec.disposal & 0x07;
+        frame.transparentIndex = transparent;
+        frame.interlaced = spec.interlaced;
+        if (spec.localPalettes) {
+            frame.localPalette = makePalette(colors, spec.seed + f + 1);
+        }
+
+        frame.pixels.resize((size_t)frame.width * frame.height);
+        for (uint32_t y = 0; y < frame.height; y++) {
+            for (uint32_t x = 0; x < frame.width; x++) {
+                uint8_t index = contentPixel(spec, opaque, transparent, frame.x + x, frame.y + y,
+                                             x, y, frame.width, frame.height, f, rng);
+                if (f > 0 && spec.transparency > 0 && nextRandom(rng) % 100 < spec.transparency) {
+                    index = transparent;
+                }
+                frame.pixels[y * frame.width + x] = index;
+            }
+        }
+        writer.addFrame(frame);
+    }
+
+    return writer.finish();
+}
+
+bool corpusSet(const std::string& set, std::vector<CorpusSpec>& specs) {
+    specs.clear();
+
+    if (set == "bench") {
+        CorpusSpec photo;
+        photo.name = "photo_256";
+        photo.width = 320;
+        photo.height = 240;
+        photo.frames = 6;
+        photo.colors = 256;
+        specs.push_back(photo);
+
+        CorpusSpec ui;
+        ui.name = "ui_delta";
+        ui.width = 320;
+        ui.height = 240;
+        ui.frames = 12;
+        ui.colors = 32;
+        ui.content = CorpusContent::FLAT;
+        ui.deltaArea = 2;
+        ui.transparency = 33;
+        specs.push_back(ui);
+
+        CorpusSpec sprite;
+        sprite.name = "sprite_disposal";
+        sprite.width = 160;
+        sprite.height = 160;
+        sprite.frames = 12;
+        sprite.colors = 16;
+        sprite.content = CorpusContent::SPRITE;
+        sprite.deltaArea = 9;
+        sprite.disposal = 2;
+        specs.push_back(sprite);
+
+        CorpusSpec interlaced;
+        interlaced.name = "interlaced_local";
+        interlaced.width = 200;
+        interlaced.height = 150;
+        interlaced.frames = 4;
+        interlaced.localPalettes = true;
+        interlaced.interlaced = true;
+        specs.push_back(interlaced);
+
+        CorpusSpec mono;
+        mono.name = "mono_max";
+        mono.width = ESP32_ANIMATEDGIF_MAX_WIDTH;
+        mono.height = ESP32_ANIMATEDGIF_MAX_HEIGHT;
+        mono.frames = 3;
+        mono.colors = 2;
+        mono.content = CorpusContent::FLAT;
+        specs.push_back(mono);
+        return true;
+    }
+
+    if (set != "sweep") {
+        return false;
+    }
+
+    // One dimension at a time around the default spec
+    const uint16_t colors[] = { 2, 4, 16, 64, 128, 256 };
+    for (uint16_t count : colors) {
+        CorpusSpec spec = named("colors_%03d", count);
+        spec.colors = count;
+        specs.push_back(spec);
+    }
+
+    for (int bits = 2; bits <= 8; bits++) {
+        CorpusSpec spec = named("mincode_%d", bits);
+        spec.colors = 4;
+        spec.minCodeSize = bits;
+        specs.push_back(spec);
+    }
+
+    CorpusSpec local = named("palette_local");
+    local.localPalettes = true;
+    specs.push_back(local);
+
+    CorpusSpec interlaced = named("interlaced");
+    interlaced.interlaced = true;
+    specs.push_back(interlaced);
+
+    // Heights that end inside each interlace pass
+    const uint16_t interlaceHeights[] = { 1, 3, 5, 37 };
+    for (uint16_t height : interlaceHeights) {
+        CorpusSpec spec = named("interlaced_h%02d", height);
+        spec.interlaced = true;
+        spec.height = height;
+        specs.push_back(spec);
+    }
+
+    for (int disposal = 0; disposal <= 3; disposal++) {
+        CorpusSpec spec = named("disposal_%d", disposal);
+        spec.disposal = disposal;
+        spec.content = CorpusContent::SPRITE;
+        spec.deltaArea = 25;
+        specs.push_back(spec);
+    }
+
+    const uint8_t transparency[] = { 10, 50, 90 };
+    for (uint8_t percent : transparency) {
+        CorpusSpec spec = named("transparency_%03d", percent);
+        spec.transparency = percent;
+        specs.push_back(spec);
+    }
+
+    const uint8_t deltas[] = { 100, 25, 5, 1 };
+    for (uint8_t percent : deltas) {
+        CorpusSpec spec = named("delta_%03d", percent);
+        spec.deltaArea = percent;
+        specs.push_back(spec);
+    }
+
+    // Looping clears the canvas outside the first frame
+    CorpusSpec first = named("delta_first");
+    first.deltaArea = 25;
+    first.deltaFirst = true;
+    specs.push_back(first);
+
+    // Noise fills the LZW table quickly, with and without clear codes
+    CorpusSpec clear = named("table_clear");
+    clear.width = 320;
+    clear.height = 240;
+    clear.frames = 2;
+    clear.colors = 256;
+    clear.content = CorpusContent::NOISE;
+    specs.push_back(clear);
+
+    CorpusSpec deferred = clear;
+    deferred.name = "table_deferred_clear";
+    deferred.deferredClear = true;
+    specs.push_back(deferred);
+
+    const uint8_t blocks[] = { 1, 16, 254 };
+    for (uint8_t size : blocks) {
+        CorpusSpec spec = named("subblock_%03d", size);
+        spec.subBlockSize = size;
+        specs.push_back(spec);
+    }
+
+    CorpusSpec canvasMax = named("canvas_max");
+    canvasMax.width = ESP32_ANIMATEDGIF_MAX_WIDTH;
+    canvasMax.height = ESP32_ANIMATEDGIF_MAX_HEIGHT;
+    canvasMax.frames = 3;
+    specs.push_back(canvasMax);
+
+    CorpusSpec canvasTiny = named("canvas_1x1");
+    canvasTiny.width = 1;
+    canvasTiny.height = 1;
+    specs.push_back(canvasTiny);
+
+    CorpusSpec canvasOdd = named("canvas_333x77");
+    canvasOdd.width = 333;
+    canvasOdd.height = 77;
+    specs.push_back(canvasOdd);
+
+    const CorpusContent contents[] = { CorpusContent::NOISE, CorpusContent::FLAT, CorpusContent::SPRITE };
+    for (CorpusContent content : contents) {
+        CorpusSpec spec;
+        spec.name = std::string("content_") + corpusContentName(content);
+        spec.content = content;
+        specs.push_back(spec);
+    }
+
+    for (size_t i = 0; i < specs.size(); i++) {
+        specs[i].seed = i + 1;
+    }
+    return true;
+}
+
+const char* corpusContentName(CorpusContent content) {
+    switch (content) {
+        case CorpusContent::GRADIENT: return "gradient";
+        case CorpusContent::NOISE: return "noise";
+        case CorpusContent::FLAT: return "flat";
+        case CorpusContent::SPRITE: return "sprite";
+    }
+    return "?";
+}
@@ -0,0 +1,68 @@
+/**
+ * @file GifCorpus.h
+ * @brief Deterministic synthetic GIF corpus for the host tools
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Every file is described by a CorpusSpec covering one point of the
+ * feature space that matters for decoder performance and correctness, and
+ * generated from it with GifWriter. The same spec and seed always produce
+ * the same bytes, so benchmarks and checks need no third-party files.
+ */
+
+#ifndef GIF_CORPUS_H
+#define GIF_CORPUS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Pixel content of the generated frames
+enum class CorpusContent : uint8_t {
+    GRADIENT = 0,   // Smooth gradients with light noise (photo-like)
+    NOISE,          // Uniform random indices (worst case for LZW)
+    FLAT,           // Large flat areas and glyph-like blocks (UI, text)
+    SPRITE          // Filled disc on the transparent index
+};
+
+struct CorpusSpec {
+    std::string name;
+    uint16_t width = 160;
+    uint16_t height = 120;
+    uint16_t frames = 8;
+    uint16_t colors = 64;           // Palette size, 2-256
+    uint8_t minCodeSize = 0;        // 0 = smallest for the palette, else 2-8
+    bool localPalettes = false;     // Own palette per frame instead of a global one
+    bool interlaced = false;
+    uint8_t disposal = 1;           // 0-3, for every frame
+    uint8_t transparency = 0;       // Percent of transparent pixels after the first frame
+    uint8_t deltaArea = 100;        // Frame rect area after the first frame, percent of the canvas
+    bool deltaFirst = false;        // First frame a delta rect too, the rest of the canvas stays clear
+    bool deferredClear = false;     // No clear code when the LZW table is full
+    uint8_t subBlockSize = 255;     // Data sub-block size (1-255)
+    uint16_t delay = 10;            // Hundredths of a second
+    CorpusContent content = CorpusContent::GRADIENT;
+    uint32_t seed = 1;
+};
+
+/**
+ * @brief Generate the GIF file of a spec
+ */
+std::vector<uint8_t> generateCorpusFile(const CorpusSpec& spec);
+
+/**
+ * @brief Named sets of specs
+ * @param set "bench" (a few representative files) or "sweep" (one
+ *            dimension at a time around a base spec)
+ * @param specs Receives the specs
+ * @return false for an unknown set
+ */
+bool corpusSet(const std::string& set, std::vector<CorpusSpec>& specs);
+
+/**
+ * @brief Name of a content type
+ */
+const char* corpusContentName(CorpusContent content);
+
+#endif // GIF_CORPUS_H
@@ -0,0 +1,132 @@
+/**
+ * @file GifFiles.cpp
+ * @brief File and option handling shared by the host tools
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include "GifFiles.h"
+#include "GifCorpus.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+
+const PixelFormat kPixelFormats[11] = {
+    PixelFormat::RGB565_LE, PixelFormat::RGB565_BE, PixelFormat::RGB888, PixelFormat::ARGB8888,
+    PixelFormat::GRAYSCALE_8BIT, PixelFormat::MONOCHROME_1BIT, PixelFormat::INDEXED8,
+    PixelFormat::RGB332, PixelFormat::RGB444, PixelFormat::GRAY4, PixelFormat::GRAY2
+};
+
+bool readFile(const std::string& path, std::vector<uint8_t>& data) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    uint8_t buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + count);
+    }
+    fclose(file);
+    return true;
+}
+
+bool writeFile(const std::string& path, const std::vector<uint8_t>& data) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && ok;
+}
+
+std::string outputPath(const std::string& dir, const std::string& name, const char* extension) {
+    std::string path = dir + "/" + name;
+    if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".gif") == 0) path.resize(path.size() - 4);
+    return path + extension;
+}
+
+bool addGifPath(std::vector<GifFile>& files, const std::string& path, const char* tool) {
+    DIR* dir = opendir(path.c_str());
+    if (dir) {
+        std::vector<std::string> names;
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".gif") == 0) {
+                names.push_back(name);
+            }
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+        for (const std::string& name : names) {
+            if (!addGifPath(files, path + "/" + name, tool)) return false;
+        }
+        return true;
+    }
+
+    GifFile file;
+    if (!readFile(path, file.data)) {
+        fprintf(stderr, "%s: cannot read %s\n", tool, path.c_str());
+        return false;
+    }
+    size_t slash = path.find_last_of('/');
+    file.name = path.substr(slash == std::string::npos ? 0 : slash + 1);
+    files.push_back(file);
+    return true;
+}
+
+bool addCorpusSet(std::vector<GifFile>& files, const std::string& set, const char* tool) {
+    std::vector<CorpusSpec> specs;
+    if (!corpusSet(set, specs)) {
+        fprintf(stderr, "%s: unknown corpus set '%s'\n", tool, set.c_str());
+        return false;
+    }
+    for (const CorpusSpec& spec : specs) {
+        GifFile file;
+        file.name = spec.name;
+        file.data = generateCorpusFile(spec);
+        files.push_back(file);
+    }
+    return true;
+}
+
+const char* pixelFormatName(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::RGB565_LE: return "RGB565_LE";
+        case PixelFormat::RGB565_BE: return "RGB565_BE";
+        case PixelFormat::RGB888: return "RGB888";
+        case PixelFormat::ARGB8888: return "ARGB8888";
+        case PixelFormat::GRAYSCALE_8BIT: return "GRAYSCALE_8BIT";
+        case PixelFormat::MONOCHROME_1BIT: return "MONOCHROME_1BIT";
+        case PixelFormat::INDEXED8: return "INDEXED8";
+        case PixelFormat::RGB332: return "RGB332";
+        case PixelFormat::RGB444: return "RGB444";
+        case PixelFormat::GRAY4: return "GRAY4";
+        case PixelFormat::GRAY2: return "GRAY2";
+    }
+    return "?";
+}
+
+bool parsePixelFormat(const char* name, PixelFormat& format) {
+    for (PixelFormat candidate : kPixelFormats) {
+        if (strcmp(pixelFormatName(candidate), name) == 0) {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseDitherMode(const char* name, DitherMode& mode) {
+    if (strcmp(name, "none") == 0) {
+        mode = DitherMode::NONE;
+    } else if (strcmp(name, "ordered") == 0) {
+        mode = DitherMode::ORDERED;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseCalibration(const char* text, GIFCalibration& calibration) {
+    return sscanf(text, "%f,%f,%f", &calibration.usPerFrame, &calibration.nsPerPixel, &calibration.nsPerByte) == 3;
+}
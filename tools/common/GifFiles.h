@@ -0,0 +1,81 @@
+/**
+ * @file GifFiles.h
+ * @brief File and option handling shared by the host tools
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#ifndef GIF_FILES_H
+#define GIF_FILES_H
+
+#include "ESP32_AnimatedGIF.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct GifFile {
+    std::string name;           // File name without directories, or corpus spec name
+    std::vector<uint8_t> data;
+};
+
+/**
+ * @brief Read a whole file
+ * @return false if the file cannot be read
+ */
+bool readFile(const std::string& path, std::vector<uint8_t>& data);
+
+/**
+ * @brief Write a whole file
+ * @return false if the file cannot be written completely
+ */
+bool writeFile(const std::string& path, const std::vector<uint8_t>& data);
+
+/**
+ * @brief Output path for an input file: dir/name with a trailing ".gif"
+ *        replaced by extension
+ */
+std::string outputPath(const std::string& dir, const std::string& name, const char* extension);
+
+/**
+ * @brief Add a GIF file, or every *.gif of a directory in name order
+ * @param tool Tool name for error messages
+ * @return false (after printing an error) if a file cannot be read
+ */
+bool addGifPath(std::vector<GifFile>& files, const std::string& path, const char* tool);
+
+/**
+ * @brief Generate every file of a corpus set (see GifCorpus.h)
+ * @return false (after printing an error) for an unknown set
+ */
+bool addCorpusSet(std::vector<GifFile>& files, const std::string& set, const char* tool);
+
+/**
+ * @brief Every pixel format of the library
+ */
+extern const PixelFormat kPixelFormats[11];
+
+/**
+ * @brief Name of a pixel format as spelled in the API
+ */
+const char* pixelFormatName(PixelFormat format);
+
+/**
+ * @brief Pixel format from its name as spelled in the API
+ * @return false for an unknown name
+ */
+bool parsePixelFormat(const char* name, PixelFormat& format);
+
+/**
+ * @brief Dither mode from "none" or "ordered"
+ * @return false for another name
+ */
+bool parseDitherMode(const char* name, DitherMode& mode);
+
+/**
+ * @brief estimate() costs from "US,NS_PIXEL,NS_BYTE" (gifbench --calibrate)
+ * @return false unless all three numbers are given
+ */
+bool parseCalibration(const char* text, GIFCalibration& calibration);
+
+#endif // GIF_FILES_H
@@ -0,0 +1,98 @@
+/**
+ * @file GifScan.cpp
+ * @brief Block-level GIF structure scan for the host tools
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include "GifScan.h"
+#include <string.h>
+
+namespace {
+
+    uint16_t readWord(const uint8_t* p) {
+        return p[0] | (p[1] << 8);
+    }
+
+    // Skip sub-blocks starting at pos, returns false if they run past the end
+    bool skipSubBlocks(const uint8_t* data, size_t length, size_t& pos, uint32_t* bytes, uint32_t* blocks) {
+        while (pos < length) {
+            uint8_t size = data[pos++];
+            if (size == 0) return true;
+            if (bytes) *bytes += size;
+            if (blocks) (*blocks)++;
+            pos += size;
+        }
+        return false;
+    }
+}
+
+bool scanGif(const uint8_t* data, size_t length, GifScan& scan) {
+    scan.width = scan.height = scan.globalColors = 0;
+    scan.frames.clear();
+
+    if (length < 13 || (memcmp(data, "GIF89a", 6) != 0 && memcmp(data, "GIF87a", 6) != 0)) {
+        return false;
+    }
+
+    scan.width = readWord(data + 6);
+    scan.height = readWord(data + 8);
+    size_t pos = 13;
+    if (data[10] & 0x80) {
+        scan.globalColors = 1 << ((data[10] & 0x07) + 1);
+        pos += scan.globalColors * 3;
+    }
+
+    GifScanFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.transparentIndex = -1;
+
+    while (pos < length) {
+        uint8_t type = data[pos++];
+        if (type == 0x3B) { // Trailer
+            return true;
+        }
+
+        if (type == 0x21) { // Extension
+            if (pos >= length) return false;
+            uint8_t label = data[pos++];
+            if (label == 0xF9 && pos + 5 <= length && data[pos] == 4) {
+                uint8_t packed = data[pos + 1];
+                frame.disposal = (packed >> 2) & 0x07;
+                frame.delay = readWord(data + pos + 2);
+                frame.transparentIndex = (packed & 0x01) ? data[pos + 4] : -1;
+            }
+            if (!skipSubBlocks(data, length, pos, nullptr, nullptr)) return false;
+        } else if (type == 0x2C) { // Image descriptor
+            if (pos + 9 > length) return false;
+            frame.x = readWord(data + pos);
+            frame.y = readWord(data + pos + 2);
+            frame.width = readWord(data + pos + 4);
+            frame.height = readWord(data + pos + 6);
+            uint8_t flags = data[pos + 8];
+            pos += 9;
+
+            frame.interlaced = (flags & 0x40) != 0;
+            frame.localColors = (flags & 0x80) ? 1 << ((flags & 0x07) + 1) : 0;
+            pos += frame.localColors * 3;
+            if (pos >= length) return false;
+
+            frame.minCodeSize = data[pos++];
+            frame.dataOffset = pos;
+            frame.dataBytes = 0;
+            frame.subBlocks = 0;
+            if (!skipSubBlocks(data, length, pos, &frame.dataBytes, &frame.subBlocks)) return false;
+
+            scan.frames.push_back(frame);
+
+            // Control extensions apply to the next image only
+            memset(&frame, 0, sizeof(frame));
+            frame.transparentIndex = -1;
+        } else {
+            return false;
+        }
+    }
+
+    return true; // Missing trailer
+}
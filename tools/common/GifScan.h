@@ -0,0 +1,49 @@
+/**
+ * @file GifScan.h
+ * @brief Block-level GIF structure scan for the host tools
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#ifndef GIF_SCAN_H
+#define GIF_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Location and layout of one frame
+struct GifScanFrame {
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+    uint16_t delay;             // Hundredths of a second
+    uint8_t disposal;
+    int16_t transparentIndex;   // -1 for none
+    bool interlaced;
+    uint16_t localColors;       // 0 if the global palette is used
+    uint8_t minCodeSize;
+    uint32_t dataOffset;        // First sub-block size byte
+    uint32_t dataBytes;         // LZW bytes without sub-block size bytes
+    uint32_t subBlocks;
+};
+
+struct GifScan {
+    uint16_t width;
+    uint16_t height;
+    uint16_t globalColors;      // 0 if there is no global palette
+    std::vector<GifScanFrame> frames;
+};
+
+/**
+ * @brief Walk the blocks of a GIF file
+ * @param data File data
+ * @param length File length
+ * @param scan Receives the structure
+ * @return true if the file is well formed up to the trailer or its end
+ */
+bool scanGif(const uint8_t* data, size_t length, GifScan& scan);
+
+#endif // GIF_SCAN_H
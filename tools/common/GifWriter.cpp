@@ -0,0 +1,250 @@
+/**
+ * @file GifWriter.cpp
+ * @brief Minimal GIF89a encoder for the host tools
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include "GifWriter.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+// Open addressing hash of (prefix code, pixel) -> code
+#define GIF_WRITER_HASH_SIZE 8192
+
+namespace {
+
+    class BitPacker {
+    public:
+        BitPacker(std::vector<uint8_t>& out, uint8_t blockSize)
+            : _out(out), _blockSize(blockSize ? blockSize : 255), _bits(0), _bitCount(0), _blockStart(0) {
+            startBlock();
+        }
+
+        void write(uint16_t code, uint8_t size) {
+            _bits |= (uint32_t)code << _bitCount;
+            _bitCount += size;
+            while (_bitCount >= 8) {
+                putByte(_bits & 0xFF);
+                _bits >>= 8;
+                _bitCount -= 8;
+            }
+        }
+
+        void flush() {
+            if (_bitCount > 0) {
+                putByte(_bits & 0xFF);
+            }
+            if (_out.size() - _blockStart > 1) {
+                _out[_blockStart] = (uint8_t)(_out.size() - _blockStart - 1);
+            } else {
+                _out.pop_back(); // Empty block
+            }
+            _out.push_back(0); // Block terminator
+        }
+
+    private:
+        std::vector<uint8_t>& _out;
+        uint8_t _blockSize;
+        uint32_t _bits;
+        uint8_t _bitCount;
+        size_t _blockStart;
+
+        void startBlock() {
+            _blockStart = _out.size();
+            _out.push_back(0); // Size, patched when the block is full
+        }
+
+        void putByte(uint8_t value) {
+            _out.push_back(value);
+            if (_out.size() - _blockStart - 1 == _blockSize) {
+                _out[_blockStart] = _blockSize;
+                startBlock();
+            }
+        }
+    };
+}
+
+GifWriter::GifWriter(uint16_t width, uint16_t height, const std::vector<uint8_t>& globalPalette,
+                     int32_t loopCount)
+    : _finished(false) {
+    const uint8_t signature[6] = { 'G', 'I', 'F', '8', '9', 'a' };
+    _data.insert(_data.end(), signature, signature + 6);
+    writeWord(width);
+    writeWord(height);
+
+    uint8_t bits = paletteBits(globalPalette.size() / 3);
+    _data.push_back(globalPalette.empty() ? 0 : (0x80 | 0x70 | (bits - 1)));
+    _data.push_back(0); // Background color index
+    _data.push_back(0); // Aspect ratio
+    if (!globalPalette.empty()) {
+        writePalette(globalPalette, bits);
+    }
+
+    if (loopCount >= 0) {
+        const uint8_t netscape[14] = { 0x21, 0xFF, 11, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0' };
+        _data.insert(_data.end(), netscape, netscape + 14);
+        _data.push_back(3);
+        _data.push_back(1);
+        writeWord((uint16_t)loopCount);
+        _data.push_back(0);
+    }
+}
+
+void GifWriter::setEncodeOptions(const GifEncodeOptions& options) {
+    _options = options;
+}
+
+void GifWriter::addFrame(const GifFrame& frame) {
+    // Graphics control extension
+    _data.push_back(0x21);
+    _data.push_back(0xF9);
+    _data.push_back(4);
+    _data.push_back(((frame.disposal & 0x07) << 2) | (frame.transparentIndex >= 0 ? 1 : 0));
+    writeWord(frame.delay);
+    _data.push_back(frame.transparentIndex >= 0 ? (uint8_t)frame.transparentIndex : 0);
+    _data.push_back(0);
+
+    // Image descriptor
+    _data.push_back(0x2C);
+    writeWord(frame.x);
+    writeWord(frame.y);
+    writeWord(frame.width);
+    writeWord(frame.height);
+
+    uint8_t flags = frame.interlaced ? 0x40 : 0;
+    uint8_t bits = paletteBits(frame.localPalette.size() / 3);
+    if (!frame.localPalette.empty()) {
+        flags |= 0x80 | (bits - 1);
+    }
+    _data.push_back(flags);
+    if (!frame.localPalette.empty()) {
+        writePalette(frame.localPalette, bits);
+    }
+
+    // Index range decides the code size, whatever the palette size
+    uint8_t maxIndex = 1;
+    for (uint8_t index : frame.pixels) {
+        if (index > maxIndex) maxIndex = index;
+    }
+    uint8_t minCodeSize = paletteBits(maxIndex + 1);
+    if (minCodeSize < 2) minCodeSize = 2;
+    if (_options.minCodeSize > minCodeSize && _options.minCodeSize <= 8) {
+        minCodeSize = _options.minCodeSize;
+    }
+
+    if (!frame.interlaced) {
+        encodeLZW(frame.pixels.data(), frame.pixels.size(), minCodeSize, _data, _options);
+        return;
+    }
+
+    // Rows in the order of the four interlace passes
+    static const uint8_t passStart[4] = { 0, 4, 2, 1 };
+    static const uint8_t passStep[4] = { 8, 8, 4, 2 };
+    std::vector<uint8_t> rows;
+    rows.reserve(frame.pixels.size());
+    for (uint8_t pass = 0; pass < 4; pass++) {
+        for (uint32_t y = passStart[pass]; y < frame.height; y += passStep[pass]) {
+            const uint8_t* row = frame.pixels.data() + (size_t)y * frame.width;
+            rows.insert(rows.end(), row, row + frame.width);
+        }
+    }
+    encodeLZW(rows.data(), rows.size(), minCodeSize, _data, _options);
+}
+
+const std::vector<uint8_t>& GifWriter::finish() {
+    if (!_finished) {
+        _data.push_back(0x3B);
+        _finished = true;
+    }
+    return _data;
+}
+
+bool GifWriter::save(const char* path) {
+    finish();
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    bool ok = fwrite(_data.data(), 1, _data.size(), file) == _data.size();
+    return fclose(file) == 0 && ok;
+}
+
+void GifWriter::encodeLZW(const uint8_t* pixels, size_t count, uint8_t minCodeSize, std::vector<uint8_t>& out,
+                          const GifEncodeOptions& options) {
+    const uint16_t clearCode = 1 << minCodeSize;
+    const uint16_t endCode = clearCode + 1;
+    std::vector<int32_t> keys(GIF_WRITER_HASH_SIZE);
+    std::vector<uint16_t> codes(GIF_WRITER_HASH_SIZE);
+
+    out.push_back(minCodeSize);
+    BitPacker packer(out, options.subBlockSize);
+
+    uint8_t codeSize = minCodeSize + 1;
+    uint16_t nextCode = endCode + 1;
+    std::fill(keys.begin(), keys.end(), -1);
+    packer.write(clearCode, codeSize);
+
+    if (count == 0) {
+        packer.write(endCode, codeSize);
+        packer.flush();
+        return;
+    }
+
+    uint16_t prefix = pixels[0];
+    for (size_t i = 1; i < count; i++) {
+        int32_t key = ((int32_t)prefix << 8) | pixels[i];
+        uint32_t slot = ((uint32_t)key * 2654435761u) >> 19; // 13 bits
+        while (keys[slot] >= 0 && keys[slot] != key) {
+            slot = (slot + 1) & (GIF_WRITER_HASH_SIZE - 1);
+        }
+        if (keys[slot] == key) {
+            prefix = codes[slot];
+            continue;
+        }
+
+        packer.write(prefix, codeSize);
+        if (nextCode < 4096) {
+            keys[slot] = key;
+            codes[slot] = nextCode++;
+            // The decoder adds this entry one code later
+            if (nextCode - 1 == (1 << codeSize) && codeSize < 12) {
+                codeSize++;
+            }
+        } else if (options.deferredClear) {
+            // Full table: keep coding with the existing strings
+        } else {
+            packer.write(clearCode, codeSize);
+            std::fill(keys.begin(), keys.end(), -1);
+            codeSize = minCodeSize + 1;
+            nextCode = endCode + 1;
+        }
+        prefix = pixels[i];
+    }
+
+    packer.write(prefix, codeSize);
+    // The decoder adds an entry for the last code before reading the end code
+    if (nextCode > endCode + 1 && nextCode == (1 << codeSize) && codeSize < 12) {
+        codeSize++;
+    }
+    packer.write(endCode, codeSize);
+    packer.flush();
+}
+
+uint8_t GifWriter::paletteBits(size_t count) {
+    uint8_t bits = 1;
+    while (bits < 8 && ((size_t)1 << bits) < count) bits++;
+    return bits;
+}
+
+void GifWriter::writeWord(uint16_t value) {
+    _data.push_back(value & 0xFF);
+    _data.push_back(value >> 8);
+}
+
+void GifWriter::writePalette(const std::vector<uint8_t>& palette, uint8_t bits) {
+    size_t size = (size_t)3 << bits;
+    for (size_t i = 0; i < size; i++) {
+        _data.push_back(i < palette.size() ? palette[i] : 0);
+    }
+}
@@ -0,0 +1,99 @@
+/**
+ * @file GifWriter.h
+ * @brief Minimal GIF89a encoder for the host tools
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Writes animations from palette index frames with an LZW encoder of its
+ * own, so the tools can produce inputs without third-party files.
+ */
+
+#ifndef GIF_WRITER_H
+#define GIF_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// LZW stream layout
+struct GifEncodeOptions {
+    uint8_t minCodeSize = 0;            // 0 = smallest for the pixel values, else 2-8
+    bool deferredClear = false;         // Keep coding with a full table instead of clearing it
+    uint8_t subBlockSize = 255;         // Data sub-block size (1-255)
+};
+
+// One frame of palette indices
+struct GifFrame {
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint16_t delay = 10;                // Hundredths of a second
+    uint8_t disposal = 1;               // 0-3
+    int16_t transparentIndex = -1;      // -1 for none
+    bool interlaced = false;
+    std::vector<uint8_t> localPalette;  // RGB triplets, empty uses the global palette
+    std::vector<uint8_t> pixels;        // width * height indices, row by row
+};
+
+class GifWriter {
+public:
+    /**
+     * @brief Start an animation
+     * @param width Canvas width
+     * @param height Canvas height
+     * @param globalPalette RGB triplets (2-256 colors), empty for none
+     * @param loopCount Loop count (0 = infinite), negative writes no loop extension
+     */
+    GifWriter(uint16_t width, uint16_t height, const std::vector<uint8_t>& globalPalette,
+              int32_t loopCount = 0);
+
+    /**
+     * @brief Set the LZW stream layout of the following frames
+     */
+    void setEncodeOptions(const GifEncodeOptions& options);
+
+    /**
+     * @brief Append a frame
+     */
+    void addFrame(const GifFrame& frame);
+
+    /**
+     * @brief Finish the file
+     * @return Complete GIF data
+     */
+    const std::vector<uint8_t>& finish();
+
+    /**
+     * @brief Write the finished file
+     * @return true if successful
+     */
+    bool save(const char* path);
+
+    /**
+     * @brief LZW-encode indices into image data sub-blocks
+     * @param pixels Palette indices, each below 1 << minCodeSize
+     * @param count Number of indices
+     * @param minCodeSize LZW minimum code size (2-8)
+     * @param out Receives the code size byte, sub-blocks and terminator
+     * @param options Clear code and sub-block layout (minCodeSize is ignored)
+     */
+    static void encodeLZW(const uint8_t* pixels, size_t count, uint8_t minCodeSize, std::vector<uint8_t>& out,
+                          const GifEncodeOptions& options = GifEncodeOptions());
+
+    /**
+     * @brief Smallest color table size bits (1-8) holding count colors
+     */
+    static uint8_t paletteBits(size_t count);
+
+private:
+    std::vector<uint8_t> _data;
+    GifEncodeOptions _options;
+    bool _finished;
+
+    void writeWord(uint16_t value);
+    void writePalette(const std::vector<uint8_t>& palette, uint8_t bits);
+};
+
+#endif // GIF_WRITER_H
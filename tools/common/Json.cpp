@@ -0,0 +1,198 @@
+/**
+ * @file Json.cpp
+ * @brief Minimal JSON reader for the files the host tools write
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#include "Json.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+    struct Parser {
+        const std::string& text;
+        size_t pos;
+        std::string error;
+
+        void skipSpace() {
+            while (pos < text.size() && strchr(" \t\r\n", text[pos])) pos++;
+        }
+
+        bool fail(const char* message) {
+            if (error.empty()) {
+                char buffer[96];
+                snprintf(buffer, sizeof(buffer), "%s at offset %zu", message, pos);
+                error = buffer;
+            }
+            return false;
+        }
+
+        bool literal(const char* word) {
+            size_t length = strlen(word);
+            if (text.compare(pos, length, word) != 0) return fail("unexpected token");
+            pos += length;
+            return true;
+        }
+
+        bool parseString(std::string& out) {
+            pos++; // Opening quote
+            while (pos < text.size() && text[pos] != '"') {
+                char c = text[pos++];
+                if (c != '\\') {
+                    out += c;
+                    continue;
+                }
+                if (pos >= text.size()) break;
+                char e = text[pos++];
+                switch (e) {
+                    case 'n': out += '\n'; break;
+                    case 't': out += '\t'; break;
+                    case 'r': out += '\r'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'u': {
+                        // Code points are kept as UTF-8; surrogate pairs are not needed here
+                        if (pos + 4 > text.size()) return fail("bad escape");
+                        unsigned long code = strtoul(text.substr(pos, 4).c_str(), nullptr, 16);
+                        pos += 4;
+                        if (code < 0x80) {
+                            out += (char)code;
+                        } else if (code < 0x800) {
+                            out += (char)(0xC0 | (code >> 6));
+                            out += (char)(0x80 | (code & 0x3F));
+                        } else {
+                            out += (char)(0xE0 | (code >> 12));
+                            out += (char)(0x80 | ((code >> 6) & 0x3F));
+                            out += (char)(0x80 | (code & 0x3F));
+                        }
+                        break;
+                    }
+                    default: out += e; break;
+                }
+            }
+            if (pos >= text.size()) return fail("unterminated string");
+            pos++; // Closing quote
+            return true;
+        }
+
+        bool parseValue(JsonValue& value, int depth) {
+            if (depth > 64) return fail("nesting too deep");
+            skipSpace();
+            if (pos >= text.size()) return fail("unexpected end");
+
+            char c = text[pos];
+            if (c == '{') {
+                value.type = JsonValue::OBJECT;
+                pos++;
+                skipSpace();
+                if (pos < text.size() && text[pos] == '}') {
+                    pos++;
+                    return true;
+                }
+                while (true) {
+                    skipSpace();
+                    if (pos >= text.size() || text[pos] != '"') return fail("expected member name");
+                    std::pair<std::string, JsonValue> member;
+                    if (!parseString(member.first)) return false;
+                    skipSpace();
+                    if (pos >= text.size() || text[pos] != ':') return fail("expected ':'");
+                    pos++;
+                    if (!parseValue(member.second, depth + 1)) return false;
+                    value.members.push_back(member);
+                    skipSpace();
+                    if (pos < text.size() && text[pos] == ',') {
+                        pos++;
+                    } else if (pos < text.size() && text[pos] == '}') {
+                        pos++;
+                        return true;
+                    } else {
+                        return fail("expected ',' or '}'");
+                    }
+                }
+            }
+            if (c == '[') {
+                value.type = JsonValue::ARRAY;
+                pos++;
+                skipSpace();
+                if (pos < text.size() && text[pos] == ']') {
+                    pos++;
+                    return true;
+                }
+                while (true) {
+                    JsonValue item;
+                    if (!parseValue(item, depth + 1)) return false;
+                    value.items.push_back(item);
+                    skipSpace();
+                    if (pos < text.size() && text[pos] == ',') {
+                        pos++;
+                    } else if (pos < text.size() && text[pos] == ']') {
+                        pos++;
+                        return true;
+                    } else {
+                        return fail("expected ',' or ']'");
+                    }
+                }
+            }
+            if (c == '"') {
+                value.type = JsonValue::STRING;
+                return parseString(value.string);
+            }
+            if (c == 't' || c == 'f') {
+                value.type = JsonValue::BOOLEAN;
+                value.boolean = (c == 't');
+                return literal(value.boolean ? "true" : "false");
+            }
+            if (c == 'n') {
+                value.type = JsonValue::NUL;
+                return literal("null");
+            }
+
+            const char* start = text.c_str() + pos;
+            char* end = nullptr;
+            value.number = strtod(start, &end);
+            if (end == start) return fail("unexpected character");
+            value.type = JsonValue::NUMBER;
+            pos += end - start;
+            return true;
+        }
+    };
+}
+
+const JsonValue* JsonValue::get(const char* key) const {
+    if (type != OBJECT) return nullptr;
+    for (const auto& member : members) {
+        if (member.first == key) return &member.second;
+    }
+    return nullptr;
+}
+
+double JsonValue::getNumber(const char* key, double fallback) const {
+    const JsonValue* value = get(key);
+    return (value && value->type == NUMBER) ? value->number : fallback;
+}
+
+std::string JsonValue::getString(const char* key, const char* fallback) const {
+    const JsonValue* value = get(key);
+    return (value && value->type == STRING) ? value->string : fallback;
+}
+
+bool parseJson(const std::string& text, JsonValue& value, std::string& error) {
+    Parser parser = { text, 0, std::string() };
+    value = JsonValue();
+    if (!parser.parseValue(value, 0)) {
+        error = parser.error;
+        return false;
+    }
+    parser.skipSpace();
+    if (parser.pos != text.size()) {
+        parser.fail("trailing characters");
+        error = parser.error;
+        return false;
+    }
+    return true;
+}
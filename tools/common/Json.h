@@ -0,0 +1,58 @@
+/**
+ * @file Json.h
+ * @brief Minimal JSON reader for the files the host tools write
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ */
+
+#ifndef GIF_TOOLS_JSON_H
+#define GIF_TOOLS_JSON_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+struct JsonValue {
+    enum Type {
+        NUL = 0,
+        BOOLEAN,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT
+    };
+
+    Type type = NUL;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> items;                               // ARRAY
+    std::vector<std::pair<std::string, JsonValue>> members;     // OBJECT, in file order
+
+    /**
+     * @brief Member of an object, nullptr if missing or not an object
+     */
+    const JsonValue* get(const char* key) const;
+
+    /**
+     * @brief Number member, or fallback if missing or not a number
+     */
+    double getNumber(const char* key, double fallback = 0) const;
+
+    /**
+     * @brief String member, or fallback if missing or not a string
+     */
+    std::string getString(const char* key, const char* fallback = "") const;
+};
+
+/**
+ * @brief Parse a JSON document
+ * @param text Document text
+ * @param value Receives the root value
+ * @param error Receives a message with the byte offset on failure
+ * @return true if successful
+ */
+bool parseJson(const std::string& text, JsonValue& value, std::string& error);
+
+#endif // GIF_TOOLS_JSON_H
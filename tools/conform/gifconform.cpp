@@ -0,0 +1,991 @@
+/**
+ * @file gifconform.cpp
+ * @brief Differential conformance check of the decoder against the reference decoder
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Decodes every corpus file through every mode combination of the library
+ * (pixel format, memory or reader source, background image, ordered
+ * dithering, output path) and compares after each frame:
+ *
+ *   canvas   getFrameBuffer()
+ *   spans    canvas rebuilt from the frame callback spans
+ *   mask     getAlphaMask() and the mask callback spans
+ *   pixels   pixel callback colors (RGB565 and INDEXED8 formats)
+ *   stream   span stream decoded by ESP32_GIF_StreamDecoder (RGB565 formats)
+ *   redraw   the same outputs after redraw() of a random rect, emitted into
+ *            buffers filled with noise (after about every other frame)
+ *
+ * against ESP32_GIF_Reference, reporting the first mismatching pixel and
+ * frame. The compositor modes stack the file on an offset copy of itself
+ * with ESP32_GIF_Compositor, play it twice (reset() in between) and compare
+ * the pushed rows with a per-pixel blend of two reference canvases. Loop
+ * modes play with setLoop(true) into the third loop. The device, diffusion
+ * and correction modes set a device palette (nearest color or error
+ * diffusion) or a color correction and brightness; the reference colors go
+ * through a plain rewrite of the same path (ESP32_GIF_Reference::
+ * setColorMap()). nextFrame() is timed on its own, so the same run gives
+ * ns/pixel per mode next to the verdict. Before the corpus, stream round
+ * trips check that every indexed palette change reaches the receiver and
+ * that a receiver which lost a byte decodes the next frame whole.
+ *
+ *   gifconform [--filter TEXT] [--corpus SET] [--verbose] [--list] [file.gif|dir ...]
+ */
+
+#include "ESP32_AnimatedGIF.h"
+#include "ESP32_GIF_Compositor.h"
+#include "ESP32_GIF_Reference.h"
+#include "GifFiles.h"
+#include "GifScan.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+    enum class Output {
+        CANVAS = 0,         // Frame buffer only
+        CALLBACKS,          // Frame, pixel and mask callbacks
+        STREAM_RGB565,
+        STREAM_INDEXED,
+        REDRAW,             // Callbacks (and RGB565 stream) fed by redraw()
+        COMPOSITOR          // Two layers through ESP32_GIF_Compositor
+    };
+
+    enum class Color {
+        NATIVE = 0,         // GIF colors as they are
+        DEVICE,             // setDevicePalette(), nearest device color
+        DIFFUSION,          // setDevicePalette() with DitherMode::ERROR_DIFFUSION
+        CORRECTION          // setColorCorrection() and setBrightness()
+    };
+
+    struct Mode {
+        std::string name;
+        PixelFormat format;
+        bool reader;
+        bool background;
+        bool dither;
+        bool loop;          // setLoop(true), played over two loops
+        Color color;
+        Output output;
+    };
+
+    // Pixel rect, right and bottom exclusive
+    struct Rect {
+        uint16_t left;
+        uint16_t top;
+        uint16_t right;
+        uint16_t bottom;
+    };
+
+    const Rect kWholeCanvas = { 0, 0, 0xFFFF, 0xFFFF };
+
+    struct Mismatch {
+        bool found;
+        uint16_t frame;
+        std::string what;
+        uint16_t x;
+        uint16_t y;
+        uint32_t expected;
+        uint32_t actual;
+    };
+
+    struct ModeResult {
+        const Mode* mode;
+        uint32_t frames;
+        double ns;
+        uint64_t pixels;
+        Mismatch mismatch;
+    };
+
+    // Rows pushed by the compositor, in region layout
+    struct Region {
+        size_t stride;
+        uint8_t bytes;
+        std::vector<uint8_t> pixels;
+    };
+
+    // Outputs collected from the callbacks, in canvas layout
+    struct Shadow {
+        uint16_t width;
+        uint16_t height;
+        uint8_t bpp;
+        size_t stride;
+        std::vector<uint8_t> spans;
+        std::vector<uint8_t> maskSpans;
+        std::vector<uint16_t> pixels;
+        std::vector<uint16_t> stream;
+        ESP32_GIF_StreamDecoder decoder;
+    };
+
+    const char* outputName(Output output) {
+        switch (output) {
+            case Output::CANVAS: return "canvas";
+            case Output::CALLBACKS: return "callbacks";
+            case Output::STREAM_RGB565: return "stream_rgb565";
+            case Output::STREAM_INDEXED: return "stream_indexed";
+            case Output::REDRAW: return "redraw";
+            case Output::COMPOSITOR: return "compositor";
+        }
+        return "?";
+    }
+
+    const char* colorName(Color color) {
+        switch (color) {
+            case Color::NATIVE: return "";
+            case Color::DEVICE: return "/device";
+            case Color::DIFFUSION: return "/diffusion";
+            case Color::CORRECTION: return "/correction";
+        }
+        return "?";
+    }
+
+    bool isRGB565(PixelFormat format) {
+        return format == PixelFormat::RGB565_LE || format == PixelFormat::RGB565_BE;
+    }
+
+    void buildModes(std::vector<Mode>& modes) {
+        for (PixelFormat format : kPixelFormats) {
+            std::vector<Output> outputs = { Output::CANVAS, Output::CALLBACKS, Output::REDRAW };
+            if (isRGB565(format)) {
+                // Stream colors are only exact when the canvas is RGB565
+                outputs.push_back(Output::STREAM_RGB565);
+                outputs.push_back(Output::STREAM_INDEXED);
+            }
+            bool packed = ESP32_GIF_Utils::bitsPerPixel(format) < 8;
+            uint8_t clear[4];
+            if (ESP32_GIF_Utils::packColor(clear, format, 0, 0, 0) != 0) {
+                outputs.push_back(Output::COMPOSITOR);
+            }
+
+            for (Output output : outputs) {
+                // Compositor layers are read from memory and have no background;
+                // redraw() never reads the source. Looping and the color paths
+                // are played from memory, colors in two exact formats
+                const bool layered = output == Output::COMPOSITOR;
+                const bool memoryOnly = layered || output == Output::REDRAW;
+                const bool colored = !memoryOnly &&
+                                     (format == PixelFormat::RGB888 || format == PixelFormat::RGB565_LE);
+                for (int dither = 0; dither <= (packed ? 1 : 0); dither++) {
+                    for (int reader = 0; reader <= (memoryOnly ? 0 : 1); reader++) {
+                        for (int background = 0; background <= (layered ? 0 : 1); background++) {
+                            bool loops = !reader && !background && output != Output::REDRAW;
+                            for (int loop = 0; loop <= (loops ? 1 : 0); loop++) {
+                                int colors = (colored && !reader && !loop) ? (int)Color::CORRECTION : 0;
+                                for (int color = 0; color <= colors; color++) {
+                                    Mode mode;
+                                    mode.format = format;
+                                    mode.reader = reader;
+                                    mode.background = background;
+                                    mode.dither = dither;
+                                    mode.loop = loop;
+                                    mode.color = (Color)color;
+                                    mode.output = output;
+                                    mode.name = std::string(pixelFormatName(format)) + "/" +
+                                                (reader ? "reader" : "memory") + "/" + outputName(output) +
+                                                (background ? "/bg" : "") + (dither ? "/dither" : "") +
+                                                (loop ? "/loop" : "") + colorName(mode.color);
+                                    modes.push_back(mode);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------
+    // Callbacks
+    // -----------------------------------------------------------------------
+
+    bool readSource(void* userData, uint8_t* buffer, uint32_t length, uint32_t position) {
+        const std::vector<uint8_t>& data = *(const std::vector<uint8_t>*)userData;
+        if ((uint64_t)position + length > data.size()) return false;
+        memcpy(buffer, data.data() + position, length);
+        return true;
+    }
+
+    void frameSpan(void* userData, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* pixels) {
+        Shadow& shadow = *(Shadow*)userData;
+        size_t first = ((size_t)x * shadow.bpp) / 8;
+        size_t last = (((size_t)x + width) * shadow.bpp + 7) / 8;
+        for (uint16_t row = 0; row < height; row++) {
+            memcpy(shadow.spans.data() + (y + row) * shadow.stride + first, pixels + row * shadow.stride, last - first);
+        }
+    }
+
+    void regionRow(void* userData, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t* pixels) {
+        Region& region = *(Region*)userData;
+        for (uint16_t row = 0; row < height; row++) {
+            memcpy(region.pixels.data() + (y + row) * region.stride + x * region.bytes,
+                   pixels + row * width * region.bytes, (size_t)width * region.bytes);
+        }
+    }
+
+    void maskSpan(void* userData, uint16_t x, uint16_t y, uint16_t width, const uint8_t* mask) {
+        Shadow& shadow = *(Shadow*)userData;
+        size_t stride = (shadow.width + 7) / 8;
+        memcpy(shadow.maskSpans.data() + y * stride + x / 8, mask, ((size_t)x + width + 7) / 8 - x / 8);
+    }
+
+    void pixelOut(void* userData, uint16_t x, uint16_t y, uint16_t color) {
+        Shadow& shadow = *(Shadow*)userData;
+        shadow.pixels[(size_t)y * shadow.width + x] = color;
+    }
+
+    void streamOut(void* userData, const uint8_t* data, uint32_t length) {
+        ((Shadow*)userData)->decoder.feed(data, length);
+    }
+
+    void streamPixel(void* userData, uint16_t x, uint16_t y, uint16_t color) {
+        Shadow& shadow = *(Shadow*)userData;
+        if (x < shadow.width && y < shadow.height) {
+            shadow.stream[(size_t)y * shadow.width + x] = color;
+        }
+    }
+
+    // -----------------------------------------------------------------------
+    // Device palette and color correction
+    // -----------------------------------------------------------------------
+
+    // PICO-8 colors: few grays, so most GIF colors move
+    const uint8_t kDevicePalette[16 * 3] = {
+        0x00, 0x00, 0x00, 0x1D, 0x2B, 0x53, 0x7E, 0x25, 0x53, 0x00, 0x87, 0x51,
+        0xAB, 0x52, 0x36, 0x5F, 0x57, 0x4F, 0xC2, 0xC3, 0xC7, 0xFF, 0xF1, 0xE8,
+        0xFF, 0x00, 0x4D, 0xFF, 0xA3, 0x00, 0xFF, 0xEC, 0x27, 0x00, 0xE4, 0x36,
+        0x29, 0xAD, 0xFF, 0x83, 0x76, 0x9C, 0xFF, 0x77, 0xA8, 0xFF, 0xCC, 0xAA
+    };
+
+    // Warm white balance with channel mixing that clips at both ends
+    const int16_t kCorrectionMatrix[9] = { 280, -24, 0, 0, 256, 0, -16, 16, 256 };
+    const uint8_t kBrightness = 200;
+
+    // The color path the library documents, written out plainly and applied
+    // to the reference colors through ESP32_GIF_Reference::setColorMap()
+    struct ColorCheck {
+        Color color;
+        uint8_t gamma[256];
+        uint16_t width;
+        std::vector<int16_t> errors;    // Current and next row of diffusion errors, 1/16 units
+        int32_t row;                    // Canvas row of the last diffused pixel
+    };
+
+    uint8_t nearestDevice(int32_t r, int32_t g, int32_t b) {
+        // Weighted distance 2:4:3, the first of equal colors wins
+        uint32_t best = 0xFFFFFFFF;
+        uint8_t index = 0;
+        for (uint8_t d = 0; d < 16; d++) {
+            const uint8_t* rgb = kDevicePalette + d * 3;
+            uint32_t distance = 2 * (r - rgb[0]) * (r - rgb[0]) + 4 * (g - rgb[1]) * (g - rgb[1]) +
+                                3 * (b - rgb[2]) * (b - rgb[2]);
+            if (distance < best) {
+                best = distance;
+                index = d;
+            }
+        }
+        return index;
+    }
+
+    void mapColor(void* userData, int32_t x, int32_t y, uint8_t* rgb) {
+        ColorCheck& check = *(ColorCheck*)userData;
+        if (check.color == Color::CORRECTION) {
+            // Matrix, then the gamma curve scaled by the brightness
+            int32_t in[3] = { rgb[0], rgb[1], rgb[2] };
+            for (uint8_t c = 0; c < 3; c++) {
+                const int16_t* m = kCorrectionMatrix + c * 3;
+                int32_t value = std::max(0, std::min(255, (m[0] * in[0] + m[1] * in[1] + m[2] * in[2] + 128) >> 8));
+                rgb[c] = (check.gamma[value] * kBrightness + 127) / 255;
+            }
+            return;
+        }
+        if (check.color == Color::DEVICE || x < 0) {
+            memcpy(rgb, kDevicePalette + nearestDevice(rgb[0], rgb[1], rgb[2]) * 3, 3);
+            return;
+        }
+
+        // Floyd-Steinberg over the frame rows. Every row of the frame passes
+        // its errors down, so after a row without opaque pixels none are left
+        size_t rowSize = ((size_t)check.width + 2) * 3;
+        int16_t* current = check.errors.data();
+        int16_t* next = current + rowSize;
+        if (y != check.row) {
+            if (y == check.row + 1) {
+                memcpy(current, next, rowSize * sizeof(int16_t));
+            } else {
+                memset(current, 0, rowSize * sizeof(int16_t));
+            }
+            memset(next, 0, rowSize * sizeof(int16_t));
+            check.row = y;
+        }
+
+        int16_t* e = current + (x + 1) * 3;
+        int32_t value[3];
+        for (uint8_t c = 0; c < 3; c++) {
+            value[c] = std::max(0, std::min(255, rgb[c] + e[c] / 16));
+        }
+        // Diffused colors are matched at the center of their 16-level cell
+        const uint8_t* device = kDevicePalette +
+                                nearestDevice((value[0] & 0xF0) | 8, (value[1] & 0xF0) | 8, (value[2] & 0xF0) | 8) * 3;
+        int16_t* below = next + x * 3;
+        for (uint8_t c = 0; c < 3; c++) {
+            int16_t error = value[c] - device[c];
+            e[3 + c] += error * 7;
+            below[c] += error * 3;
+            below[3 + c] += error * 5;
+            below[6 + c] += error;
+        }
+        memcpy(rgb, device, 3);
+    }
+
+    bool setColors(ESP32_AnimatedGIF& gif, ESP32_GIF_Reference& reference, ColorCheck& check, const Mode& mode) {
+        check.color = mode.color;
+        check.width = reference.getCanvasWidth();
+        check.errors.assign(((size_t)check.width + 2) * 3 * 2, 0);
+        check.row = -2;
+        for (uint16_t i = 0; i < 256; i++) {
+            check.gamma[i] = (uint8_t)(pow(i / 255.0, 2.2) * 255 + 0.5);
+        }
+
+        switch (mode.color) {
+            case Color::NATIVE:
+                return true;
+            case Color::DEVICE:
+            case Color::DIFFUSION:
+                if (mode.color == Color::DIFFUSION) {
+                    gif.setDither(DitherMode::ERROR_DIFFUSION);
+                }
+                if (!gif.setDevicePalette(kDevicePalette, 16)) return false;
+                break;
+            case Color::CORRECTION: {
+                ColorCorrection correction;
+                ESP32_GIF_Utils::initColorCorrection(correction);
+                memcpy(correction.matrix, kCorrectionMatrix, sizeof(correction.matrix));
+                correction.gammaTable = check.gamma;
+                if (!gif.setColorCorrection(&correction) || !gif.setBrightness(kBrightness)) return false;
+                break;
+            }
+        }
+        reference.setColorMap(mapColor, &check);
+        return true;
+    }
+
+    // -----------------------------------------------------------------------
+    // Comparison
+    // -----------------------------------------------------------------------
+
+    uint32_t pixelBits(const uint8_t* canvas, size_t stride, uint8_t bpp, uint16_t x, uint16_t y) {
+        // Pixels are MSB-first bit strings in every format
+        size_t bit = (size_t)y * stride * 8 + (size_t)x * bpp;
+        uint32_t value = 0;
+        for (uint8_t i = 0; i < bpp; i++, bit++) {
+            value = (value << 1) | ((canvas[bit >> 3] >> (7 - (bit & 7))) & 1);
+        }
+        return value;
+    }
+
+    bool compareCanvas(Mismatch& mismatch, uint16_t frame, const char* what, const uint8_t* expected,
+                       const uint8_t* actual, uint16_t width, uint16_t height, uint8_t bpp,
+                       const Rect& rect = kWholeCanvas) {
+        size_t stride = ((size_t)width * bpp + 7) / 8;
+        uint16_t right = std::min(rect.right, width);
+        for (uint16_t y = rect.top; y < std::min(rect.bottom, height); y++) {
+            if (memcmp(expected + y * stride, actual + y * stride, stride) == 0) continue;
+            for (uint16_t x = rect.left; x < right; x++) {
+                uint32_t e = pixelBits(expected, stride, bpp, x, y);
+                uint32_t a = pixelBits(actual, stride, bpp, x, y);
+                if (e != a) {
+                    mismatch = { true, frame, what, x, y, e, a };
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool compareColors(Mismatch& mismatch, uint16_t frame, const char* what, const uint8_t* expected,
+                       const std::vector<uint16_t>& actual, const Mode& mode, uint16_t width, uint16_t height,
+                       const Rect& rect = kWholeCanvas) {
+        // Expected RGB565 (or index) of every canvas pixel
+        uint8_t bpp = ESP32_GIF_Utils::bitsPerPixel(mode.format);
+        size_t stride = ((size_t)width * bpp + 7) / 8;
+        uint16_t right = std::min(rect.right, width);
+        for (uint16_t y = rect.top; y < std::min(rect.bottom, height); y++) {
+            for (uint16_t x = rect.left; x < right; x++) {
+                uint32_t e = pixelBits(expected, stride, bpp, x, y);
+                if (mode.format == PixelFormat::RGB565_LE) {
+                    e = ((e & 0xFF) << 8) | (e >> 8);
+                }
+                uint32_t a = actual[(size_t)y * width + x];
+                if (e != a) {
+                    mismatch = { true, frame, what, x, y, e, a };
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    uint64_t framePixels(const GifFile& file) {
+        GifScan scan;
+        scanGif(file.data.data(), file.data.size(), scan);
+        uint64_t pixels = 0;
+        for (const GifScanFrame& frame : scan.frames) {
+            if (frame.x < scan.width && frame.y < scan.height) {
+                pixels += (uint64_t)std::min<uint32_t>(frame.width, scan.width - frame.x) *
+                          std::min<uint32_t>(frame.height, scan.height - frame.y);
+            }
+        }
+        return pixels;
+    }
+
+    uint32_t nextRandom(uint32_t& seed, uint32_t range) {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) % range;
+    }
+
+    bool checkRedraw(ESP32_AnimatedGIF& gif, Shadow& shadow, const Mode& mode, uint32_t& seed, uint16_t frame,
+                     const uint8_t* expected, const uint8_t* expectedMask, Mismatch& m) {
+        // Redraw a random rect after about every other frame. The outputs
+        // are filled with noise first, so only pixels redraw() emitted match;
+        // the rect may reach past the canvas to exercise the clipping.
+        if (nextRandom(seed, 2)) return true;
+        uint16_t width = shadow.width;
+        uint16_t height = shadow.height;
+        uint16_t x = nextRandom(seed, width);
+        uint16_t y = nextRandom(seed, height);
+        uint16_t w = 1 + nextRandom(seed, width - x + 8);
+        uint16_t h = 1 + nextRandom(seed, height - y + 8);
+        Rect rect = { x, y, (uint16_t)std::min(x + w, (int)width), (uint16_t)std::min(y + h, (int)height) };
+
+        for (uint8_t& byte : shadow.spans) byte = nextRandom(seed, 256);
+        for (uint8_t& byte : shadow.maskSpans) byte = nextRandom(seed, 256);
+        for (uint16_t& color : shadow.pixels) color = nextRandom(seed, 0x10000);
+        for (uint16_t& color : shadow.stream) color = nextRandom(seed, 0x10000);
+
+        GIFError error = gif.redraw(x, y, w, h);
+        if (error != GIFError::SUCCESS) {
+            m = { true, frame, std::string("redraw failed: ") + ESP32_AnimatedGIF::getErrorMessage(error), 0, 0, 0, 0 };
+            return false;
+        }
+        if (!compareCanvas(m, frame, "redraw spans", expected, shadow.spans.data(), width, height, shadow.bpp, rect)) return false;
+        if (!compareCanvas(m, frame, "redraw mask spans", expectedMask, shadow.maskSpans.data(), width, height, 1, rect)) return false;
+        if (isRGB565(mode.format) || mode.format == PixelFormat::INDEXED8) {
+            if (!compareColors(m, frame, "redraw pixels", expected, shadow.pixels, mode, width, height, rect)) return false;
+        }
+        if (isRGB565(mode.format)) {
+            if (!compareColors(m, frame, "redraw stream", expected, shadow.stream, mode, width, height, rect)) return false;
+        }
+
+        // The animation state and the canvas are left as they were
+        return compareCanvas(m, frame, "canvas after redraw", expected, gif.getFrameBuffer(), width, height, shadow.bpp);
+    }
+
+    // -----------------------------------------------------------------------
+    // Compositor
+    // -----------------------------------------------------------------------
+
+    struct LayerCheck {
+        ESP32_AnimatedGIF gif;
+        ESP32_GIF_Reference reference;
+        int32_t x;
+        int32_t y;
+        std::vector<uint8_t> canvas;
+        std::vector<uint8_t> mask;
+    };
+
+    void blendLayers(std::vector<uint8_t>& expected, LayerCheck* const* layers, uint8_t count,
+                     const uint8_t* clear, uint8_t bytes, uint16_t width, uint16_t height) {
+        // Straight per-pixel blend: the topmost opaque layer pixel, else the clear color
+        for (int32_t y = 0; y < height; y++) {
+            for (int32_t x = 0; x < width; x++) {
+                const uint8_t* pixel = clear;
+                for (uint8_t k = 0; k < count; k++) {
+                    const LayerCheck& layer = *layers[k];
+                    int32_t lx = x - layer.x;
+                    int32_t ly = y - layer.y;
+                    int32_t layerWidth = layer.reference.getCanvasWidth();
+                    if (lx < 0 || ly < 0 || lx >= layerWidth || ly >= layer.reference.getCanvasHeight()) continue;
+                    if (!(layer.mask[ly * ((layerWidth + 7) / 8) + lx / 8] & (0x80 >> (lx & 7)))) continue;
+                    pixel = layer.canvas.data() + ((size_t)ly * layerWidth + lx) * bytes;
+                    break;
+                }
+                memcpy(expected.data() + ((size_t)y * width + x) * bytes, pixel, bytes);
+            }
+        }
+    }
+
+    void runCompositor(const GifFile& file, const Mode& mode, ModeResult& result) {
+        // Top layer offset over the bottom one so both transparency and
+        // occlusion are visible, with a margin of clear color
+        LayerCheck top;
+        LayerCheck bottom;
+        LayerCheck* layers[2] = { &top, &bottom };
+        for (LayerCheck* layer : layers) {
+            if (!layer->reference.load(file.data.data(), file.data.size())) {
+                result.mismatch = { true, 0, "reference cannot load the file", 0, 0, 0, 0 };
+                return;
+            }
+        }
+        uint16_t width = top.reference.getCanvasWidth();
+        uint16_t height = top.reference.getCanvasHeight();
+        bottom.x = bottom.y = 0;
+        top.x = width / 2;
+        top.y = height / 3;
+        uint32_t regionWidth = width + top.x + 1;
+        uint32_t regionHeight = height + top.y + 1;
+        if (regionWidth > 0xFFFF || regionHeight > 0xFFFF) return;
+
+        Region region;
+        region.bytes = ESP32_GIF_Utils::bitsPerPixel(mode.format) / 8;
+        region.stride = regionWidth * region.bytes;
+        region.pixels.assign(region.stride * regionHeight, 0);
+        uint8_t clear[4];
+        ESP32_GIF_Utils::packColor(clear, mode.format, 0x12, 0x34, 0x56);
+
+        ESP32_GIF_Compositor compositor;
+        if (!compositor.begin(regionWidth, regionHeight, mode.format)) {
+            result.mismatch = { true, 0, "compositor begin failed", 0, 0, 0, 0 };
+            return;
+        }
+        compositor.setOutput(regionRow, &region);
+        compositor.setClearColor(0x12, 0x34, 0x56);
+
+        // The top layer is added first: z decides, not insertion order
+        for (LayerCheck* layer : layers) {
+            layer->gif.begin(mode.format, false);
+            layer->gif.setLoop(mode.loop);
+            layer->canvas.resize((size_t)width * height * region.bytes);
+            layer->mask.resize((size_t)(width + 7) / 8 * height);
+            if (compositor.addLayer(&layer->gif, layer->x, layer->y, layer == &top ? 1 : 0) < 0) {
+                result.mismatch = { true, 0, "addLayer failed", 0, 0, 0, 0 };
+                return;
+            }
+            GIFError error = layer->gif.loadFromMemory(file.data.data(), file.data.size());
+            if (error != GIFError::SUCCESS) {
+                result.mismatch = { true, 0, std::string("load failed: ") + ESP32_AnimatedGIF::getErrorMessage(error), 0, 0, 0, 0 };
+                return;
+            }
+        }
+
+        std::vector<uint8_t> expected(region.pixels.size());
+        uint32_t now = 0;
+        uint16_t frame = 0;
+
+        // Without looping, the second pass checks that ended layers resume
+        // after reset(); looping layers wrap twice and show one more frame,
+        // so the canvas cleared by each wrap is checked as well
+        uint8_t wraps = 0;
+        for (int pass = 0; pass < (mode.loop ? 1 : 2); pass++) {
+            if (pass == 1) {
+                for (LayerCheck* layer : layers) {
+                    layer->gif.reset();
+                    layer->reference.load(file.data.data(), file.data.size());
+                }
+            }
+            for (;; frame++) {
+                // Every layer is due on every tick
+                now += 1000000;
+                auto start = std::chrono::steady_clock::now();
+                compositor.tick(now);
+                result.ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+                bool composed = false;
+                for (LayerCheck* layer : layers) {
+                    composed = layer->reference.nextFrame();
+                    if (!composed && mode.loop) {
+                        layer->reference.load(file.data.data(), file.data.size());
+                        composed = layer->reference.nextFrame();
+                        if (layer == &top) wraps++;
+                    }
+                    layer->reference.render(layer->canvas.data(), mode.format);
+                    layer->reference.renderMask(layer->mask.data(), false);
+                }
+                if (!composed) break;
+                result.frames++;
+
+                blendLayers(expected, layers, 2, clear, region.bytes, regionWidth, regionHeight);
+                if (!compareCanvas(result.mismatch, frame, "region", expected.data(), region.pixels.data(),
+                                   regionWidth, regionHeight, region.bytes * 8)) return;
+                if (wraps == 2) break;
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------
+    // Runs
+    // -----------------------------------------------------------------------
+
+    void runMode(const GifFile& file, const Mode& mode, ModeResult& result) {
+        result.mode = &mode;
+        result.frames = 0;
+        result.ns = 0;
+        result.mismatch.found = false;
+        if (mode.output == Output::COMPOSITOR) {
+            runCompositor(file, mode, result);
+            return;
+        }
+
+        ESP32_GIF_Reference reference;
+        if (!reference.load(file.data.data(), file.data.size())) {
+            result.mismatch = { true, 0, "reference cannot load the file", 0, 0, 0, 0 };
+            return;
+        }
+        uint16_t width = reference.getCanvasWidth();
+        uint16_t height = reference.getCanvasHeight();
+        uint8_t bpp = ESP32_GIF_Utils::bitsPerPixel(mode.format);
+        size_t stride = ((size_t)width * bpp + 7) / 8;
+        size_t maskStride = (width + 7) / 8;
+
+        Shadow shadow;
+        shadow.width = width;
+        shadow.height = height;
+        shadow.bpp = bpp;
+        shadow.stride = stride;
+        shadow.spans.assign(stride * height, 0);
+        shadow.maskSpans.assign(maskStride * height, 0);
+        shadow.pixels.assign((size_t)width * height, 0);
+        shadow.stream.assign((size_t)width * height, 0);
+        shadow.decoder.setPixelCallback(streamPixel, &shadow);
+
+        // Deterministic noise; every bit pattern is a valid canvas
+        std::vector<uint8_t> background(stride * height);
+        uint32_t seed = 12345;
+        for (uint8_t& byte : background) {
+            seed = seed * 1664525u + 1013904223u;
+            byte = seed >> 24;
+        }
+        const uint8_t* backgroundImage = mode.background ? background.data() : nullptr;
+
+        ESP32_AnimatedGIF gif;
+        gif.begin(mode.format, false);
+        gif.setLoop(mode.loop);
+        if (mode.dither) {
+            gif.setDither(DitherMode::ORDERED);
+        }
+        ColorCheck colors;
+        if (!setColors(gif, reference, colors, mode)) {
+            result.mismatch = { true, 0, "color setup failed", 0, 0, 0, 0 };
+            return;
+        }
+        switch (mode.output) {
+            case Output::CANVAS:
+            case Output::COMPOSITOR:
+                break;
+            case Output::CALLBACKS:
+            case Output::REDRAW:
+                gif.setFrameCallback(frameSpan, &shadow);
+                gif.setPixelCallback(pixelOut, &shadow);
+                gif.setAlphaMask(true);
+                gif.setMaskCallback(maskSpan, &shadow);
+                if (mode.output == Output::REDRAW && isRGB565(mode.format)) {
+                    gif.setStreamWriter(streamOut, &shadow, StreamEncoding::RLE_RGB565);
+                }
+                break;
+            case Output::STREAM_RGB565:
+                gif.setStreamWriter(streamOut, &shadow, StreamEncoding::RLE_RGB565);
+                break;
+            case Output::STREAM_INDEXED:
+                gif.setStreamWriter(streamOut, &shadow, StreamEncoding::RLE_INDEXED);
+                break;
+        }
+        gif.setBackground(backgroundImage);
+
+        GIFError error = mode.reader ? gif.load(readSource, (void*)&file.data)
+                                     : gif.loadFromMemory(file.data.data(), file.data.size());
+        if (error != GIFError::SUCCESS) {
+            result.mismatch = { true, 0, std::string("load failed: ") + ESP32_AnimatedGIF::getErrorMessage(error), 0, 0, 0, 0 };
+            return;
+        }
+        if (gif.getCanvasWidth() != width || gif.getCanvasHeight() != height) {
+            result.mismatch = { true, 0, "canvas size", 0, 0, (uint32_t)width << 16 | height,
+                                (uint32_t)gif.getCanvasWidth() << 16 | gif.getCanvasHeight() };
+            return;
+        }
+
+        std::vector<uint8_t> expected(stride * height);
+        std::vector<uint8_t> expectedMask(maskStride * height);
+        Mismatch& m = result.mismatch;
+        uint32_t redrawSeed = 777;
+
+        // Looping modes stop after the first frame of the third loop
+        uint8_t wraps = 0;
+        for (uint16_t frame = 0; ; frame++) {
+            auto start = std::chrono::steady_clock::now();
+            error = gif.nextFrame(false);
+            result.ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            colors.row = -2;
+            bool composed = reference.nextFrame();
+            if (!composed && mode.loop) {
+                reference.load(file.data.data(), file.data.size());
+                composed = reference.nextFrame();
+                wraps++;
+            }
+            if (error != GIFError::SUCCESS) {
+                if (composed || error != GIFError::EMPTY_FRAME) {
+                    m = { true, frame, std::string("library stopped: ") + ESP32_AnimatedGIF::getErrorMessage(error), 0, 0, 0, 0 };
+                }
+                return;
+            }
+            if (!composed) {
+                m = { true, frame, "reference ended first", 0, 0, 0, 0 };
+                return;
+            }
+            result.frames++;
+
+            reference.render(expected.data(), mode.format, backgroundImage, mode.dither);
+            if (!compareCanvas(m, frame, "canvas", expected.data(), gif.getFrameBuffer(), width, height, bpp)) return;
+
+            if (mode.output == Output::CALLBACKS) {
+                if (!compareCanvas(m, frame, "spans", expected.data(), shadow.spans.data(), width, height, bpp)) return;
+
+                reference.renderMask(expectedMask.data(), mode.background);
+                if (!gif.getAlphaMask()) {
+                    m = { true, frame, "no alpha mask", 0, 0, 0, 0 };
+                    return;
+                }
+                if (!compareCanvas(m, frame, "mask", expectedMask.data(), gif.getAlphaMask(), width, height, 1)) return;
+                if (!compareCanvas(m, frame, "mask spans", expectedMask.data(), shadow.maskSpans.data(), width, height, 1)) return;
+
+                if (isRGB565(mode.format) || mode.format == PixelFormat::INDEXED8) {
+                    if (!compareColors(m, frame, "pixels", expected.data(), shadow.pixels, mode, width, height)) return;
+                }
+            } else if (mode.output == Output::REDRAW) {
+                reference.renderMask(expectedMask.data(), mode.background);
+                if (!checkRedraw(gif, shadow, mode, redrawSeed, frame, expected.data(), expectedMask.data(), m)) return;
+            } else if (mode.output != Output::CANVAS) {
+                if (!compareColors(m, frame, "stream", expected.data(), shadow.stream, mode, width, height)) return;
+            }
+            if (wraps == 2) return;
+        }
+    }
+
+    // -----------------------------------------------------------------------
+    // Stream palette round trip
+    // -----------------------------------------------------------------------
+
+    struct PaletteRoundTrip {
+        ESP32_GIF_StreamDecoder decoder;
+        uint16_t colors[2];
+    };
+
+    void roundTripOut(void* userData, const uint8_t* data, uint32_t length) {
+        ((PaletteRoundTrip*)userData)->decoder.feed(data, length);
+    }
+
+    void roundTripPixel(void* userData, uint16_t x, uint16_t y, uint16_t color) {
+        if (x < 2 && y == 0) {
+            ((PaletteRoundTrip*)userData)->colors[x] = color;
+        }
+    }
+
+    bool checkStreamPalettes() {
+        // Alternates two palettes whose bytes share an FNV-1a hash, then
+        // decodes the stream; each frame must show its own palette
+        static const uint16_t palettes[2][2] = { { 0x5729, 0x03A4 }, { 0x0015, 0x0400 } };
+        static const uint8_t indices[2] = { 0, 1 };
+
+        PaletteRoundTrip roundTrip;
+        roundTrip.decoder.setPixelCallback(roundTripPixel, &roundTrip);
+        ESP32_GIF_StreamEncoder encoder;
+        encoder.begin(roundTripOut, &roundTrip, StreamEncoding::RLE_INDEXED);
+
+        for (uint16_t frame = 0; frame < 4; frame++) {
+            const uint16_t* palette = palettes[frame & 1];
+            encoder.beginFrame(frame, 2, 1);
+            encoder.writePalette(palette, 2);
+            encoder.beginRect(0, 0, 2, 1);
+            encoder.writeRow(indices, 2, palette, -1);
+            encoder.endFrame();
+
+            for (uint16_t x = 0; x < 2; x++) {
+                if (roundTrip.colors[x] != palette[x]) {
+                    printf("  FAIL stream palette: frame %u at (%u, 0): expected 0x%X, got 0x%X\n",
+                           frame, x, palette[x], roundTrip.colors[x]);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    struct ResyncRoundTrip {
+        ESP32_GIF_StreamDecoder decoder;
+        std::vector<uint8_t> bytes;
+        uint16_t colors[8];
+    };
+
+    void resyncOut(void* userData, const uint8_t* data, uint32_t length) {
+        std::vector<uint8_t>& bytes = ((ResyncRoundTrip*)userData)->bytes;
+        bytes.insert(bytes.end(), data, data + length);
+    }
+
+    void resyncPixel(void* userData, uint16_t x, uint16_t y, uint16_t color) {
+        if (x < 8 && y == 0) {
+            ((ResyncRoundTrip*)userData)->colors[x] = color;
+        }
+    }
+
+    bool checkStreamResync() {
+        // Frames of literal 0xA5 bytes; with any one byte of the first frame
+        // lost, the receiver must drop that record and decode the next frame
+        static const uint16_t colors[2][8] = {
+            { 0xA5A5, 0x00A5, 0xA5A5, 0x00A5, 0xA5A5, 0x00A5, 0xA5A5, 0x00A5 },
+            { 0xA500, 0xA5A5, 0xA500, 0xA5A5, 0xA500, 0xA5A5, 0xA500, 0xA5A5 } };
+
+        ResyncRoundTrip roundTrip;
+        std::vector<uint8_t> frames[2];
+        ESP32_GIF_StreamEncoder encoder;
+        encoder.begin(resyncOut, &roundTrip, StreamEncoding::RLE_RGB565);
+        for (uint16_t frame = 0; frame < 2; frame++) {
+            roundTrip.bytes.clear();
+            encoder.beginFrame(frame, 8, 1);
+            encoder.beginRect(0, 0, 8, 1);
+            encoder.writeColors(colors[frame], 8);
+            encoder.endFrame();
+            frames[frame] = roundTrip.bytes;
+        }
+
+        for (size_t lost = 0; lost < frames[0].size(); lost++) {
+            std::vector<uint8_t> bytes = frames[0];
+            bytes.erase(bytes.begin() + lost);
+            roundTrip.decoder.reset();
+            roundTrip.decoder.setPixelCallback(resyncPixel, &roundTrip);
+            roundTrip.decoder.feed(bytes.data(), bytes.size());
+            memset(roundTrip.colors, 0, sizeof(roundTrip.colors));
+            roundTrip.decoder.feed(frames[1].data(), frames[1].size());
+
+            if (roundTrip.decoder.getCurrentFrame() != 1) {
+                printf("  FAIL stream resync: byte %u lost, frame 1 header missed\n", (unsigned)lost);
+                return false;
+            }
+            for (uint16_t x = 0; x < 8; x++) {
+                if (roundTrip.colors[x] != colors[1][x]) {
+                    printf("  FAIL stream resync: byte %u lost, frame 1 at (%u, 0): expected 0x%X, got 0x%X\n",
+                           (unsigned)lost, x, colors[1][x], roundTrip.colors[x]);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void printMismatch(const GifFile& file, const ModeResult& r) {
+        const Mismatch& m = r.mismatch;
+        printf("  FAIL %s/%s: frame %u %s", file.name.c_str(), r.mode->name.c_str(), m.frame, m.what.c_str());
+        if (m.expected != m.actual) {
+            printf(" at (%u, %u): expected 0x%X, got 0x%X", m.x, m.y, m.expected, m.actual);
+        }
+        printf("\n");
+    }
+
+    void usage() {
+        fprintf(stderr,
+                "usage: gifconform [--filter TEXT] [--corpus SET] [--verbose] [--list] [file.gif|dir ...]\n"
+                "  --filter TEXT  only run file/mode combinations whose name contains TEXT\n"
+                "  --corpus SET   generated corpus when no files are given: sweep (default) or bench\n"
+                "  --verbose      print every mode, not only the per-file summary\n"
+                "  --list         list the modes and exit\n"
+                "Files and directories replace the generated corpus.\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* filter = nullptr;
+    std::string corpusName = "sweep";
+    bool verbose = false;
+    bool list = false;
+    std::vector<GifFile> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--corpus") == 0 && i + 1 < argc) {
+            corpusName = argv[++i];
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list = true;
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else if (!addGifPath(files, argv[i], "gifconform")) {
+            return 2;
+        }
+    }
+
+    std::vector<Mode> modes;
+    buildModes(modes);
+    if (list) {
+        for (const Mode& mode : modes) {
+            printf("%s\n", mode.name.c_str());
+        }
+        return 0;
+    }
+
+    if (files.empty() && !addCorpusSet(files, corpusName, "gifconform")) {
+        return 2;
+    }
+
+    bool streamOk = checkStreamPalettes();
+    streamOk = checkStreamResync() && streamOk;
+
+    printf("%-28s %6s %6s %7s %10s %10s %10s  %s\n",
+           "file", "modes", "failed", "frames", "min ns/px", "med ns/px", "max ns/px", "slowest mode");
+    uint32_t totalRuns = 0;
+    uint32_t totalFailed = 0;
+
+    for (const GifFile& file : files) {
+        uint64_t pixels = framePixels(file);
+        std::vector<ModeResult> results;
+
+        for (const Mode& mode : modes) {
+            if (filter && (file.name + "/" + mode.name).find(filter) == std::string::npos) continue;
+            ModeResult result;
+            runMode(file, mode, result);
+            result.pixels = pixels;
+            results.push_back(result);
+        }
+        if (results.empty()) continue;
+
+        std::vector<double> nsPerPixel;
+        const ModeResult* slowest = &results[0];
+        uint32_t failed = 0;
+        for (const ModeResult& r : results) {
+            nsPerPixel.push_back(r.pixels ? r.ns / r.pixels : 0);
+            if (r.ns > slowest->ns) slowest = &r;
+            if (r.mismatch.found) failed++;
+        }
+        std::vector<double> sorted = nsPerPixel;
+        std::sort(sorted.begin(), sorted.end());
+
+        printf("%-28s %6zu %6u %7u %10.2f %10.2f %10.2f  %s\n", file.name.c_str(), results.size(), failed,
+               results[0].frames, sorted.front(), sorted[sorted.size() / 2], sorted.back(), slowest->mode->name.c_str());
+
+        for (size_t i = 0; i < results.size(); i++) {
+            const ModeResult& r = results[i];
+            if (verbose) {
+                printf("  %-44s %4u frames %10.2f ns/px  %s\n", r.mode->name.c_str(), r.frames, nsPerPixel[i],
+                       r.mismatch.found ? "FAIL" : "ok");
+            }
+            if (r.mismatch.found) {
+                printMismatch(file, r);
+            }
+        }
+        totalRuns += results.size();
+        totalFailed += failed;
+    }
+
+    printf("%u of %u runs match the reference\n", totalRuns - totalFailed, totalRuns);
+    if (!streamOk) {
+        printf("stream round trip failed\n");
+    }
+    return (totalFailed || !streamOk) ? 1 : 0;
+}
@@ -0,0 +1,327 @@
+/**
+ * @file gifembed.cpp
+ * @brief Writes a GIF as a C header bundle for ESP32_AnimatedGIF::loadBundle()
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * The header holds the GIF bytes, a constexpr frame index (offset of each
+ * frame, delay as played, palette) and every distinct color table already
+ * converted to the canvas values of one pixel format:
+ *
+ *   #include "spinner.h"
+ *   gif.begin(PixelFormat::RGB565_LE);
+ *   gif.loadBundle(spinner);            // no copy, no scan, no palette conversion
+ *
+ * The file is played once with loadFromMemory() and once with the bundle,
+ * and the canvases are compared after every frame before the header is
+ * written.
+ *
+ *   gifembed [--format FORMAT] [--dither MODE] [--name NAME] [--out FILE.h] file.gif
+ */
+
+#include "ESP32_AnimatedGIF.h"
+#include "GifFiles.h"
+#include "GifScan.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct Palette {
+        std::vector<uint8_t> rgb;   // Color table as in the file
+        std::vector<uint32_t> canvas;
+        std::vector<uint16_t> rgb565;
+    };
+
+    struct Bundle {
+        uint16_t width = 0;
+        uint16_t height = 0;
+        uint32_t totalDuration = 0;
+        std::vector<GIFBundleFrame> frames;
+        std::vector<Palette> palettes;
+        uint32_t black = 0;
+    };
+
+    const uint16_t kNoPalette = 0xFFFF;
+
+    uint16_t addPalette(Bundle& bundle, const uint8_t* rgb, uint16_t size, PixelFormat format, DitherMode dither) {
+        // Identical tables share one converted palette
+        std::vector<uint8_t> table(rgb, rgb + size * 3);
+        for (size_t i = 0; i < bundle.palettes.size(); i++) {
+            if (bundle.palettes[i].rgb == table) return i;
+        }
+
+        Palette palette;
+        palette.rgb = table;
+        for (uint16_t i = 0; i < size; i++) {
+            const uint8_t* color = rgb + i * 3;
+            palette.canvas.push_back(ESP32_GIF_Utils::convertColor(format, dither, color[0], color[1], color[2]));
+            palette.rgb565.push_back(ESP32_GIF_Utils::rgb888To565(color[0], color[1], color[2]));
+        }
+        bundle.palettes.push_back(palette);
+        return bundle.palettes.size() - 1;
+    }
+
+    bool buildBundle(const std::vector<uint8_t>& data, PixelFormat format, DitherMode dither, Bundle& bundle,
+                     std::string& error) {
+        GifScan scan;
+        if (!scanGif(data.data(), data.size(), scan) || scan.frames.empty()) {
+            error = "not a GIF with frames";
+            return false;
+        }
+
+        // Delays and duration exactly as the decoder plays them
+        ESP32_AnimatedGIF gif;
+        gif.begin(format, false);
+        gif.setDither(dither);
+        gif.setLoop(false);
+        if (gif.loadFromMemory(data.data(), data.size()) != GIFError::SUCCESS) {
+            error = ESP32_AnimatedGIF::getErrorMessage(gif.getLastError());
+            return false;
+        }
+        GIFInfo info;
+        gif.getInfo(info);
+        if (info.frameCount != scan.frames.size()) {
+            error = "frame count differs from the block scan";
+            return false;
+        }
+        bundle.width = info.width;
+        bundle.height = info.height;
+        bundle.totalDuration = info.totalDuration;
+        bundle.black = ESP32_GIF_Utils::convertColor(format, dither, 0, 0, 0);
+
+        uint16_t global = kNoPalette;
+        if (scan.globalColors > 0) {
+            global = addPalette(bundle, data.data() + 13, scan.globalColors, format, dither);
+        }
+
+        uint32_t offset = 13 + scan.globalColors * 3;
+        for (size_t i = 0; i < scan.frames.size(); i++) {
+            const GifScanFrame& frame = scan.frames[i];
+            if (gif.nextFrame(false) != GIFError::SUCCESS) {
+                error = "frame " + std::to_string(i) + ": " + ESP32_AnimatedGIF::getErrorMessage(gif.getLastError());
+                return false;
+            }
+            FrameInfo frameInfo;
+            gif.getFrameInfo(frameInfo);
+
+            GIFBundleFrame entry;
+            entry.offset = offset;
+            entry.delay = frameInfo.delay;
+            entry.palette = global;
+            if (frame.localColors > 0) {
+                // The local table sits before the LZW code size byte
+                const uint8_t* table = data.data() + frame.dataOffset - 1 - frame.localColors * 3;
+                entry.palette = addPalette(bundle, table, frame.localColors, format, dither);
+            }
+            bundle.frames.push_back(entry);
+
+            // The next frame starts after the block terminator
+            offset = frame.dataOffset + frame.dataBytes + frame.subBlocks + 1;
+        }
+        return true;
+    }
+
+    GIFBundle makeBundle(const std::vector<uint8_t>& data, const Bundle& bundle, PixelFormat format,
+                         DitherMode dither, std::vector<GIFBundlePalette>& palettes) {
+        palettes.clear();
+        for (const Palette& palette : bundle.palettes) {
+            palettes.push_back({ palette.canvas.data(), palette.rgb565.data(), (uint16_t)palette.canvas.size() });
+        }
+        return { data.data(), (uint32_t)data.size(), bundle.width, bundle.height, (uint16_t)bundle.frames.size(),
+                 bundle.totalDuration, bundle.frames.data(), palettes.data(), (uint16_t)palettes.size(),
+                 format, dither, bundle.black };
+    }
+
+    bool verify(const std::vector<uint8_t>& data, const GIFBundle& bundle, std::string& error) {
+        // The bundle must play exactly like the file itself
+        ESP32_AnimatedGIF reference;
+        ESP32_AnimatedGIF embedded;
+        for (ESP32_AnimatedGIF* gif : { &reference, &embedded }) {
+            gif->begin(bundle.format, false);
+            gif->setDither(bundle.dither);
+            gif->setLoop(false);
+        }
+        reference.loadFromMemory(data.data(), data.size());
+        if (embedded.loadBundle(bundle) != GIFError::SUCCESS) {
+            error = std::string("cannot load the bundle: ") +
+                    ESP32_AnimatedGIF::getErrorMessage(embedded.getLastError());
+            return false;
+        }
+
+        size_t size = ((size_t)bundle.width * ESP32_GIF_Utils::bitsPerPixel(bundle.format) + 7) / 8 * bundle.height;
+        for (uint16_t i = 0; i < bundle.frameCount; i++) {
+            reference.nextFrame(false);
+            if (embedded.nextFrame(false) != GIFError::SUCCESS) {
+                error = "bundle frame " + std::to_string(i) + ": " +
+                        ESP32_AnimatedGIF::getErrorMessage(embedded.getLastError());
+                return false;
+            }
+            if (memcmp(reference.getFrameBuffer(), embedded.getFrameBuffer(), size) != 0) {
+                error = "bundle frame " + std::to_string(i) + " differs from the GIF";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::string identifier(const std::string& name) {
+        // File name without extension as a C identifier
+        std::string base = name.substr(0, name.rfind('.'));
+        std::string id;
+        for (char c : base) {
+            id += isalnum((unsigned char)c) ? c : '_';
+        }
+        if (id.empty() || isdigit((unsigned char)id[0])) id = "gif_" + id;
+        return id;
+    }
+
+    void writeHeader(FILE* out, const std::string& source, const std::string& name, const std::vector<uint8_t>& data,
+                     const Bundle& bundle, PixelFormat format, DitherMode dither) {
+        std::string guard;
+        for (char c : name) guard += toupper((unsigned char)c);
+        guard += "_BUNDLE_H";
+
+        fprintf(out, "// Generated by gifembed from %s: %ux%u, %u frames, %s palettes\n", source.c_str(),
+                bundle.width, bundle.height, (unsigned)bundle.frames.size(), pixelFormatName(format));
+        fprintf(out, "// Play with gif.begin(PixelFormat::%s) and gif.loadBundle(%s)\n\n", pixelFormatName(format),
+                name.c_str());
+        fprintf(out, "#ifndef %s\n#define %s\n\n#include <ESP32_AnimatedGIF.h>\n\n", guard.c_str(), guard.c_str());
+
+        fprintf(out, "static const uint8_t %s_gif[%u] = {", name.c_str(), (unsigned)data.size());
+        for (size_t i = 0; i < data.size(); i++) {
+            fprintf(out, "%s0x%02X%s", i % 16 ? " " : "\n    ", data[i], i + 1 < data.size() ? "," : "\n");
+        }
+        fprintf(out, "};\n\n");
+
+        bool wide = ESP32_GIF_Utils::bitsPerPixel(format) > 16;
+        for (size_t p = 0; p < bundle.palettes.size(); p++) {
+            const Palette& palette = bundle.palettes[p];
+            fprintf(out, "static constexpr uint32_t %s_palette%u_canvas[%u] = {", name.c_str(), (unsigned)p,
+                    (unsigned)palette.canvas.size());
+            for (size_t i = 0; i < palette.canvas.size(); i++) {
+                fprintf(out, wide ? "%s0x%08X%s" : "%s0x%04X%s", i % 8 ? " " : "\n    ", palette.canvas[i],
+                        i + 1 < palette.canvas.size() ? "," : "\n");
+            }
+            fprintf(out, "};\n");
+            fprintf(out, "static constexpr uint16_t %s_palette%u_rgb565[%u] = {", name.c_str(), (unsigned)p,
+                    (unsigned)palette.rgb565.size());
+            for (size_t i = 0; i < palette.rgb565.size(); i++) {
+                fprintf(out, "%s0x%04X%s", i % 8 ? " " : "\n    ", palette.rgb565[i],
+                        i + 1 < palette.rgb565.size() ? "," : "\n");
+            }
+            fprintf(out, "};\n\n");
+        }
+
+        if (bundle.palettes.empty()) {
+            fprintf(out, "static constexpr const GIFBundlePalette* %s_palettes = nullptr;\n\n", name.c_str());
+        } else {
+            fprintf(out, "static constexpr GIFBundlePalette %s_palettes[%u] = {\n", name.c_str(),
+                    (unsigned)bundle.palettes.size());
+            for (size_t p = 0; p < bundle.palettes.size(); p++) {
+                fprintf(out, "    { %s_palette%u_canvas, %s_palette%u_rgb565, %u },\n", name.c_str(), (unsigned)p,
+                        name.c_str(), (unsigned)p, (unsigned)bundle.palettes[p].canvas.size());
+            }
+            fprintf(out, "};\n\n");
+        }
+
+        fprintf(out, "// offset, delay (ms), palette\n");
+        fprintf(out, "static constexpr GIFBundleFrame %s_frames[%u] = {\n", name.c_str(),
+                (unsigned)bundle.frames.size());
+        for (const GIFBundleFrame& frame : bundle.frames) {
+            fprintf(out, "    { %u, %u, 0x%04X },\n", frame.offset, frame.delay, frame.palette);
+        }
+        fprintf(out, "};\n\n");
+
+        fprintf(out, "static constexpr GIFBundle %s = {\n", name.c_str());
+        fprintf(out, "    %s_gif, sizeof(%s_gif), %u, %u,\n", name.c_str(), name.c_str(), bundle.width, bundle.height);
+        fprintf(out, "    %u, %u, %s_frames,\n", (unsigned)bundle.frames.size(), bundle.totalDuration, name.c_str());
+        fprintf(out, "    %s_palettes, %u,\n", name.c_str(), (unsigned)bundle.palettes.size());
+        fprintf(out, "    PixelFormat::%s, DitherMode::%s, 0x%X\n", pixelFormatName(format),
+                dither == DitherMode::ORDERED ? "ORDERED" : "NONE", bundle.black);
+        fprintf(out, "};\n\n#endif // %s\n", guard.c_str());
+    }
+
+    void usage() {
+        fprintf(stderr,
+                "usage: gifembed [--format FORMAT] [--dither MODE] [--name NAME] [--out FILE.h] file.gif\n"
+                "  --format FORMAT  pixel format the palettes are converted to (default RGB565_LE)\n"
+                "  --dither MODE    none (default) or ordered, as passed to setDither()\n"
+                "  --name NAME      C name of the bundle (default: the file name)\n"
+                "  --out FILE.h     header to write (default: standard output)\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    PixelFormat format = PixelFormat::RGB565_LE;
+    DitherMode dither = DitherMode::NONE;
+    std::string name;
+    const char* outPath = nullptr;
+    const char* inPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--format") == 0 && hasValue) {
+            if (!parsePixelFormat(argv[++i], format)) {
+                fprintf(stderr, "gifembed: unknown pixel format %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--dither") == 0 && hasValue) {
+            if (!parseDitherMode(argv[++i], dither)) {
+                fprintf(stderr, "gifembed: unknown dither mode %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--name") == 0 && hasValue) {
+            name = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && hasValue) {
+            outPath = argv[++i];
+        } else if (argv[i][0] == '-' || inPath) {
+            usage();
+            return 2;
+        } else {
+            inPath = argv[i];
+        }
+    }
+    if (!inPath) {
+        usage();
+        return 2;
+    }
+
+    std::vector<uint8_t> data;
+    if (!readFile(inPath, data)) {
+        fprintf(stderr, "gifembed: cannot read %s\n", inPath);
+        return 1;
+    }
+    std::string source = inPath;
+    source = source.substr(source.find_last_of('/') + 1);
+    if (name.empty()) name = identifier(source);
+
+    Bundle bundle;
+    std::vector<GIFBundlePalette> palettes;
+    std::string error;
+    if (!buildBundle(data, format, dither, bundle, error) ||
+        !verify(data, makeBundle(data, bundle, format, dither, palettes), error)) {
+        fprintf(stderr, "gifembed: %s: %s\n", source.c_str(), error.c_str());
+        return 1;
+    }
+
+    FILE* out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "gifembed: cannot write %s\n", outPath);
+        return 1;
+    }
+    writeHeader(out, source, name, data, bundle, format, dither);
+    if (outPath && fclose(out) != 0) {
+        fprintf(stderr, "gifembed: cannot write %s\n", outPath);
+        return 1;
+    }
+    fprintf(stderr, "%s: %u frames, %u palettes, %u GIF bytes -> %s\n", source.c_str(),
+            (unsigned)bundle.frames.size(), (unsigned)bundle.palettes.size(), (unsigned)data.size(),
+            outPath ? outPath : "stdout");
+    return 0;
+}
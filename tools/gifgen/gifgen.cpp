@@ -0,0 +1,122 @@
+/**
+ * @file gifgen.cpp
+ * @brief Synthetic GIF corpus generator
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Writes a named set of deterministic GIF files (see GifCorpus.h) plus a
+ * manifest.json describing the parameters of every file.
+ *
+ *   gifgen [--set sweep|bench] [--filter TEXT] [--list] [--out DIR]
+ */
+
+#include "GifCorpus.h"
+#include "GifFiles.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+    void writeManifestEntry(FILE* out, const CorpusSpec& spec, size_t bytes, bool last) {
+        fprintf(out, "    {\"name\": \"%s\", \"file\": \"%s.gif\", \"bytes\": %zu, \"width\": %u, \"height\": %u, "
+                "\"frames\": %u, \"colors\": %u, \"min_code_size\": %u, \"local_palettes\": %s, \"interlaced\": %s, "
+                "\"disposal\": %u, \"transparency\": %u, \"delta_area\": %u, \"deferred_clear\": %s, "
+                "\"sub_block_size\": %u, \"content\": \"%s\", \"seed\": %u}%s\n",
+                spec.name.c_str(), spec.name.c_str(), bytes, spec.width, spec.height,
+                spec.frames, spec.colors, spec.minCodeSize, spec.localPalettes ? "true" : "false",
+                spec.interlaced ? "true" : "false", spec.disposal, spec.transparency, spec.deltaArea,
+                spec.deferredClear ? "true" : "false", spec.subBlockSize, corpusContentName(spec.content),
+                spec.seed, last ? "" : ",");
+    }
+
+    void usage() {
+        fprintf(stderr,
+                "usage: gifgen [--set sweep|bench] [--filter TEXT] [--list] [--out DIR]\n"
+                "  --set NAME     corpus set (default sweep)\n"
+                "  --filter TEXT  only files whose name contains TEXT\n"
+                "  --list         list the file names and exit\n"
+                "  --out DIR      output directory (default corpus)\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string set = "sweep";
+    std::string outDir = "corpus";
+    const char* filter = nullptr;
+    bool list = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--set") == 0 && i + 1 < argc) {
+            set = argv[++i];
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outDir = argv[++i];
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list = true;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    std::vector<CorpusSpec> all;
+    if (!corpusSet(set, all)) {
+        fprintf(stderr, "gifgen: unknown set '%s'\n", set.c_str());
+        return 2;
+    }
+
+    std::vector<CorpusSpec> specs;
+    for (const CorpusSpec& spec : all) {
+        if (!filter || spec.name.find(filter) != std::string::npos) {
+            specs.push_back(spec);
+        }
+    }
+
+    if (list) {
+        for (const CorpusSpec& spec : specs) {
+            printf("%s\n", spec.name.c_str());
+        }
+        return 0;
+    }
+
+    if (mkdir(outDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "gifgen: cannot create %s\n", outDir.c_str());
+        return 1;
+    }
+
+    std::string manifestPath = outDir + "/manifest.json";
+    FILE* manifest = fopen(manifestPath.c_str(), "w");
+    if (!manifest) {
+        fprintf(stderr, "gifgen: cannot write %s\n", manifestPath.c_str());
+        return 1;
+    }
+    fprintf(manifest, "{\n  \"tool\": \"gifgen\",\n  \"schema\": 1,\n  \"set\": \"%s\",\n  \"files\": [\n", set.c_str());
+
+    size_t totalBytes = 0;
+    for (size_t i = 0; i < specs.size(); i++) {
+        const CorpusSpec& spec = specs[i];
+        std::vector<uint8_t> data = generateCorpusFile(spec);
+        std::string path = outDir + "/" + spec.name + ".gif";
+
+        if (!writeFile(path, data)) {
+            fprintf(stderr, "gifgen: cannot write %s\n", path.c_str());
+            fclose(manifest);
+            return 1;
+        }
+
+        writeManifestEntry(manifest, spec, data.size(), i + 1 == specs.size());
+        totalBytes += data.size();
+    }
+
+    fprintf(manifest, "  ]\n}\n");
+    fclose(manifest);
+    printf("gifgen: wrote %zu files (%zu bytes) to %s\n", specs.size(), totalBytes, outDir.c_str());
+    return 0;
+}
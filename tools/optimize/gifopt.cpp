@@ -0,0 +1,622 @@
+/**
+ * @file gifopt.cpp
+ * @brief Re-encodes GIF files into the layout the decoder plays fastest
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Decodes every frame of a file with ESP32_AnimatedGIF into an ARGB8888
+ * canvas and encodes the canvas sequence again with GifWriter:
+ *
+ *   - one global palette (the cleared color first, a transparent index last)
+ *   - each frame reduced to the bounding box of the pixels that change,
+ *     unchanged pixels inside it transparent (repainted when 256 colors
+ *     leave no room for a transparent index)
+ *   - no interlacing, full 255-byte sub-blocks
+ *   - frames identical to the previous one merged into it (delays added)
+ *   - "restore to previous" replaced by keep / restore to background
+ *
+ * Pixels that become transparent again are cleared by switching the
+ * previous frame to "restore to background" and growing its rect over them;
+ * they clear to the background color, or to the untouched canvas value when
+ * the file only ever returns to that.
+ * The result is decoded again by the library and by ESP32_GIF_Reference
+ * and compared canvas by canvas (color and alpha, so every RGB format gives
+ * the same pixels; INDEXED8 indices change with the palette). A file that
+ * needs more than 255 colors, or transparency the background color cannot
+ * produce, is reported and left as it is.
+ *
+ * Per file it prints the frames, bytes and frame pixels before and after,
+ * the estimate() decode time of one loop and the measured host time. The
+ * host time decides: estimate() does not model sub-blocks, reader calls or
+ * interlacing, which are much of what the rewrite saves. Both files get an
+ * untimed pass, then are timed in back-to-back pairs whose order swaps
+ * every run. The rewrite is kept unless the median change of the pairs is
+ * a slowdown beyond its noise (3 standard errors); a change within the
+ * noise is printed as no significant change. With --out the optimized
+ * files are written, or the original when the optimized one is slower.
+ *
+ *   gifopt [--out DIR] [--cost US,NS_PIXEL,NS_BYTE] [--filter TEXT] [--corpus SET]
+ *          [file.gif|dir ...]
+ */
+
+#include "ESP32_AnimatedGIF.h"
+#include "ESP32_GIF_Reference.h"
+#include "GifFiles.h"
+#include "GifScan.h"
+#include "GifWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+    // ARGB8888 canvas pixels as 0xAARRGGBB
+    typedef std::vector<uint32_t> Canvas;
+
+    struct Animation {
+        uint16_t width = 0;
+        uint16_t height = 0;
+        int32_t loopCount = -1;         // -1 without a NETSCAPE extension
+        uint32_t background = 0;        // Value of pixels disposed to the background
+        std::vector<Canvas> canvases;   // After each frame
+        std::vector<uint16_t> delays;   // Hundredths of a second
+    };
+
+    // Output frame before encoding; pixels hold the canvas values after the
+    // frame, painted marks the pixels the frame changes
+    struct PendingFrame {
+        uint16_t x, y, width, height;
+        uint8_t disposal;
+        uint32_t delay;
+        uint16_t source;                // Last input frame shown by this frame
+        std::vector<uint32_t> pixels;
+        std::vector<uint8_t> painted;
+    };
+
+    struct Result {
+        bool optimized = false;
+        std::string reason;             // Why the file was left as it is
+        std::vector<uint8_t> data;
+        std::vector<uint16_t> sources;  // Input frame per output frame
+    };
+
+    // -----------------------------------------------------------------------
+    // Input
+    // -----------------------------------------------------------------------
+
+    int32_t findLoopCount(const std::vector<uint8_t>& data) {
+        static const char netscape[] = "NETSCAPE2.0";
+        size_t pos = std::search(data.begin(), data.end(), netscape, netscape + 11) - data.begin() + 11;
+        if (pos + 4 > data.size()) return -1;
+        if (data[pos] != 3 || data[pos + 1] != 1) return -1;
+        return data[pos + 2] | (data[pos + 3] << 8);
+    }
+
+    uint32_t readPixel(const uint8_t* argb) {
+        return ((uint32_t)argb[0] << 24) | ((uint32_t)argb[1] << 16) | ((uint32_t)argb[2] << 8) | argb[3];
+    }
+
+    bool decodeFrames(const std::vector<uint8_t>& data, Animation& animation, std::string& error) {
+        GifScan scan;
+        if (!scanGif(data.data(), data.size(), scan) && scan.frames.empty()) {
+            error = "not a readable GIF";
+            return false;
+        }
+
+        ESP32_AnimatedGIF gif;
+        gif.begin(PixelFormat::ARGB8888, false);
+        gif.setLoop(false);
+        if (gif.loadFromMemory(data.data(), data.size()) != GIFError::SUCCESS) {
+            error = ESP32_AnimatedGIF::getErrorMessage(gif.getLastError());
+            return false;
+        }
+        animation.width = gif.getCanvasWidth();
+        animation.height = gif.getCanvasHeight();
+        animation.loopCount = findLoopCount(data);
+
+        // Disposed pixels take the GIF background color with alpha 0
+        uint16_t globalColors = (data[10] & 0x80) ? 1 << ((data[10] & 0x07) + 1) : 0;
+        if (data[11] < globalColors) {
+            const uint8_t* rgb = data.data() + 13 + data[11] * 3;
+            animation.background = ((uint32_t)rgb[0] << 16) | ((uint32_t)rgb[1] << 8) | rgb[2];
+        }
+
+        size_t pixels = (size_t)animation.width * animation.height;
+        while (gif.nextFrame(false) == GIFError::SUCCESS) {
+            const uint8_t* frameBuffer = gif.getFrameBuffer();
+            Canvas canvas(pixels);
+            for (size_t i = 0; i < pixels; i++) {
+                canvas[i] = readPixel(frameBuffer + i * 4);
+            }
+            animation.canvases.push_back(canvas);
+        }
+        if (animation.canvases.size() != scan.frames.size()) {
+            error = "frames fail to decode";
+            return false;
+        }
+        for (const GifScanFrame& frame : scan.frames) {
+            animation.delays.push_back(frame.delay);
+        }
+        if (animation.canvases.empty()) {
+            error = "no frames";
+            return false;
+        }
+        return true;
+    }
+
+    // -----------------------------------------------------------------------
+    // Optimization
+    // -----------------------------------------------------------------------
+
+    uint32_t effectiveDelay(uint32_t delay) {
+        // The decoder plays delays below 2 (20 ms) as 2
+        return std::max<uint32_t>(delay, 2);
+    }
+
+    void growFrame(PendingFrame& frame, const Canvas& current, uint16_t canvasWidth,
+                   uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
+        // Re-lay the pixels into the larger rect, the new ones unchanged
+        uint16_t left = std::min(frame.x, x0);
+        uint16_t top = std::min(frame.y, y0);
+        uint16_t right = std::max<uint16_t>(frame.x + frame.width, x1);
+        uint16_t bottom = std::max<uint16_t>(frame.y + frame.height, y1);
+        uint16_t width = right - left;
+        uint16_t height = bottom - top;
+        std::vector<uint32_t> pixels((size_t)width * height, 0);
+        std::vector<uint8_t> painted((size_t)width * height, 0);
+        for (uint16_t row = 0; row < height; row++) {
+            std::copy(current.begin() + (size_t)(top + row) * canvasWidth + left,
+                      current.begin() + (size_t)(top + row) * canvasWidth + right, pixels.begin() + (size_t)row * width);
+        }
+        for (uint16_t row = 0; row < frame.height; row++) {
+            size_t from = (size_t)row * frame.width;
+            size_t to = (size_t)(frame.y + row - top) * width + (frame.x - left);
+            std::copy(frame.pixels.begin() + from, frame.pixels.begin() + from + frame.width, pixels.begin() + to);
+            std::copy(frame.painted.begin() + from, frame.painted.begin() + from + frame.width, painted.begin() + to);
+        }
+        frame.x = left;
+        frame.y = top;
+        frame.width = width;
+        frame.height = height;
+        frame.pixels.swap(pixels);
+        frame.painted.swap(painted);
+    }
+
+    bool planFrames(const Animation& animation, uint32_t cleared, std::vector<PendingFrame>& frames,
+                    std::string& error) {
+        // cleared is the (alpha 0) value "restore to background" produces
+        const uint16_t width = animation.width;
+        const uint16_t height = animation.height;
+        frames.clear();
+        Canvas current((size_t)width * height, 0);
+
+        for (size_t i = 0; i < animation.canvases.size(); i++) {
+            const Canvas& target = animation.canvases[i];
+
+            // Pixels that turn transparent need the previous frame disposed
+            uint16_t x0 = width, y0 = height, x1 = 0, y1 = 0;
+            for (uint16_t y = 0; y < height; y++) {
+                for (uint16_t x = 0; x < width; x++) {
+                    size_t p = (size_t)y * width + x;
+                    if (target[p] == current[p] || (target[p] >> 24) != 0) continue;
+                    if (target[p] != cleared) {
+                        error = "transparency the background color cannot produce";
+                        return false;
+                    }
+                    x0 = std::min(x0, x);
+                    y0 = std::min(y0, y);
+                    x1 = std::max<uint16_t>(x1, x + 1);
+                    y1 = std::max<uint16_t>(y1, y + 1);
+                }
+            }
+            if (x1 > x0) {
+                if (frames.empty()) {
+                    error = "transparency the background color cannot produce";
+                    return false;
+                }
+                PendingFrame& previous = frames.back();
+                growFrame(previous, current, width, x0, y0, x1, y1);
+                previous.disposal = 2;
+                for (uint16_t y = previous.y; y < previous.y + previous.height; y++) {
+                    std::fill(current.begin() + (size_t)y * width + previous.x,
+                              current.begin() + (size_t)y * width + previous.x + previous.width, cleared);
+                }
+            }
+
+            // Bounding box of the changed pixels
+            x0 = width, y0 = height, x1 = 0, y1 = 0;
+            for (uint16_t y = 0; y < height; y++) {
+                for (uint16_t x = 0; x < width; x++) {
+                    size_t p = (size_t)y * width + x;
+                    if (target[p] == current[p]) continue;
+                    x0 = std::min(x0, x);
+                    y0 = std::min(y0, y);
+                    x1 = std::max<uint16_t>(x1, x + 1);
+                    y1 = std::max<uint16_t>(y1, y + 1);
+                }
+            }
+            if (x1 <= x0) {
+                if (!frames.empty()) {
+                    // Same canvas as the last frame: show that one longer
+                    PendingFrame& previous = frames.back();
+                    previous.delay = effectiveDelay(previous.delay) + effectiveDelay(animation.delays[i]);
+                    previous.source = i;
+                    continue;
+                }
+                x0 = y0 = 0;
+                x1 = y1 = 1; // The first frame cannot be dropped
+            }
+
+            PendingFrame frame;
+            frame.x = x0;
+            frame.y = y0;
+            frame.width = x1 - x0;
+            frame.height = y1 - y0;
+            frame.disposal = 1;
+            frame.delay = animation.delays[i];
+            frame.source = i;
+            frame.pixels.assign((size_t)frame.width * frame.height, 0);
+            frame.painted.assign((size_t)frame.width * frame.height, 0);
+            for (uint16_t y = y0; y < y1; y++) {
+                for (uint16_t x = x0; x < x1; x++) {
+                    size_t p = (size_t)y * width + x;
+                    size_t q = (size_t)(y - y0) * frame.width + (x - x0);
+                    frame.painted[q] = target[p] != current[p];
+                    frame.pixels[q] = target[p];
+                    current[p] = target[p];
+                }
+            }
+            frames.push_back(frame);
+        }
+        return true;
+    }
+
+    bool encodeFrames(const Animation& animation, uint32_t cleared, const std::vector<PendingFrame>& frames,
+                      std::vector<uint8_t>& out, std::string& error) {
+        // Colors in order of appearance; every opaque canvas value was painted once
+        std::vector<uint32_t> colors;
+        std::unordered_map<uint32_t, uint16_t> indices;
+        bool disposes = false;
+        bool keepsTransparent = false;  // Unchanged pixel that only a transparent index can keep
+        for (const PendingFrame& frame : frames) {
+            disposes = disposes || frame.disposal == 2;
+            for (size_t i = 0; i < frame.pixels.size(); i++) {
+                uint32_t value = frame.pixels[i];
+                if (!frame.painted[i]) {
+                    keepsTransparent = keepsTransparent || (value >> 24) == 0;
+                } else if (!indices.count(value)) {
+                    indices[value] = colors.size();
+                    colors.push_back(value);
+                }
+            }
+        }
+
+        // Index 0 has the cleared color, so disposal clears to the same value
+        uint32_t clearedColor = cleared | 0xFF000000;
+        if (disposes && (!indices.count(clearedColor) || indices[clearedColor] != 0)) {
+            auto found = std::find(colors.begin(), colors.end(), clearedColor);
+            if (found != colors.end()) colors.erase(found);
+            colors.insert(colors.begin(), clearedColor);
+        }
+
+        // A transparent index for unchanged pixels keeps the frames compressible;
+        // without room for one, they are repainted with their current color
+        bool transparent = colors.size() < 256;
+        if (colors.size() > 256 || (keepsTransparent && !transparent)) {
+            error = "more than " + std::to_string(keepsTransparent ? 255 : 256) + " colors";
+            return false;
+        }
+        indices.clear();
+        std::vector<uint8_t> palette;
+        for (size_t i = 0; i < colors.size(); i++) {
+            indices[colors[i]] = i;
+            palette.push_back(colors[i] >> 16);
+            palette.push_back(colors[i] >> 8);
+            palette.push_back(colors[i]);
+        }
+        const uint16_t transparentIndex = colors.size();
+        if (transparent) {
+            palette.insert(palette.end(), 3, 0);
+        }
+
+        GifWriter writer(animation.width, animation.height, palette, animation.loopCount);
+        GifEncodeOptions options;
+        options.subBlockSize = 255;
+        writer.setEncodeOptions(options);
+        for (const PendingFrame& frame : frames) {
+            GifFrame gifFrame;
+            gifFrame.x = frame.x;
+            gifFrame.y = frame.y;
+            gifFrame.width = frame.width;
+            gifFrame.height = frame.height;
+            gifFrame.delay = (uint16_t)std::min<uint32_t>(frame.delay, 0xFFFF);
+            gifFrame.disposal = frame.disposal;
+            gifFrame.transparentIndex = transparent ? transparentIndex : -1;
+            gifFrame.pixels.resize(frame.pixels.size());
+            for (size_t i = 0; i < frame.pixels.size(); i++) {
+                bool keep = !frame.painted[i] && transparent;
+                gifFrame.pixels[i] = keep ? transparentIndex : indices[frame.pixels[i]];
+            }
+            writer.addFrame(gifFrame);
+        }
+        out = writer.finish();
+        return true;
+    }
+
+    bool optimize(const Animation& animation, Result& result) {
+        // Disposal clears to the GIF background color, or to the untouched
+        // canvas value when the animation only returns to that
+        std::vector<PendingFrame> frames;
+        uint32_t cleared = animation.background;
+        if (!planFrames(animation, cleared, frames, result.reason)) {
+            cleared = 0;
+            if (!planFrames(animation, cleared, frames, result.reason)) return false;
+        }
+        if (!encodeFrames(animation, cleared, frames, result.data, result.reason)) return false;
+        for (const PendingFrame& frame : frames) {
+            result.sources.push_back(frame.source);
+        }
+        return true;
+    }
+
+    // -----------------------------------------------------------------------
+    // Verification
+    // -----------------------------------------------------------------------
+
+    bool sameCanvas(const Canvas& expected, const uint8_t* argb, size_t pixels) {
+        for (size_t i = 0; i < pixels; i++) {
+            if (readPixel(argb + i * 4) != expected[i]) return false;
+        }
+        return true;
+    }
+
+    bool verify(const Animation& animation, const Result& result, std::string& error) {
+        size_t pixels = (size_t)animation.width * animation.height;
+
+        ESP32_AnimatedGIF gif;
+        gif.begin(PixelFormat::ARGB8888, false);
+        gif.setLoop(false);
+        if (gif.loadFromMemory(result.data.data(), result.data.size()) != GIFError::SUCCESS) {
+            error = "output does not load";
+            return false;
+        }
+        ESP32_GIF_Reference reference;
+        if (!reference.load(result.data.data(), result.data.size())) {
+            error = "output does not load in the reference decoder";
+            return false;
+        }
+        std::vector<uint8_t> referenceCanvas(pixels * 4);
+
+        for (size_t i = 0; i < result.sources.size(); i++) {
+            const Canvas& expected = animation.canvases[result.sources[i]];
+            if (gif.nextFrame(false) != GIFError::SUCCESS || !sameCanvas(expected, gif.getFrameBuffer(), pixels)) {
+                error = "library output differs at frame " + std::to_string(i);
+                return false;
+            }
+            if (!reference.nextFrame()) {
+                error = "reference decoder stops at frame " + std::to_string(i);
+                return false;
+            }
+            reference.render(referenceCanvas.data(), PixelFormat::ARGB8888);
+            if (!sameCanvas(expected, referenceCanvas.data(), pixels)) {
+                error = "reference output differs at frame " + std::to_string(i);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // -----------------------------------------------------------------------
+    // Cost
+    // -----------------------------------------------------------------------
+
+    void frameSink(void*, uint16_t, uint16_t, uint16_t, uint16_t, const uint8_t*) {
+    }
+
+    // Host time of both files, from runs that alternate between them
+    struct LoopTime {
+        double before = 0;              // Median loop time of each file, microseconds
+        double after = 0;
+        double change = 0;              // Median change of the run pairs, percent
+        double noise = 0;               // 3 standard errors of that median, percent
+    };
+
+    double median(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        return values.empty() ? 0 : values[values.size() / 2];
+    }
+
+    double timeLoop(const std::vector<uint8_t>& data) {
+        // One RGB565 + frame callback pass
+        ESP32_AnimatedGIF gif;
+        gif.begin(PixelFormat::RGB565_LE, false);
+        gif.setLoop(false);
+        gif.setFrameCallback(frameSink);
+        if (gif.loadFromMemory(data.data(), data.size()) != GIFError::SUCCESS) return 0;
+        auto start = std::chrono::steady_clock::now();
+        while (gif.nextFrame(false) == GIFError::SUCCESS) {
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void timeLoops(const std::vector<uint8_t>& original, const std::vector<uint8_t>* optimized, LoopTime& time) {
+        // After an untimed pass of each file, every run times both files
+        // back to back and the first of the pair swaps every run. Host drift
+        // hits both files of a pair alike and cancels in their change
+        std::vector<double> before, after, changes;
+        timeLoop(original);
+        if (optimized) timeLoop(*optimized);
+        for (int run = 0; run < 8; run++) {
+            double b = 0, a = 0;
+            if (optimized && (run & 1)) {
+                a = timeLoop(*optimized);
+                b = timeLoop(original);
+            } else {
+                b = timeLoop(original);
+                if (optimized) a = timeLoop(*optimized);
+            }
+            before.push_back(b);
+            if (!optimized) continue;
+            after.push_back(a);
+            changes.push_back(b > 0 ? 100.0 * (a - b) / b : 0.0);
+        }
+
+        time.before = median(before);
+        time.after = optimized ? median(after) : time.before;
+        time.change = median(changes);
+        std::vector<double> deviations;
+        for (double change : changes) {
+            deviations.push_back(fabs(change - time.change));
+        }
+        // Scaled MAD of the pairs, standard error of their median
+        double sigma = 1.4826 * median(deviations);
+        time.noise = changes.empty() ? 0 : 3 * sigma * 1.2533 / sqrt((double)changes.size());
+    }
+
+    uint32_t predictLoop(const std::vector<uint8_t>& data, const GIFCalibration& calibration, GIFEstimate& estimate) {
+        ESP32_AnimatedGIF gif;
+        gif.begin(PixelFormat::RGB565_LE, false);
+        gif.setFrameCallback(frameSink);
+        if (gif.estimateFromMemory(data.data(), data.size(), estimate, &calibration) != GIFError::SUCCESS) return 0;
+        return estimate.averageFrameMicros * estimate.frameCount;
+    }
+
+    double change(double before, double after) {
+        return before > 0 ? 100.0 * (after - before) / before : 0.0;
+    }
+
+    void usage() {
+        fprintf(stderr,
+                "usage: gifopt [--out DIR] [--cost US,NS_PIXEL,NS_BYTE] [--filter TEXT] [--corpus SET]\n"
+                "              [file.gif|dir ...]\n"
+                "  --out DIR        write the optimized files (the original when slower on the host)\n"
+                "  --cost C         estimate() per frame, pixel and byte costs from gifbench --calibrate\n"
+                "                   (default 20,10,10: RGB565 frame output on a desktop host)\n"
+                "  --filter TEXT    only files whose name contains TEXT\n"
+                "  --corpus SET     generated corpus when no files are given: bench (default) or sweep\n"
+                "Without --out the files are only analyzed, optimized and verified.\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* outDir = nullptr;
+    GIFCalibration calibration = { 20.0f, 10.0f, 10.0f };
+    const char* filter = nullptr;
+    std::string corpusName = "bench";
+    std::vector<GifFile> files;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--out") == 0 && hasValue) {
+            outDir = argv[++i];
+        } else if (strcmp(argv[i], "--cost") == 0 && hasValue) {
+            if (!parseCalibration(argv[++i], calibration)) {
+                fprintf(stderr, "gifopt: --cost needs US,NS_PIXEL,NS_BYTE\n");
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--filter") == 0 && hasValue) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--corpus") == 0 && hasValue) {
+            corpusName = argv[++i];
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else if (!addGifPath(files, argv[i], "gifopt")) {
+            return 2;
+        }
+    }
+    if (files.empty() && !addCorpusSet(files, corpusName, "gifopt")) {
+        return 2;
+    }
+
+    printf("%-24s %11s %17s %19s %19s %19s  %s\n", "file", "frames", "bytes", "frame_pixels", "est_loop_ms",
+           "host_loop_ms", "result");
+    int status = 0;
+    for (const GifFile& file : files) {
+        if (filter && file.name.find(filter) == std::string::npos) continue;
+
+        Animation animation;
+        Result result;
+        std::string error;
+        if (!decodeFrames(file.data, animation, error)) {
+            fprintf(stderr, "gifopt: %s: %s\n", file.name.c_str(), error.c_str());
+            status = 1;
+            continue;
+        }
+        result.optimized = optimize(animation, result);
+        if (result.optimized && !verify(animation, result, error)) {
+            // Never ship an output that does not play back identically
+            fprintf(stderr, "gifopt: %s: %s\n", file.name.c_str(), error.c_str());
+            status = 1;
+            continue;
+        }
+
+        GIFEstimate before;
+        GIFEstimate after;
+        uint32_t predictedBefore = predictLoop(file.data, calibration, before);
+        uint32_t predictedAfter = predictedBefore;
+
+        LoopTime time;
+        timeLoops(file.data, result.optimized ? &result.data : nullptr, time);
+        double measuredBefore = time.before;
+        double measuredAfter = measuredBefore;
+
+        const std::vector<uint8_t>* output = &file.data;
+        if (result.optimized) {
+            predictedAfter = predictLoop(result.data, calibration, after);
+            measuredAfter = time.after;
+            if (time.change <= time.noise) {
+                output = &result.data;
+            } else {
+                char text[64];
+                snprintf(text, sizeof(text), "original is faster (%+.0f%% host)", time.change);
+                result.reason = text;
+            }
+        }
+        bool optimized = output == &result.data;
+        if (!optimized) {
+            after = before;
+            predictedAfter = predictedBefore;
+            measuredAfter = measuredBefore;
+        }
+
+        char frames[24], bytes[32], pixels[32], predicted[32], measured[32];
+        snprintf(frames, sizeof(frames), "%u>%u", before.frameCount, after.frameCount);
+        snprintf(bytes, sizeof(bytes), "%u>%u", (unsigned)file.data.size(), (unsigned)output->size());
+        snprintf(pixels, sizeof(pixels), "%llu>%llu",
+                 (unsigned long long)before.averageFramePixels * before.frameCount,
+                 (unsigned long long)after.averageFramePixels * after.frameCount);
+        snprintf(predicted, sizeof(predicted), "%.2f>%.2f", predictedBefore / 1000.0, predictedAfter / 1000.0);
+        snprintf(measured, sizeof(measured), "%.2f>%.2f", measuredBefore / 1000.0, measuredAfter / 1000.0);
+        std::string verdict;
+        if (optimized) {
+            char host[48];
+            char text[96];
+            if (fabs(time.change) <= time.noise) {
+                snprintf(host, sizeof(host), "no significant change (+-%.0f%%)", time.noise);
+            } else {
+                snprintf(host, sizeof(host), "%+.0f%%", time.change);
+            }
+            snprintf(text, sizeof(text), "%s host, %+.0f%% est, verified", host, change(predictedBefore, predictedAfter));
+            verdict = text;
+        } else {
+            verdict = "kept: " + result.reason;
+        }
+        printf("%-24s %11s %17s %19s %19s %19s  %s\n", file.name.c_str(), frames, bytes, pixels, predicted, measured,
+               verdict.c_str());
+
+        if (outDir && !writeFile(outputPath(outDir, file.name, ".gif"), *output)) {
+            fprintf(stderr, "gifopt: cannot write %s to %s\n", file.name.c_str(), outDir);
+            status = 1;
+        }
+    }
+    return status;
+}
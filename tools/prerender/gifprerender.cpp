@@ -0,0 +1,278 @@
+/**
+ * @file gifprerender.cpp
+ * @brief Converts GIF files into pre-rendered animations (ESP32_GIF_Prerendered.h)
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Plays every file once with ESP32_AnimatedGIF in the target pixel format
+ * and stores, per frame, the delay and the canvas rows of the dirty rect
+ * (disposal included), raw or run-length coded. The result is played back
+ * with loadPrerenderedFromMemory() and compared with the GIF canvas after
+ * every frame before it is written.
+ *
+ * Per file it prints the frames, the GIF and pre-rendered sizes and the
+ * host time of one loop for both, with a frame callback as the sink.
+ *
+ *   gifprerender [--format FORMAT] [--dither MODE] [--rle] [--out DIR] [--filter TEXT]
+ *                [--corpus SET] [file.gif|dir ...]
+ */
+
+#include "ESP32_AnimatedGIF.h"
+#include "ESP32_GIF_Prerendered.h"
+#include "GifFiles.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct Options {
+        PixelFormat format = PixelFormat::RGB565_LE;
+        DitherMode dither = DitherMode::NONE;
+        bool rle = false;
+    };
+
+    void put16(std::vector<uint8_t>& out, uint16_t value) {
+        out.push_back(value & 0xFF);
+        out.push_back(value >> 8);
+    }
+
+    void put32(std::vector<uint8_t>& out, uint32_t value) {
+        put16(out, value & 0xFFFF);
+        put16(out, value >> 16);
+    }
+
+    void set32(std::vector<uint8_t>& out, size_t offset, uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            out[offset + i] = value >> (8 * i);
+        }
+    }
+
+    void widenRect(PixelFormat format, uint16_t canvasWidth, uint16_t& x, uint16_t& width) {
+        // Packed formats start and end on byte boundaries, as frame callback spans do
+        uint8_t bpp = ESP32_GIF_Utils::bitsPerPixel(format);
+        if (bpp % 8 == 0 || width == 0) return;
+        uint8_t group = (bpp & 1) ? 8 : (bpp & 2) ? 4 : 2;
+        uint16_t end = std::min<uint32_t>(canvasWidth, ((uint32_t)x + width + group - 1) / group * group);
+        x -= x % group;
+        width = end - x;
+    }
+
+    bool convert(const std::vector<uint8_t>& gifData, const Options& options, std::vector<uint8_t>& out,
+                 std::vector<std::vector<uint8_t>>& canvases, std::string& error) {
+        ESP32_AnimatedGIF gif;
+        gif.begin(options.format, false);
+        gif.setDither(options.dither);
+        gif.setLoop(false);
+        if (gif.loadFromMemory(gifData.data(), gifData.size()) != GIFError::SUCCESS) {
+            error = ESP32_AnimatedGIF::getErrorMessage(gif.getLastError());
+            return false;
+        }
+
+        const uint16_t width = gif.getCanvasWidth();
+        const uint16_t height = gif.getCanvasHeight();
+        const uint8_t bpp = ESP32_GIF_Utils::bitsPerPixel(options.format);
+        const uint8_t unitBytes = (bpp % 8) ? 1 : bpp / 8;
+        const size_t stride = ((size_t)width * bpp + 7) / 8;
+
+        std::vector<std::vector<uint8_t>> records;
+        uint32_t totalDuration = 0;
+        std::vector<uint8_t> packed(ESP32_GIF_Prerendered::maxEncodedSize(stride, unitBytes));
+        while (gif.nextFrame(false) == GIFError::SUCCESS) {
+            FrameInfo info;
+            gif.getFrameInfo(info);
+            uint16_t x, y, w, h;
+            if (!gif.getDirtyRect(x, y, w, h)) {
+                x = y = w = h = 0;
+            }
+            widenRect(options.format, width, x, w);
+            totalDuration += info.delay;
+
+            std::vector<uint8_t> record;
+            put16(record, info.delay);
+            put16(record, x);
+            put16(record, y);
+            put16(record, w);
+            put16(record, h);
+            put16(record, 0);
+            const uint8_t* canvas = gif.getFrameBuffer();
+            uint32_t rowBytes = ((uint32_t)w * bpp + 7) / 8;
+            for (uint16_t row = y; row < y + h; row++) {
+                const uint8_t* src = canvas + row * stride + ((size_t)x * bpp) / 8;
+                if (options.rle) {
+                    uint32_t length = ESP32_GIF_Prerendered::encodeRow(src, rowBytes, unitBytes, packed.data());
+                    put16(record, length);
+                    record.insert(record.end(), packed.begin(), packed.begin() + length);
+                } else {
+                    record.insert(record.end(), src, src + rowBytes);
+                }
+            }
+            records.push_back(record);
+            canvases.emplace_back(canvas, canvas + stride * height);
+        }
+        if (records.empty()) {
+            error = ESP32_AnimatedGIF::getErrorMessage(gif.getLastError());
+            return false;
+        }
+
+        out.clear();
+        out.insert(out.end(), { 'G', 'I', 'F', 'R' });
+        out.push_back(ESP32_GIF_PRERENDERED_VERSION);
+        out.push_back((uint8_t)options.format);
+        out.push_back(options.rle ? ESP32_GIF_PRERENDERED_RLE : 0);
+        out.push_back(0);
+        put16(out, width);
+        put16(out, height);
+        put16(out, records.size());
+        put16(out, 0);
+        put32(out, totalDuration);
+        put32(out, ESP32_GIF_PRERENDERED_HEADER_SIZE);
+
+        size_t table = out.size();
+        out.resize(table + (records.size() + 1) * 4);
+        for (size_t i = 0; i < records.size(); i++) {
+            set32(out, table + i * 4, out.size());
+            out.insert(out.end(), records[i].begin(), records[i].end());
+        }
+        set32(out, table + records.size() * 4, out.size());
+        return true;
+    }
+
+    bool verify(const std::vector<uint8_t>& data, const Options& options,
+                const std::vector<std::vector<uint8_t>>& canvases, std::string& error) {
+        // The pre-rendered canvas must match the GIF canvas after every frame
+        ESP32_AnimatedGIF player;
+        player.begin(options.format, false);
+        player.setLoop(false);
+        if (player.loadPrerenderedFromMemory(data.data(), data.size()) != GIFError::SUCCESS) {
+            error = std::string("cannot load the output: ") +
+                    ESP32_AnimatedGIF::getErrorMessage(player.getLastError());
+            return false;
+        }
+        for (size_t i = 0; i < canvases.size(); i++) {
+            if (player.nextFrame(false) != GIFError::SUCCESS) {
+                error = "output frame " + std::to_string(i) + ": " +
+                        ESP32_AnimatedGIF::getErrorMessage(player.getLastError());
+                return false;
+            }
+            if (memcmp(player.getFrameBuffer(), canvases[i].data(), canvases[i].size()) != 0) {
+                error = "output frame " + std::to_string(i) + " differs from the GIF";
+                return false;
+            }
+        }
+        if (player.nextFrame(false) != GIFError::EMPTY_FRAME) {
+            error = "output has more frames than the GIF";
+            return false;
+        }
+        return true;
+    }
+
+    void frameSink(void*, uint16_t, uint16_t, uint16_t, uint16_t, const uint8_t*) {
+    }
+
+    double measureLoop(const std::vector<uint8_t>& data, const Options& options, bool prerendered) {
+        // Median of a few frame callback passes, microseconds
+        std::vector<double> times;
+        for (int run = 0; run < 5; run++) {
+            ESP32_AnimatedGIF gif;
+            gif.begin(options.format, false);
+            gif.setDither(options.dither);
+            gif.setLoop(false);
+            gif.setFrameCallback(frameSink);
+            GIFError loaded = prerendered ? gif.loadPrerenderedFromMemory(data.data(), data.size())
+                                          : gif.loadFromMemory(data.data(), data.size());
+            if (loaded != GIFError::SUCCESS) return 0;
+            auto start = std::chrono::steady_clock::now();
+            while (gif.nextFrame(false) == GIFError::SUCCESS) {
+            }
+            times.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+
+    void usage() {
+        fprintf(stderr,
+                "usage: gifprerender [--format FORMAT] [--dither MODE] [--rle] [--out DIR] [--filter TEXT]\n"
+                "                    [--corpus SET] [file.gif|dir ...]\n"
+                "  --format FORMAT  pixel format of the display (default RGB565_LE, not INDEXED8)\n"
+                "  --dither MODE    none (default) or ordered, for the reduced-depth formats\n"
+                "  --rle            run-length code the rows\n"
+                "  --out DIR        write name.gifr files for loadPrerendered()\n"
+                "  --filter TEXT    only files whose name contains TEXT\n"
+                "  --corpus SET     generated corpus when no files are given: bench (default) or sweep\n"
+                "Without --out the files are only converted, verified and timed.\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    const char* outDir = nullptr;
+    const char* filter = nullptr;
+    std::string corpusName = "bench";
+    std::vector<GifFile> files;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--format") == 0 && hasValue) {
+            if (!parsePixelFormat(argv[++i], options.format) || options.format == PixelFormat::INDEXED8) {
+                fprintf(stderr, "gifprerender: unsupported pixel format %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--dither") == 0 && hasValue) {
+            if (!parseDitherMode(argv[++i], options.dither)) {
+                fprintf(stderr, "gifprerender: unknown dither mode %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--rle") == 0) {
+            options.rle = true;
+        } else if (strcmp(argv[i], "--out") == 0 && hasValue) {
+            outDir = argv[++i];
+        } else if (strcmp(argv[i], "--filter") == 0 && hasValue) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--corpus") == 0 && hasValue) {
+            corpusName = argv[++i];
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else if (!addGifPath(files, argv[i], "gifprerender")) {
+            return 2;
+        }
+    }
+    if (files.empty() && !addCorpusSet(files, corpusName, "gifprerender")) {
+        return 2;
+    }
+
+    printf("%-24s %7s %10s %10s %12s %12s %8s\n", "file", "frames", "gif_bytes", "out_bytes", "gif_loop_ms",
+           "out_loop_ms", "speedup");
+    int status = 0;
+    for (const GifFile& file : files) {
+        if (filter && file.name.find(filter) == std::string::npos) continue;
+
+        std::vector<uint8_t> output;
+        std::vector<std::vector<uint8_t>> canvases;
+        std::string error;
+        if (!convert(file.data, options, output, canvases, error) || !verify(output, options, canvases, error)) {
+            fprintf(stderr, "gifprerender: %s: %s\n", file.name.c_str(), error.c_str());
+            status = 1;
+            continue;
+        }
+
+        double gifLoop = measureLoop(file.data, options, false);
+        double outLoop = measureLoop(output, options, true);
+        printf("%-24s %7u %10u %10u %12.2f %12.2f %7.1fx\n", file.name.c_str(), (unsigned)canvases.size(),
+               (unsigned)file.data.size(), (unsigned)output.size(), gifLoop / 1000.0, outLoop / 1000.0,
+               outLoop > 0 ? gifLoop / outLoop : 0.0);
+
+        if (outDir && !writeFile(outputPath(outDir, file.name, ".gifr"), output)) {
+            fprintf(stderr, "gifprerender: cannot write %s to %s\n", file.name.c_str(), outDir);
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,398 @@
+/**
+ * @file gifsim.cpp
+ * @brief Virtual-clock playback simulator
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Plays every corpus file through the real decoder and its scheduling code
+ * (nextFrame() delays, the minimum delay clamp, loops, pacing) with the
+ * platform clock replaced by a virtual one. Time only advances when the
+ * decoder sleeps or when a synthetic stage cost is charged:
+ *
+ *   io       per DataReader call: latency + bytes / bandwidth
+ *   decode   per compressed byte read while playing, per pixel of each span
+ *   display  per FrameCallback span and per pixel of the span
+ *
+ * so an hour of playback replays in seconds and always gives the same
+ * result. With --instances N, N decoders of the same file are layers of one
+ * ESP32_GIF_Compositor side by side, driven by tick() on the virtual
+ * millisecond clock; the loop ticks again at once after a push and sleeps
+ * 1 ms otherwise, and display costs are charged per composed row.
+ *
+ * Per file it reports the achieved against the nominal frame rate, the
+ * presentation error percentiles and the deadline misses by cause; the
+ * timeline of every presented frame can be written as CSV, with times in
+ * 64-bit virtual microseconds. --expect-frames and --expect-misses make
+ * the run fail unless every file played exactly that many frames and misses.
+ *
+ *   gifsim [--duration S] [--instances N] [--tolerance MS] [--timeline PATH]
+ *          [--io-latency US] [--io-bandwidth MBPS] [--decode-pixel NS] [--decode-byte NS]
+ *          [--display-span US] [--display-pixel NS] [--filter TEXT] [--corpus SET]
+ *          [--expect-frames N] [--expect-misses N] [file.gif|dir ...]
+ */
+
+#include "ESP32_AnimatedGIF.h"
+#include "ESP32_GIF_Compositor.h"
+#include "GifFiles.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+    // Synthetic stage costs
+    struct Costs {
+        double ioLatencyUs = 100;       // Per reader call
+        double ioBandwidth = 4;         // MB/s (bytes per microsecond)
+        double decodePixelNs = 20;      // Per pixel of a span
+        double decodeByteNs = 100;      // Per compressed byte read while playing
+        double displaySpanUs = 2;       // Per span (window setup)
+        double displayPixelNs = 400;    // Per pixel (RGB565 over 40 MHz SPI)
+    };
+
+    struct VirtualClock {
+        uint64_t nanos;
+    };
+
+    uint64_t clockMicros(void* userData) {
+        return ((VirtualClock*)userData)->nanos / 1000;
+    }
+
+    void clockSleep(void* userData, uint32_t ms) {
+        ((VirtualClock*)userData)->nanos += (uint64_t)ms * 1000000;
+    }
+
+    // Current virtual millis for ESP32_GIF_Compositor::tick()
+    uint32_t clockMillis(const VirtualClock& clock) {
+        return (uint32_t)(clock.nanos / 1000000);
+    }
+
+    // 64-bit virtual micros of a 32-bit platform timestamp at most half a
+    // wrap before now
+    uint64_t unwrapMicros(const VirtualClock& clock, uint32_t micros) {
+        uint64_t now = clock.nanos / 1000;
+        return now - (uint32_t)((uint32_t)now - micros);
+    }
+
+    struct Instance {
+        ESP32_AnimatedGIF gif;
+        const GifFile* file;
+        VirtualClock* clock;
+        const Costs* costs;
+        bool playing;               // Loaded, reads are image data
+        uint32_t frames;            // Pacing frames already recorded
+        // Costs charged during the current frame
+        double ioNs;
+        double decodeNs;
+        double displayNs;
+    };
+
+    // Compositor output, --instances only
+    struct Screen {
+        VirtualClock* clock;
+        const Costs* costs;
+        double displayNs;           // Charged during the current tick
+    };
+
+    void charge(VirtualClock& clock, double& stage, double ns) {
+        stage += ns;
+        clock.nanos += (uint64_t)ns;
+    }
+
+    bool simReader(void* userData, uint8_t* buffer, uint32_t length, uint32_t position) {
+        Instance& instance = *(Instance*)userData;
+        const std::vector<uint8_t>& data = instance.file->data;
+        if ((uint64_t)position + length > data.size()) return false;
+        memcpy(buffer, data.data() + position, length);
+
+        const Costs& costs = *instance.costs;
+        charge(*instance.clock, instance.ioNs, costs.ioLatencyUs * 1000 + length * 1000.0 / costs.ioBandwidth);
+        if (instance.playing) {
+            charge(*instance.clock, instance.decodeNs, length * costs.decodeByteNs);
+        }
+        return true;
+    }
+
+    void simDisplay(void* userData, uint16_t, uint16_t, uint16_t width, uint16_t height, const uint8_t*) {
+        Instance& instance = *(Instance*)userData;
+        const Costs& costs = *instance.costs;
+        uint32_t pixels = (uint32_t)width * height;
+        charge(*instance.clock, instance.decodeNs, pixels * costs.decodePixelNs);
+        charge(*instance.clock, instance.displayNs, costs.displaySpanUs * 1000 + pixels * costs.displayPixelNs);
+    }
+
+    // Layer spans only cost decode time, the compositor pushes the rows
+    void simDecode(void* userData, uint16_t, uint16_t, uint16_t width, uint16_t height, const uint8_t*) {
+        Instance& instance = *(Instance*)userData;
+        charge(*instance.clock, instance.decodeNs, (uint32_t)width * height * instance.costs->decodePixelNs);
+    }
+
+    void simPush(void* userData, uint16_t, uint16_t, uint16_t width, uint16_t height, const uint8_t*) {
+        Screen& screen = *(Screen*)userData;
+        const Costs& costs = *screen.costs;
+        charge(*screen.clock, screen.displayNs,
+               costs.displaySpanUs * 1000 + (uint32_t)width * height * costs.displayPixelNs);
+    }
+
+    struct Result {
+        uint32_t frames = 0;
+        uint64_t nominalMicros = 0;         // Sum of the frame delays played
+        std::vector<int32_t> errors;        // Presentation error per frame
+        PacingStats pacing;
+    };
+
+    double percentile(std::vector<int32_t>& values, double p) {
+        if (values.empty()) return 0;
+        size_t index = std::min(values.size() - 1, (size_t)(p * (values.size() - 1) + 0.5));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+
+    void addPacing(PacingStats& total, const PacingStats& stats) {
+        if (total.frames == 0 || stats.minErrorMicros < total.minErrorMicros) total.minErrorMicros = stats.minErrorMicros;
+        if (total.frames == 0 || stats.maxErrorMicros > total.maxErrorMicros) total.maxErrorMicros = stats.maxErrorMicros;
+        total.frames += stats.frames;
+        total.misses += stats.misses;
+        for (int i = 0; i < 5; i++) total.causes[i] += stats.causes[i];
+        total.totalErrorMicros += stats.totalErrorMicros;
+        for (int i = 0; i < ESP32_ANIMATEDGIF_PACING_BUCKETS; i++) total.histogram[i] += stats.histogram[i];
+    }
+
+    // Records the frame an instance presented since the last call, if any
+    void recordFrame(const GifFile& file, Instance& instance, uint32_t index, double displayNs,
+                     FILE* timeline, Result& result) {
+        PacingStats pacing;
+        instance.gif.getPacingStats(pacing);
+        if (pacing.frames == instance.frames) return;
+        instance.frames = pacing.frames;
+
+        FrameInfo info;
+        instance.gif.getFrameInfo(info);
+        int32_t error = (int32_t)(pacing.lastPresented - pacing.lastScheduled);
+        result.frames++;
+        result.nominalMicros += (uint64_t)info.delay * 1000;
+        result.errors.push_back(error);
+
+        if (timeline) {
+            uint64_t presented = unwrapMicros(*instance.clock, pacing.lastPresented);
+            fprintf(timeline, "%s,%u,%u,%llu,%llu,%d,%u,%.0f,%.0f,%.0f\n", file.name.c_str(),
+                    (unsigned)index, (unsigned)(instance.gif.getCurrentFrame() - 1),
+                    (unsigned long long)(presented - error), (unsigned long long)presented, (int)error,
+                    (unsigned)info.delay, instance.ioNs / 1000, instance.decodeNs / 1000, displayNs / 1000);
+        }
+        instance.ioNs = instance.decodeNs = instance.displayNs = 0;
+    }
+
+    bool simulate(const GifFile& file, const Costs& costs, uint32_t instanceCount, uint16_t tolerance,
+                  double duration, FILE* timeline, Result& result) {
+        VirtualClock clock = { 0 };
+        ESP32_GIF_Clock platformClock = { clockMicros, clockSleep, &clock };
+        ESP32_GIF_Platform::setClock(&platformClock);
+
+        // Several instances are layers side by side, added before loading
+        ESP32_GIF_Compositor compositor;
+        Screen screen = { &clock, &costs, 0 };
+        bool layered = instanceCount > 1;
+        // Logical screen size from the header, a short file fails to load
+        const std::vector<uint8_t>& data = file.data;
+        uint16_t width = data.size() >= 10 ? data[6] | data[7] << 8 : 0;
+        uint16_t height = data.size() >= 10 ? data[8] | data[9] << 8 : 0;
+        if (layered) {
+            uint32_t regionWidth = std::max<uint32_t>(width, 1) * instanceCount;
+            compositor.begin((uint16_t)std::min<uint32_t>(regionWidth, 0xFFFF), std::max<uint16_t>(height, 1));
+            compositor.setOutput(simPush, &screen);
+        }
+
+        std::vector<Instance> instances(instanceCount);
+        bool loaded = true;
+        for (uint32_t i = 0; i < instanceCount && loaded; i++) {
+            Instance& instance = instances[i];
+            instance.file = &file;
+            instance.clock = &clock;
+            instance.costs = &costs;
+            instance.playing = false;
+            instance.frames = 0;
+            instance.ioNs = instance.decodeNs = instance.displayNs = 0;
+            instance.gif.begin(PixelFormat::RGB565_LE, false);
+            instance.gif.setPacingTolerance(tolerance);
+            if (layered) {
+                instance.gif.setFrameCallback(simDecode, &instance);
+                loaded = compositor.addLayer(&instance.gif, (int16_t)(i * width), 0) >= 0;
+            } else {
+                instance.gif.setFrameCallback(simDisplay, &instance);
+            }
+            loaded = loaded && instance.gif.load(simReader, &instance) == GIFError::SUCCESS;
+            instance.playing = true;
+        }
+
+        uint64_t end = clock.nanos / 1000 + (uint64_t)(duration * 1e6);
+        while (loaded && clock.nanos / 1000 < end) {
+            if (!layered) {
+                if (instances[0].gif.nextFrame(true) != GIFError::SUCCESS) {
+                    loaded = false;
+                    break;
+                }
+                recordFrame(file, instances[0], 0, instances[0].displayNs, timeline, result);
+                continue;
+            }
+
+            // An application loop: tick again at once after a push, else
+            // sleep a millisecond
+            screen.displayNs = 0;
+            bool pushed = compositor.tick(clockMillis(clock));
+            for (uint32_t i = 0; i < instanceCount; i++) {
+                if (instances[i].gif.getLastError() != GIFError::SUCCESS) {
+                    loaded = false;
+                }
+                recordFrame(file, instances[i], i, screen.displayNs, timeline, result);
+            }
+            if (!pushed) {
+                clockSleep(&clock, 1);
+            }
+        }
+
+        memset(&result.pacing, 0, sizeof(result.pacing));
+        for (Instance& instance : instances) {
+            PacingStats pacing;
+            instance.gif.getPacingStats(pacing);
+            addPacing(result.pacing, pacing);
+        }
+        ESP32_GIF_Platform::setClock(nullptr);
+        return loaded;
+    }
+
+    void usage() {
+        fprintf(stderr,
+                "usage: gifsim [--duration S] [--instances N] [--tolerance MS] [--timeline PATH]\n"
+                "              [--io-latency US] [--io-bandwidth MBPS] [--decode-pixel NS] [--decode-byte NS]\n"
+                "              [--display-span US] [--display-pixel NS] [--filter TEXT] [--corpus SET]\n"
+                "              [--expect-frames N] [--expect-misses N] [file.gif|dir ...]\n"
+                "  --duration S       virtual playback time per file (default 600)\n"
+                "  --instances N      compositor layers playing the same file (default 1, max %d)\n"
+                "  --tolerance MS     pacing tolerance before a frame counts as missed (default 10)\n"
+                "  --timeline PATH    write every presented frame as CSV\n"
+                "  --io-latency US    cost per reader call (default 100)\n"
+                "  --io-bandwidth MBPS reader bandwidth (default 4)\n"
+                "  --decode-pixel NS  decode cost per output pixel (default 20)\n"
+                "  --decode-byte NS   decode cost per compressed byte (default 100)\n"
+                "  --display-span US  display cost per span (default 2)\n"
+                "  --display-pixel NS display cost per pixel (default 400)\n"
+                "  --corpus SET       generated corpus when no files are given: bench (default) or sweep\n"
+                "  --expect-frames N  fail unless every file plays N frames\n"
+                "  --expect-misses N  fail unless every file misses N deadlines\n",
+                ESP32_GIF_COMPOSITOR_MAX_LAYERS);
+    }
+}
+
+int main(int argc, char** argv) {
+    Costs costs;
+    double duration = 600;
+    uint32_t instanceCount = 1;
+    uint16_t tolerance = 10;
+    const char* timelinePath = nullptr;
+    const char* filter = nullptr;
+    long expectFrames = -1;
+    long expectMisses = -1;
+    std::string corpusName = "bench";
+    std::vector<GifFile> files;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--duration") == 0 && hasValue) {
+            duration = std::max(0.001, atof(argv[++i]));
+        } else if (strcmp(argv[i], "--instances") == 0 && hasValue) {
+            instanceCount = std::min(std::max(1, atoi(argv[++i])), ESP32_GIF_COMPOSITOR_MAX_LAYERS);
+        } else if (strcmp(argv[i], "--tolerance") == 0 && hasValue) {
+            tolerance = (uint16_t)std::max(0, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--timeline") == 0 && hasValue) {
+            timelinePath = argv[++i];
+        } else if (strcmp(argv[i], "--io-latency") == 0 && hasValue) {
+            costs.ioLatencyUs = std::max(0.0, atof(argv[++i]));
+        } else if (strcmp(argv[i], "--io-bandwidth") == 0 && hasValue) {
+            costs.ioBandwidth = std::max(0.001, atof(argv[++i]));
+        } else if (strcmp(argv[i], "--decode-pixel") == 0 && hasValue) {
+            costs.decodePixelNs = std::max(0.0, atof(argv[++i]));
+        } else if (strcmp(argv[i], "--decode-byte") == 0 && hasValue) {
+            costs.decodeByteNs = std::max(0.0, atof(argv[++i]));
+        } else if (strcmp(argv[i], "--display-span") == 0 && hasValue) {
+            costs.displaySpanUs = std::max(0.0, atof(argv[++i]));
+        } else if (strcmp(argv[i], "--display-pixel") == 0 && hasValue) {
+            costs.displayPixelNs = std::max(0.0, atof(argv[++i]));
+        } else if (strcmp(argv[i], "--filter") == 0 && hasValue) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--corpus") == 0 && hasValue) {
+            corpusName = argv[++i];
+        } else if (strcmp(argv[i], "--expect-frames") == 0 && hasValue) {
+            expectFrames = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--expect-misses") == 0 && hasValue) {
+            expectMisses = atol(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else if (!addGifPath(files, argv[i], "gifsim")) {
+            return 2;
+        }
+    }
+    if (files.empty() && !addCorpusSet(files, corpusName, "gifsim")) {
+        return 2;
+    }
+
+    FILE* timeline = nullptr;
+    if (timelinePath) {
+        timeline = fopen(timelinePath, "w");
+        if (!timeline) {
+            fprintf(stderr, "gifsim: cannot write %s\n", timelinePath);
+            return 2;
+        }
+        fprintf(timeline, "file,instance,frame,scheduled_us,presented_us,error_us,delay_ms,io_us,decode_us,display_us\n");
+    }
+
+    printf("%-28s %8s %8s %8s %9s %9s %9s %9s %7s %s\n", "file", "frames", "fps", "nominal",
+           "p50_us", "p95_us", "p99_us", "max_us", "misses", "caller/io/decode/output/unknown");
+    int status = 0;
+    for (const GifFile& file : files) {
+        if (filter && file.name.find(filter) == std::string::npos) continue;
+
+        Result result;
+        auto start = std::chrono::steady_clock::now();
+        if (!simulate(file, costs, instanceCount, tolerance, duration, timeline, result)) {
+            fprintf(stderr, "gifsim: %s failed to play\n", file.name.c_str());
+            status = 1;
+            continue;
+        }
+        double realSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Frame rates per instance
+        double fps = result.frames / duration / instanceCount;
+        double nominal = result.nominalMicros ? result.frames * 1e6 / result.nominalMicros : 0;
+        const PacingStats& pacing = result.pacing;
+        printf("%-28s %8u %8.2f %8.2f %9.0f %9.0f %9.0f %9d %7u %u/%u/%u/%u/%u  (%.1fs real)\n",
+               file.name.c_str(), (unsigned)result.frames, fps, nominal,
+               percentile(result.errors, 0.50), percentile(result.errors, 0.95),
+               percentile(result.errors, 0.99), (int)pacing.maxErrorMicros, (unsigned)pacing.misses,
+               (unsigned)pacing.causes[(int)PacingCause::CALLER], (unsigned)pacing.causes[(int)PacingCause::IO],
+               (unsigned)pacing.causes[(int)PacingCause::DECODE], (unsigned)pacing.causes[(int)PacingCause::OUTPUT],
+               (unsigned)pacing.causes[(int)PacingCause::UNKNOWN], realSeconds);
+        if (expectFrames >= 0 && result.frames != (uint32_t)expectFrames) {
+            fprintf(stderr, "gifsim: %s played %u frames, expected %ld\n",
+                    file.name.c_str(), (unsigned)result.frames, expectFrames);
+            status = 1;
+        }
+        if (expectMisses >= 0 && pacing.misses != (uint32_t)expectMisses) {
+            fprintf(stderr, "gifsim: %s missed %u deadlines, expected %ld\n",
+                    file.name.c_str(), (unsigned)pacing.misses, expectMisses);
+            status = 1;
+        }
+    }
+
+    if (timeline) {
+        fclose(timeline);
+    }
+    return status;
+}
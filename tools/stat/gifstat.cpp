@@ -0,0 +1,416 @@
+/**
+ * @file gifstat.cpp
+ * @brief Decoder-relevant structure report of GIF files
+ * @author Deepseek
+ * @version 1.0.0
+ * @date 2024
+ *
+ * Prints what makes a GIF cheap or expensive to play, per file and
+ * optionally per frame:
+ *
+ *   layout     canvas size, frame count, frame rect coverage of the canvas,
+ *              interlaced frames, disposal methods
+ *   palettes   global size, local palettes and how many repeat an earlier
+ *              palette, palette entries actually used
+ *   pixels     share of transparent pixels in the frame rects
+ *   LZW        compressed bytes and sub-blocks per frame, codes, clear codes,
+ *              pixels per code, codes sent with a full table and the share of
+ *              codes at each code width
+ *   estimate   ESP32_AnimatedGIF::estimate() memory (reader and memory
+ *              source) and the predicted decode time of one loop
+ *
+ * Image data is decoded with the library's LZW decoder for the pixel
+ * counts; the code statistics come from a separate walk of the code stream.
+ * --sort ranks the files by predicted decode time to find the assets worth
+ * re-encoding. --cost takes the costs printed by gifbench --calibrate, so
+ * the prediction can describe the target device instead of this host.
+ *
+ *   gifstat [--frames] [--sort] [--cost US,NS_PIXEL,NS_BYTE] [--format FORMAT]
+ *           [--filter TEXT] [--corpus SET] [file.gif|dir ...]
+ */
+
+#include "ESP32_AnimatedGIF.h"
+#include "ESP32_GIF_LZW.h"
+#include "GifFiles.h"
+#include "GifScan.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct CodeStats {
+        uint32_t codes = 0;
+        uint32_t clears = 0;
+        uint32_t fullTableCodes = 0;    // Codes sent while the table was full (deferred clear)
+        uint32_t widths[13] = {};       // Codes per code width in bits
+        bool endCode = false;
+    };
+
+    struct FrameStats {
+        GifScanFrame frame;
+        uint32_t clippedPixels = 0;
+        uint32_t transparentPixels = 0;
+        uint16_t colorsUsed = 0;
+        bool repeatedPalette = false;   // Local palette equal to an earlier one
+        CodeStats codes;
+    };
+
+    struct FileStats {
+        std::string name;
+        GifScan scan;
+        std::vector<FrameStats> frames;
+        GIFEstimate estimate;
+        uint64_t framePixels = 0;       // Full frame rects, as decoded
+        uint64_t clippedPixels = 0;
+        uint64_t transparentPixels = 0;
+        uint64_t dataBytes = 0;
+        uint64_t subBlocks = 0;
+        uint64_t colorsUsed = 0;
+        uint32_t localPalettes = 0;
+        uint32_t repeatedPalettes = 0;
+        uint32_t interlaced = 0;
+        uint32_t disposals[4] = {};     // None/unspecified, keep, background, previous
+        uint32_t loopMicros = 0;        // Predicted decode time of one loop
+        CodeStats codes;
+    };
+
+    // -----------------------------------------------------------------------
+    // LZW code stream walk
+    // -----------------------------------------------------------------------
+
+    // Reads codes LSB first across the data sub-blocks
+    class CodeReader {
+    public:
+        CodeReader(const std::vector<uint8_t>& data, uint32_t position)
+            : _data(data), _position(position), _remaining(0), _bits(0), _bitCount(0) {
+        }
+
+        bool read(uint8_t size, uint16_t& code) {
+            while (_bitCount < size) {
+                if (_remaining == 0) {
+                    if (_position >= _data.size() || _data[_position] == 0) return false;
+                    _remaining = _data[_position++];
+                }
+                if (_position >= _data.size()) return false;
+                _bits |= (uint32_t)_data[_position++] << _bitCount;
+                _bitCount += 8;
+                _remaining--;
+            }
+            code = _bits & ((1u << size) - 1);
+            _bits >>= size;
+            _bitCount -= size;
+            return true;
+        }
+
+    private:
+        const std::vector<uint8_t>& _data;
+        size_t _position;
+        uint8_t _remaining;             // Bytes left in the current sub-block
+        uint32_t _bits;
+        uint8_t _bitCount;
+    };
+
+    void walkCodes(const std::vector<uint8_t>& data, const GifScanFrame& frame, CodeStats& stats) {
+        // Same table growth as ESP32_GIF_LZW, without building strings
+        if (frame.minCodeSize < 1 || frame.minCodeSize > 8) return;
+        const uint16_t clearCode = 1 << frame.minCodeSize;
+        const uint16_t endCode = clearCode + 1;
+        uint8_t codeSize = frame.minCodeSize + 1;
+        uint16_t nextCode = clearCode + 2;
+        bool first = true;
+
+        CodeReader reader(data, frame.dataOffset);
+        uint16_t code;
+        while (reader.read(codeSize, code)) {
+            stats.codes++;
+            stats.widths[codeSize]++;
+            if (code == clearCode) {
+                stats.clears++;
+                codeSize = frame.minCodeSize + 1;
+                nextCode = clearCode + 2;
+                first = true;
+                continue;
+            }
+            if (code == endCode) {
+                stats.endCode = true;
+                break;
+            }
+            if (first) {
+                first = false;
+                continue;
+            }
+            if (nextCode < ESP32_GIF_LZW_MAX_CODES) {
+                nextCode++;
+                if (nextCode == (1u << codeSize) && codeSize < 12) {
+                    codeSize++;
+                }
+            } else {
+                stats.fullTableCodes++;
+            }
+        }
+    }
+
+    void addCodes(CodeStats& total, const CodeStats& frame) {
+        total.codes += frame.codes;
+        total.clears += frame.clears;
+        total.fullTableCodes += frame.fullTableCodes;
+        for (int width = 0; width <= 12; width++) {
+            total.widths[width] += frame.widths[width];
+        }
+    }
+
+    // -----------------------------------------------------------------------
+    // Analysis
+    // -----------------------------------------------------------------------
+
+    const std::vector<uint8_t>* lzwSource = nullptr;
+
+    bool readSource(void*, uint8_t* buffer, uint32_t length, uint32_t position) {
+        if ((uint64_t)position + length > lzwSource->size()) return false;
+        memcpy(buffer, lzwSource->data() + position, length);
+        return true;
+    }
+
+    bool analyze(const GifFile& file, PixelFormat format, const GIFCalibration& calibration, FileStats& stats) {
+        stats.name = file.name;
+        const std::vector<uint8_t>& data = file.data;
+        if (!scanGif(data.data(), data.size(), stats.scan) && stats.scan.frames.empty()) return false;
+
+        ESP32_AnimatedGIF gif;
+        gif.begin(format, false);
+        if (gif.estimateFromMemory(data.data(), data.size(), stats.estimate, &calibration) != GIFError::SUCCESS) {
+            return false;
+        }
+        stats.loopMicros = stats.estimate.averageFrameMicros * stats.estimate.frameCount;
+
+        // Earlier palettes, for repeated local palettes
+        std::vector<std::vector<uint8_t>> palettes;
+        if (stats.scan.globalColors) {
+            palettes.emplace_back(data.begin() + 13, data.begin() + 13 + stats.scan.globalColors * 3);
+        }
+
+        ESP32_GIF_LZW lzw;
+        std::vector<uint8_t> pixels;
+        lzwSource = &data;
+        for (const GifScanFrame& frame : stats.scan.frames) {
+            FrameStats frameStats;
+            frameStats.frame = frame;
+
+            uint16_t width = stats.scan.width;
+            uint16_t height = stats.scan.height;
+            if (frame.x < width && frame.y < height) {
+                frameStats.clippedPixels = (uint32_t)std::min<uint32_t>(frame.width, width - frame.x) *
+                                           std::min<uint32_t>(frame.height, height - frame.y);
+            }
+
+            if (frame.localColors) {
+                // The local table ends at the LZW code size byte
+                uint32_t tableBytes = frame.localColors * 3;
+                std::vector<uint8_t> table(data.begin() + frame.dataOffset - 1 - tableBytes,
+                                           data.begin() + frame.dataOffset - 1);
+                frameStats.repeatedPalette = std::find(palettes.begin(), palettes.end(), table) != palettes.end();
+                if (!frameStats.repeatedPalette) palettes.push_back(table);
+                stats.localPalettes++;
+                stats.repeatedPalettes += frameStats.repeatedPalette;
+            }
+
+            // Transparent pixels and palette entries of the whole frame rect
+            size_t count = (size_t)frame.width * frame.height;
+            pixels.assign(count, 0);
+            uint32_t decoded = 0;
+            if (lzw.begin(frame.minCodeSize, readSource, nullptr, frame.dataOffset)) {
+                decoded = lzw.read(pixels.data(), count);
+            }
+            bool used[256] = {};
+            for (uint32_t i = 0; i < decoded; i++) {
+                used[pixels[i]] = true;
+                if (pixels[i] == frame.transparentIndex) frameStats.transparentPixels++;
+            }
+            for (bool entry : used) {
+                frameStats.colorsUsed += entry;
+            }
+
+            walkCodes(data, frame, frameStats.codes);
+
+            stats.framePixels += count;
+            stats.clippedPixels += frameStats.clippedPixels;
+            stats.transparentPixels += frameStats.transparentPixels;
+            stats.dataBytes += frame.dataBytes;
+            stats.subBlocks += frame.subBlocks;
+            stats.colorsUsed += frameStats.colorsUsed;
+            stats.interlaced += frame.interlaced;
+            stats.disposals[std::min<uint8_t>(frame.disposal, 3)]++;
+            addCodes(stats.codes, frameStats.codes);
+            stats.frames.push_back(frameStats);
+        }
+        return true;
+    }
+
+    // -----------------------------------------------------------------------
+    // Report
+    // -----------------------------------------------------------------------
+
+    double percent(uint64_t part, uint64_t whole) {
+        return whole ? 100.0 * part / whole : 0.0;
+    }
+
+    std::string widthShares(const CodeStats& codes) {
+        std::string shares;
+        for (int width = 2; width <= 12; width++) {
+            if (!codes.widths[width]) continue;
+            char entry[24];
+            snprintf(entry, sizeof(entry), "%s%d:%.0f%%", shares.empty() ? "" : " ", width,
+                     percent(codes.widths[width], codes.codes));
+            shares += entry;
+        }
+        return shares;
+    }
+
+    void printHeader() {
+        printf("%-24s %9s %6s %6s %6s %9s %7s %6s %11s %4s %8s %6s %6s %6s %6s %8s %8s %8s  %s\n",
+               "file", "canvas", "frames", "cover", "global", "local/rep", "colors", "transp", "disp n/k/b/p",
+               "intl", "lzw_B/f", "blk/f", "px/cd", "clr/f", "full", "rd_KB", "mem_KB", "loop_ms", "code widths");
+    }
+
+    void printFile(const FileStats& stats) {
+        uint32_t frames = stats.frames.size();
+        uint64_t canvas = (uint64_t)stats.scan.width * stats.scan.height;
+        char size[16];
+        char palettes[16];
+        char disposals[24];
+        snprintf(size, sizeof(size), "%ux%u", stats.scan.width, stats.scan.height);
+        snprintf(palettes, sizeof(palettes), "%u/%u", (unsigned)stats.localPalettes, (unsigned)stats.repeatedPalettes);
+        snprintf(disposals, sizeof(disposals), "%u/%u/%u/%u", (unsigned)stats.disposals[0],
+                 (unsigned)stats.disposals[1], (unsigned)stats.disposals[2], (unsigned)stats.disposals[3]);
+        uint64_t literalCodes = stats.codes.codes - stats.codes.clears - (stats.codes.endCode ? 1 : 0);
+        printf("%-24s %9s %6u %5.0f%% %6u %9s %7.0f %5.1f%% %11s %4u %8.0f %6.1f %6.2f %6.1f %6u %8.1f %8.1f %8.2f  %s\n",
+               stats.name.c_str(), size, (unsigned)frames,
+               frames ? percent(stats.clippedPixels, canvas * frames) : 0.0, (unsigned)stats.scan.globalColors,
+               palettes, frames ? (double)stats.colorsUsed / frames : 0.0,
+               percent(stats.transparentPixels, stats.framePixels), disposals, (unsigned)stats.interlaced,
+               frames ? (double)stats.dataBytes / frames : 0.0, frames ? (double)stats.subBlocks / frames : 0.0,
+               literalCodes ? (double)stats.framePixels / literalCodes : 0.0,
+               frames ? (double)stats.codes.clears / frames : 0.0, (unsigned)stats.codes.fullTableCodes,
+               stats.estimate.memoryFromReader / 1024.0, stats.estimate.memoryFromMemory / 1024.0,
+               stats.loopMicros / 1000.0, widthShares(stats.codes).c_str());
+    }
+
+    void printFrames(const FileStats& stats) {
+        static const char* disposalNames[] = { "none", "keep", "bg", "prev" };
+        printf("  %5s %19s %6s %6s %7s %6s %6s %5s %4s %8s %6s %7s %6s %6s  %s\n", "frame", "rect", "cover",
+               "local", "colors", "transp", "delay", "disp", "intl", "lzw_B", "blocks", "codes", "px/cd", "clears",
+               "code widths");
+        uint64_t canvas = (uint64_t)stats.scan.width * stats.scan.height;
+        for (size_t i = 0; i < stats.frames.size(); i++) {
+            const FrameStats& frameStats = stats.frames[i];
+            const GifScanFrame& frame = frameStats.frame;
+            char rect[24];
+            char local[12];
+            snprintf(rect, sizeof(rect), "%u,%u %ux%u", frame.x, frame.y, frame.width, frame.height);
+            snprintf(local, sizeof(local), "%u%s", frame.localColors, frameStats.repeatedPalette ? "r" : "");
+            const CodeStats& codes = frameStats.codes;
+            uint32_t literalCodes = codes.codes - codes.clears - (codes.endCode ? 1 : 0);
+            printf("  %5u %19s %5.0f%% %6s %7u %5.1f%% %6u %5s %4s %8u %6u %7u %6.2f %6u  %s\n", (unsigned)i, rect,
+                   percent(frameStats.clippedPixels, canvas), frame.localColors ? local : "-",
+                   (unsigned)frameStats.colorsUsed,
+                   percent(frameStats.transparentPixels, (uint64_t)frame.width * frame.height),
+                   (unsigned)frame.delay * 10, disposalNames[std::min<uint8_t>(frame.disposal, 3)],
+                   frame.interlaced ? "yes" : "-", (unsigned)frame.dataBytes, (unsigned)frame.subBlocks,
+                   (unsigned)codes.codes,
+                   literalCodes ? (double)frame.width * frame.height / literalCodes : 0.0, (unsigned)codes.clears,
+                   widthShares(codes).c_str());
+        }
+    }
+
+    void usage() {
+        fprintf(stderr,
+                "usage: gifstat [--frames] [--sort] [--cost US,NS_PIXEL,NS_BYTE] [--format FORMAT]\n"
+                "               [--filter TEXT] [--corpus SET] [file.gif|dir ...]\n"
+                "  --frames         print every frame under its file\n"
+                "  --sort           most expensive file (predicted loop time) first\n"
+                "  --cost C         per frame, pixel and byte costs from gifbench --calibrate\n"
+                "                   (default 20,10,10: RGB565 frame output on a desktop host)\n"
+                "  --format FORMAT  pixel format for the memory estimate (default RGB565_LE)\n"
+                "  --filter TEXT    only files whose name contains TEXT\n"
+                "  --corpus SET     generated corpus when no files are given: bench (default) or sweep\n"
+                "Columns: cover = clipped frame area / canvas, local/rep = local palettes / repeats of\n"
+                "an earlier palette, colors = palette entries used per frame, transp = transparent share\n"
+                "of the frame rects, disp = none/keep/background/previous, px/cd = pixels per LZW code,\n"
+                "clr/f = clear codes per frame, full = codes sent with a full table, rd_KB / mem_KB =\n"
+                "estimate() peak memory with a DataReader / loadFromMemory().\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    bool frames = false;
+    bool sort = false;
+    GIFCalibration calibration = { 20.0f, 10.0f, 10.0f };
+    PixelFormat format = PixelFormat::RGB565_LE;
+    const char* filter = nullptr;
+    std::string corpusName = "bench";
+    std::vector<GifFile> files;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--frames") == 0) {
+            frames = true;
+        } else if (strcmp(argv[i], "--sort") == 0) {
+            sort = true;
+        } else if (strcmp(argv[i], "--cost") == 0 && hasValue) {
+            if (!parseCalibration(argv[++i], calibration)) {
+                fprintf(stderr, "gifstat: --cost needs US,NS_PIXEL,NS_BYTE\n");
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--format") == 0 && hasValue) {
+            if (!parsePixelFormat(argv[++i], format)) {
+                fprintf(stderr, "gifstat: unknown pixel format %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--filter") == 0 && hasValue) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--corpus") == 0 && hasValue) {
+            corpusName = argv[++i];
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else if (!addGifPath(files, argv[i], "gifstat")) {
+            return 2;
+        }
+    }
+    if (files.empty() && !addCorpusSet(files, corpusName, "gifstat")) {
+        return 2;
+    }
+
+    std::vector<FileStats> results;
+    int status = 0;
+    for (const GifFile& file : files) {
+        if (filter && file.name.find(filter) == std::string::npos) continue;
+
+        FileStats stats;
+        if (!analyze(file, format, calibration, stats)) {
+            fprintf(stderr, "gifstat: %s is not a readable GIF\n", file.name.c_str());
+            status = 1;
+            continue;
+        }
+        results.push_back(stats);
+    }
+    if (sort) {
+        std::stable_sort(results.begin(), results.end(), [](const FileStats& a, const FileStats& b) {
+            return a.loopMicros > b.loopMicros;
+        });
+    }
+
+    printHeader();
+    for (const FileStats& stats : results) {
+        printFile(stats);
+        if (frames) {
+            printFrames(stats);
+        }
+    }
+    return status;
+}